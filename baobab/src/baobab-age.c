@@ -0,0 +1,155 @@
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <string.h>
+
+#include "baobab-age.h"
+
+#define DAY_SECONDS (24 * 60 * 60)
+
+/* upper bound (exclusive) of each bucket but the last one, in seconds */
+static const guint64 bucket_limits[BAOBAB_AGE_BUCKETS - 1] = {
+    DAY_SECONDS,       7 * DAY_SECONDS,   30 * DAY_SECONDS,
+    91 * DAY_SECONDS,  365 * DAY_SECONDS, 2 * 365 * DAY_SECONDS,
+    5 * 365 * DAY_SECONDS,
+};
+
+static const gchar *bucket_labels[BAOBAB_AGE_BUCKETS] = {
+    N_("Less than a day"),  N_("Less than a week"),
+    N_("Less than a month"), N_("Less than 3 months"),
+    N_("Less than a year"),  N_("Less than 2 years"),
+    N_("Less than 5 years"), N_("Older"),
+};
+
+G_DEFINE_BOXED_TYPE(BaobabAgeHistogram, baobab_age_histogram,
+                    baobab_age_histogram_copy, baobab_age_histogram_free)
+
+BaobabAgeHistogram *baobab_age_histogram_copy(const BaobabAgeHistogram *hist) {
+  return g_slice_dup(BaobabAgeHistogram, hist);
+}
+
+void baobab_age_histogram_free(BaobabAgeHistogram *hist) {
+  g_slice_free(BaobabAgeHistogram, hist);
+}
+
+void baobab_age_histogram_clear(BaobabAgeHistogram *hist) {
+  memset(hist, 0, sizeof(BaobabAgeHistogram));
+}
+
+static guint age_to_bucket(guint64 now, guint64 time) {
+  guint64 age;
+  guint i;
+
+  /* timestamps in the future count as fresh */
+  age = (now > time) ? now - time : 0;
+
+  for (i = 0; i < G_N_ELEMENTS(bucket_limits); i++) {
+    if (age < bucket_limits[i]) return i;
+  }
+
+  return BAOBAB_AGE_BUCKETS - 1;
+}
+
+void baobab_age_histogram_add_info(BaobabAgeHistogram *hist, GFileInfo *info,
+                                   guint64 size, guint64 now) {
+  guint64 time;
+
+  if (g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_TIME_MODIFIED)) {
+    time = g_file_info_get_attribute_uint64(info,
+                                            G_FILE_ATTRIBUTE_TIME_MODIFIED);
+    hist->mtime[age_to_bucket(now, time)] += size;
+  }
+
+  if (g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_TIME_ACCESS)) {
+    time = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_ACCESS);
+    hist->atime[age_to_bucket(now, time)] += size;
+    hist->has_atime = TRUE;
+  }
+}
+
+void baobab_age_histogram_merge(BaobabAgeHistogram *hist,
+                                const BaobabAgeHistogram *other) {
+  guint i;
+
+  for (i = 0; i < BAOBAB_AGE_BUCKETS; i++) {
+    hist->mtime[i] += other->mtime[i];
+    hist->atime[i] += other->atime[i];
+  }
+
+  hist->has_atime |= other->has_atime;
+}
+
+void baobab_age_histogram_subtract(BaobabAgeHistogram *hist,
+                                   const BaobabAgeHistogram *other) {
+  guint i;
+
+  for (i = 0; i < BAOBAB_AGE_BUCKETS; i++) {
+    hist->mtime[i] -= MIN(hist->mtime[i], other->mtime[i]);
+    hist->atime[i] -= MIN(hist->atime[i], other->atime[i]);
+  }
+}
+
+static void append_buckets(GString *str, const gchar *title,
+                           const guint64 *buckets) {
+  guint64 total = 0;
+  guint i;
+
+  for (i = 0; i < BAOBAB_AGE_BUCKETS; i++) total += buckets[i];
+
+  if (total == 0) return;
+
+  if (str->len > 0) g_string_append_c(str, '\n');
+
+  g_string_append_printf(str, "<b>%s</b>", title);
+
+  for (i = 0; i < BAOBAB_AGE_BUCKETS; i++) {
+    gchar *size;
+
+    if (buckets[i] == 0) continue;
+
+    size = g_format_size(buckets[i]);
+    g_string_append_printf(str, "\n%s: %s (%.1f %%)", _(bucket_labels[i]),
+                           size, ((gdouble)buckets[i] * 100) / (gdouble)total);
+    g_free(size);
+  }
+}
+
+/* returns NULL if there is nothing to show */
+gchar *baobab_age_histogram_to_markup(const BaobabAgeHistogram *hist) {
+  GString *str;
+
+  g_return_val_if_fail(hist != NULL, NULL);
+
+  str = g_string_new(NULL);
+
+  append_buckets(str, _("Last modified"), hist->mtime);
+  if (hist->has_atime) append_buckets(str, _("Last accessed"), hist->atime);
+
+  if (str->len == 0) {
+    g_string_free(str, TRUE);
+    return NULL;
+  }
+
+  return g_string_free(str, FALSE);
+}
@@ -0,0 +1,57 @@
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BAOBAB_AGE_H__
+#define __BAOBAB_AGE_H__
+
+#include <gio/gio.h>
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/* fixed age buckets: 1 day, 1 week, 1 month, 3 months, 1 year,
+ * 2 years, 5 years and everything older */
+#define BAOBAB_AGE_BUCKETS 8
+
+#define BAOBAB_TYPE_AGE_HISTOGRAM (baobab_age_histogram_get_type())
+
+typedef struct _BaobabAgeHistogram BaobabAgeHistogram;
+
+struct _BaobabAgeHistogram {
+  /* bytes, bucketed by last modification and last access */
+  guint64 mtime[BAOBAB_AGE_BUCKETS];
+  guint64 atime[BAOBAB_AGE_BUCKETS];
+  gboolean has_atime;
+};
+
+GType baobab_age_histogram_get_type(void);
+BaobabAgeHistogram *baobab_age_histogram_copy(const BaobabAgeHistogram *hist);
+void baobab_age_histogram_free(BaobabAgeHistogram *hist);
+
+void baobab_age_histogram_clear(BaobabAgeHistogram *hist);
+void baobab_age_histogram_add_info(BaobabAgeHistogram *hist, GFileInfo *info,
+                                   guint64 size, guint64 now);
+void baobab_age_histogram_merge(BaobabAgeHistogram *hist,
+                                const BaobabAgeHistogram *other);
+void baobab_age_histogram_subtract(BaobabAgeHistogram *hist,
+                                   const BaobabAgeHistogram *other);
+gchar *baobab_age_histogram_to_markup(const BaobabAgeHistogram *hist);
+
+G_END_DECLS
+
+#endif /* __BAOBAB_AGE_H__ */
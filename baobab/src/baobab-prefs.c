@@ -227,6 +227,8 @@ void baobab_prefs_dialog(void) {
   GtkBuilder *builder;
   GtkWidget *dlg;
   GtkWidget *check_enablehome;
+  GtkWidget *check_estimatefirst;
+  GtkWidget *check_breadthfirst;
   GtkListStore *model;
   GError *error = NULL;
 
@@ -263,6 +265,14 @@ void baobab_prefs_dialog(void) {
   g_settings_bind(baobab.prefs_settings, BAOBAB_SETTINGS_MONITOR_HOME,
                   check_enablehome, "active", G_SETTINGS_BIND_DEFAULT);
 
+  check_estimatefirst = GET_WIDGET("check_estimate_first");
+  g_settings_bind(baobab.prefs_settings, BAOBAB_SETTINGS_ESTIMATE_FIRST,
+                  check_estimatefirst, "active", G_SETTINGS_BIND_DEFAULT);
+
+  check_breadthfirst = GET_WIDGET("check_breadth_first");
+  g_settings_bind(baobab.prefs_settings, BAOBAB_SETTINGS_BREADTH_FIRST,
+                  check_breadthfirst, "active", G_SETTINGS_BIND_DEFAULT);
+
   g_signal_connect(dlg, "response", G_CALLBACK(filechooser_response_cb), model);
 
   gtk_widget_show_all(dlg);
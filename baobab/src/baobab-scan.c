@@ -24,8 +24,10 @@
 #include <gio/gio.h>
 #include <glib.h>
 #include <gtk/gtk.h>
+#include <math.h>
 #include <string.h>
 
+#include "baobab-age.h"
 #include "baobab-scan.h"
 #include "baobab-utils.h"
 #include "baobab.h"
@@ -113,13 +115,18 @@ struct allsizes {
   guint64 size;
   guint64 alloc_size;
   guint depth;
+  BaobabAgeHistogram age;
 };
 
+/* reference time for the age histograms, fixed for the whole scan */
+static guint64 scan_time = 0;
+
 static const char *dir_attributes = G_FILE_ATTRIBUTE_STANDARD_NAME
     "," G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME
     "," G_FILE_ATTRIBUTE_STANDARD_TYPE "," G_FILE_ATTRIBUTE_STANDARD_SIZE
     "," G_FILE_ATTRIBUTE_UNIX_BLOCKS "," G_FILE_ATTRIBUTE_UNIX_NLINK
     "," G_FILE_ATTRIBUTE_UNIX_INODE "," G_FILE_ATTRIBUTE_UNIX_DEVICE
+    "," G_FILE_ATTRIBUTE_TIME_MODIFIED "," G_FILE_ATTRIBUTE_TIME_ACCESS
     "," G_FILE_ATTRIBUTE_ACCESS_CAN_READ;
 
 static gboolean is_in_dot_gvfs(GFile *file) {
@@ -147,6 +154,19 @@ static gboolean is_in_dot_gvfs(GFile *file) {
   return res;
 }
 
+static gboolean is_skipped_folder(GFile *file) {
+  /* Skip the user excluded folders */
+  if (baobab_is_excluded_location(file)) return TRUE;
+
+  /* Skip the virtual file systems */
+  if (is_virtual_filesystem(file)) return TRUE;
+
+  /* FIXME: skip dirs in ~/.gvfs. It would be better to have a way
+   * to check if a file is a FUSE mountpoint instead of just
+   * hardcoding .gvfs */
+  return is_in_dot_gvfs(file);
+}
+
 static struct allsizes loopdir(GFile *file, GFileInfo *info, guint count,
                                BaobabHardLinkArray *hla, gint current_depth) {
   guint64 tempHLsize = 0;
@@ -164,17 +184,9 @@ static struct allsizes loopdir(GFile *file, GFileInfo *info, guint count,
   retloop.size = 0;
   retloop.alloc_size = 0;
   retloop.depth = 0;
+  baobab_age_histogram_clear(&retloop.age);
 
-  /* Skip the user excluded folders */
-  if (baobab_is_excluded_location(file)) goto exit;
-
-  /* Skip the virtual file systems */
-  if (is_virtual_filesystem(file)) goto exit;
-
-  /* FIXME: skip dirs in ~/.gvfs. It would be better to have a way
-   * to check if a file is a FUSE mountpoint instead of just
-   * hardcoding .gvfs */
-  if (is_in_dot_gvfs(file)) goto exit;
+  if (is_skipped_folder(file)) goto exit;
 
   parse_name = g_file_get_parse_name(file);
 
@@ -187,6 +199,8 @@ static struct allsizes loopdir(GFile *file, GFileInfo *info, guint count,
     retloop.alloc_size = BLOCK_SIZE * g_file_info_get_attribute_uint64(
                                           info, G_FILE_ATTRIBUTE_UNIX_BLOCKS);
 
+  baobab_age_histogram_add_info(&retloop.age, info, retloop.size, scan_time);
+
   if (g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME))
     display_name = g_strdup(g_file_info_get_display_name(info));
   else
@@ -214,6 +228,9 @@ static struct allsizes loopdir(GFile *file, GFileInfo *info, guint count,
   data.alloc_size = 1UL;
   data.depth = (gint)count - 1;
   data.elements = -1;
+  data.age = NULL;
+  data.estimated = FALSE;
+  data.estimate_error = 0.0;
   data.display_name = display_name;
   data.parse_name = parse_name;
   data.tempHLsize = tempHLsize;
@@ -236,6 +253,7 @@ static struct allsizes loopdir(GFile *file, GFileInfo *info, guint count,
       temp = loopdir(child_dir, temp_info, count, hla, current_depth + 1);
       retloop.size += temp.size;
       retloop.alloc_size += temp.alloc_size;
+      baobab_age_histogram_merge(&retloop.age, &temp.age);
       retloop.depth =
           ((temp.depth + 1) > retloop.depth) ? temp.depth + 1 : retloop.depth;
       elements++;
@@ -263,6 +281,8 @@ static struct allsizes loopdir(GFile *file, GFileInfo *info, guint count,
                              temp_info, G_FILE_ATTRIBUTE_UNIX_BLOCKS);
       }
       retloop.size += g_file_info_get_size(temp_info);
+      baobab_age_histogram_add_info(&retloop.age, temp_info,
+                                    g_file_info_get_size(temp_info), scan_time);
       elements++;
     }
 
@@ -283,6 +303,9 @@ static struct allsizes loopdir(GFile *file, GFileInfo *info, guint count,
   data.depth = (gint)count - 1;
   data.elements = elements;
   data.tempHLsize = tempHLsize;
+  data.age = &retloop.age;
+  data.estimated = FALSE;
+  data.estimate_error = 0.0;
   baobab_fill_model(&data);
   g_object_unref(file_enum);
 
@@ -295,6 +318,242 @@ exit:
   return retloop;
 }
 
+/*
+   Breadth-first mode.
+
+   Folders are scanned one level at a time: all the children of the
+   root are listed before any grandchild, and so on. The files of each
+   folder are added to the folder and to all of its ancestors as soon as
+   the folder is listed, so the top-level sizes are roughly right early
+   and converge while the scan goes deeper.
+
+   A node is kept alive until all of its subfolders are done, and holds
+   a reference on its parent meanwhile, so only the pending frontier of
+   the tree is in memory.
+*/
+
+typedef struct _ScanNode ScanNode;
+
+struct _ScanNode {
+  ScanNode *parent;
+  GFile *file;
+  GFileInfo *info;
+  GtkTreeIter iter;
+  gboolean has_row;
+  gint depth;
+  gint elements;
+  guint64 tempHLsize;
+  gchar *display_name;
+  gchar *parse_name;
+  struct allsizes sizes;
+  /* subfolders not done yet, plus one until the node itself is listed */
+  guint pending;
+};
+
+static ScanNode *scan_node_new(ScanNode *parent, GFile *file,
+                               GFileInfo *info) {
+  ScanNode *node;
+
+  node = g_slice_new0(ScanNode);
+  node->parent = parent;
+  node->file = g_object_ref(file);
+  node->info = g_object_ref(info);
+  node->depth = (parent != NULL) ? parent->depth + 1 : 0;
+  node->pending = 1;
+
+  if (parent != NULL) parent->pending++;
+
+  return node;
+}
+
+/* drops the reference held by a listed node or by a finished subfolder */
+static void scan_node_release(ScanNode *node) {
+  while (node != NULL && --node->pending == 0) {
+    ScanNode *parent = node->parent;
+
+    g_object_unref(node->file);
+    g_clear_object(&node->info);
+    g_free(node->display_name);
+    g_free(node->parse_name);
+    g_slice_free(ScanNode, node);
+
+    node = parent;
+  }
+}
+
+static void scan_node_fill(ScanNode *node) {
+  struct chan_data data;
+
+  data.display_name = node->display_name;
+  data.parse_name = node->parse_name;
+  data.size = node->sizes.size;
+  data.alloc_size = node->sizes.alloc_size;
+  data.depth = node->depth;
+  data.elements = node->elements;
+  data.tempHLsize = node->tempHLsize;
+  data.age = &node->sizes.age;
+  data.estimated = FALSE;
+  data.estimate_error = 0.0;
+  baobab_fill_model_at(&data, NULL, &node->iter);
+}
+
+/* adds the sizes to the node and its ancestors and updates their rows */
+static void scan_node_add_sizes(ScanNode *node, const struct allsizes *sizes) {
+  for (; node != NULL; node = node->parent) {
+    node->sizes.size += sizes->size;
+    node->sizes.alloc_size += sizes->alloc_size;
+    baobab_age_histogram_merge(&node->sizes.age, &sizes->age);
+
+    if (node->has_row) scan_node_fill(node);
+  }
+}
+
+/* lists one folder, returns its subfolders in the queue */
+static void scan_node_list(ScanNode *node, GQueue *queue,
+                           BaobabHardLinkArray *hla) {
+  struct allsizes sizes;
+  struct chan_data data;
+  GFileInfo *info = node->info;
+  GFileInfo *temp_info;
+  GFileEnumerator *file_enum;
+  GError *err = NULL;
+
+  sizes.size = 0;
+  sizes.alloc_size = 0;
+  sizes.depth = 0;
+  baobab_age_histogram_clear(&sizes.age);
+
+  node->parse_name = g_file_get_parse_name(node->file);
+
+  if (g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_STANDARD_SIZE))
+    sizes.size = (guint64)g_file_info_get_size(info);
+
+  if (g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_UNIX_BLOCKS))
+    sizes.alloc_size = BLOCK_SIZE * g_file_info_get_attribute_uint64(
+                                        info, G_FILE_ATTRIBUTE_UNIX_BLOCKS);
+
+  baobab_age_histogram_add_info(&sizes.age, info, sizes.size, scan_time);
+
+  if (g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME))
+    node->display_name = g_strdup(g_file_info_get_display_name(info));
+  else
+    /* paranoid fallback */
+    node->display_name =
+        g_filename_display_basename(g_file_info_get_name(info));
+
+  /* the info is not needed anymore, don't keep it for the whole level */
+  g_clear_object(&node->info);
+
+  file_enum = g_file_enumerate_children(node->file, dir_attributes,
+                                        G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                        NULL, &err);
+
+  if (file_enum == NULL) {
+    if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_PERMISSION_DENIED)) {
+      g_warning("couldn't get dir enum for dir %s: %s\n", node->parse_name,
+                err->message);
+    }
+    g_error_free(err);
+
+    /* like loopdir, the folder itself still counts for its parent */
+    scan_node_add_sizes(node->parent, &sizes);
+    return;
+  }
+
+  /* prefill the model */
+  data.size = 1UL;
+  data.alloc_size = 1UL;
+  data.depth = node->depth;
+  data.elements = -1;
+  data.age = NULL;
+  data.estimated = FALSE;
+  data.estimate_error = 0.0;
+  data.display_name = node->display_name;
+  data.parse_name = node->parse_name;
+  data.tempHLsize = 0;
+  baobab_fill_model_at(&data, node->parent ? &node->parent->iter : NULL,
+                       &node->iter);
+  node->has_row = TRUE;
+
+  while ((temp_info = g_file_enumerator_next_file(file_enum, NULL, &err)) !=
+         NULL) {
+    GFileType temp_type = g_file_info_get_file_type(temp_info);
+
+    if (baobab.STOP_SCANNING) {
+      g_object_unref(temp_info);
+      break;
+    }
+
+    if (temp_type == G_FILE_TYPE_DIRECTORY) {
+      GFile *child_dir =
+          g_file_get_child(node->file, g_file_info_get_name(temp_info));
+
+      if (!is_skipped_folder(child_dir))
+        g_queue_push_tail(queue, scan_node_new(node, child_dir, temp_info));
+
+      node->elements++;
+      g_object_unref(child_dir);
+    } else if (temp_type == G_FILE_TYPE_REGULAR) {
+      /* check for hard links only on local files */
+      if (g_file_info_has_attribute(temp_info, G_FILE_ATTRIBUTE_UNIX_NLINK) &&
+          g_file_info_get_attribute_uint32(temp_info,
+                                           G_FILE_ATTRIBUTE_UNIX_NLINK) > 1) {
+        if (!baobab_hardlinks_array_add(hla, temp_info)) {
+          /* we already acconted for it */
+          node->tempHLsize += (guint64)g_file_info_get_size(temp_info);
+          g_object_unref(temp_info);
+          continue;
+        }
+      }
+
+      if (g_file_info_has_attribute(temp_info, G_FILE_ATTRIBUTE_UNIX_BLOCKS)) {
+        sizes.alloc_size +=
+            BLOCK_SIZE * g_file_info_get_attribute_uint64(
+                             temp_info, G_FILE_ATTRIBUTE_UNIX_BLOCKS);
+      }
+      sizes.size += g_file_info_get_size(temp_info);
+      baobab_age_histogram_add_info(&sizes.age, temp_info,
+                                    g_file_info_get_size(temp_info), scan_time);
+      node->elements++;
+    }
+
+    /* ignore other types (symlinks, sockets, devices, etc) */
+
+    g_object_unref(temp_info);
+  }
+
+  /* won't be an error if we've finished normally */
+  if (err != NULL) {
+    g_warning("error in dir %s: %s\n", node->parse_name, err->message);
+    g_error_free(err);
+  }
+
+  g_object_unref(file_enum);
+
+  scan_node_add_sizes(node, &sizes);
+}
+
+/* returns the depth of the deepest folder shown */
+static guint scan_breadth_first(GFile *location, GFileInfo *info,
+                                BaobabHardLinkArray *hla) {
+  GQueue queue = G_QUEUE_INIT;
+  ScanNode *node;
+  guint max_depth = 0;
+
+  g_queue_push_tail(&queue, scan_node_new(NULL, location, info));
+
+  while ((node = g_queue_pop_head(&queue)) != NULL) {
+    if (!baobab.STOP_SCANNING) {
+      scan_node_list(node, &queue, hla);
+      if (node->has_row) max_depth = MAX(max_depth, (guint)node->depth);
+    }
+
+    scan_node_release(node);
+  }
+
+  return max_depth;
+}
+
 void baobab_scan_execute(GFile *location) {
   BaobabHardLinkArray *hla;
   GFileInfo *info;
@@ -321,12 +580,291 @@ void baobab_scan_execute(GFile *location) {
 
   if (ftype == G_FILE_TYPE_DIRECTORY) {
     hla = baobab_hardlinks_array_create();
-
-    sizes = loopdir(location, info, 0, hla, 0);
-    baobab.model_max_depth = sizes.depth;
+    scan_time = (guint64)(g_get_real_time() / G_USEC_PER_SEC);
+
+    if (g_settings_get_boolean(baobab.prefs_settings,
+                               BAOBAB_SETTINGS_BREADTH_FIRST)) {
+      baobab.model_max_depth = scan_breadth_first(location, info, hla);
+    } else {
+      sizes = loopdir(location, info, 0, hla, 0);
+      baobab.model_max_depth = sizes.depth;
+    }
 
     baobab_hardlinks_array_free(hla);
   }
 
   g_object_unref(info);
 }
+
+/*
+   Estimate mode.
+
+   Every folder is listed with names and types only, which is cheap, and
+   then only a bounded random sample of its files is stat'ed and a
+   bounded random sample of its subfolders is descended into. Sizes are
+   extrapolated from the sample means and come with the variance of the
+   estimate, so each row can show a 95% confidence margin.
+
+   Subfolders that could not be visited (the global budget is spent)
+   are extrapolated from the folders already visited at the same depth.
+
+   The rows are then refined in place by the exact scan.
+*/
+
+#define EST_FILE_SAMPLES 32
+#define EST_DIR_SAMPLES 16
+#define EST_MAX_DIRS 2000
+#define EST_MAX_DEPTH 16
+
+struct estimate {
+  gdouble size;
+  gdouble alloc_size;
+  gdouble variance; /* of size */
+  guint depth;
+};
+
+typedef struct {
+  gdouble sum;
+  gdouble sum_sq;
+  gdouble alloc_sum;
+  guint n;
+} EstimateLevel;
+
+static const char *estimate_attributes =
+    G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_TYPE;
+
+static const char *sample_attributes =
+    G_FILE_ATTRIBUTE_STANDARD_SIZE "," G_FILE_ATTRIBUTE_UNIX_BLOCKS;
+
+static guint estimate_dirs_left;
+static EstimateLevel estimate_levels[EST_MAX_DEPTH + 1];
+
+/* classic reservoir sampling: every name has the same chance to be kept */
+static void reservoir_add(GPtrArray *sample, guint max, guint seen,
+                          const gchar *name) {
+  guint j;
+
+  if (sample->len < max) {
+    g_ptr_array_add(sample, g_strdup(name));
+    return;
+  }
+
+  j = (guint)g_random_int_range(0, (gint32)seen);
+  if (j < max) {
+    g_free(g_ptr_array_index(sample, j));
+    g_ptr_array_index(sample, j) = g_strdup(name);
+  }
+}
+
+static gdouble sample_variance(gdouble sum, gdouble sum_sq, guint n) {
+  gdouble mean;
+
+  if (n < 2) return 0.0;
+
+  mean = sum / n;
+
+  return MAX(0.0, (sum_sq - n * mean * mean) / (n - 1));
+}
+
+/* variance of N times the mean of a sample of n out of N */
+static gdouble total_variance(gdouble s2, guint n, guint N) {
+  if (n == 0 || n >= N) return 0.0;
+
+  return (gdouble)N * N * s2 / n * (1.0 - (gdouble)n / N);
+}
+
+static struct estimate estimate_dir(GFile *file, GFileInfo *info,
+                                    guint depth) {
+  struct estimate ret = {0.0, 0.0, 0.0, 0};
+  struct chan_data data;
+  GFileEnumerator *file_enum;
+  GFileInfo *child_info;
+  GPtrArray *files, *dirs;
+  guint n_files = 0, n_dirs = 0;
+  guint k = 0, m = 0;
+  gdouble f_sum = 0.0, f_sum_sq = 0.0, f_alloc = 0.0;
+  gdouble d_sum = 0.0, d_sum_sq = 0.0, d_alloc = 0.0, d_var = 0.0;
+  gchar *display_name;
+  gchar *parse_name;
+  guint i;
+
+  if (baobab_is_excluded_location(file) || is_virtual_filesystem(file) ||
+      is_in_dot_gvfs(file))
+    return ret;
+
+  file_enum = g_file_enumerate_children(file, estimate_attributes,
+                                        G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                        NULL, NULL);
+  if (file_enum == NULL) return ret;
+
+  parse_name = g_file_get_parse_name(file);
+  if (g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME))
+    display_name = g_strdup(g_file_info_get_display_name(info));
+  else
+    display_name = g_filename_display_basename(g_file_info_get_name(info));
+
+  if (g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_STANDARD_SIZE))
+    ret.size = (gdouble)g_file_info_get_size(info);
+  if (g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_UNIX_BLOCKS))
+    ret.alloc_size = (gdouble)(BLOCK_SIZE *
+                               g_file_info_get_attribute_uint64(
+                                   info, G_FILE_ATTRIBUTE_UNIX_BLOCKS));
+
+  /* prefill the model */
+  data.size = 1UL;
+  data.alloc_size = 1UL;
+  data.depth = (gint)depth;
+  data.elements = -1;
+  data.display_name = display_name;
+  data.parse_name = parse_name;
+  data.tempHLsize = 0;
+  data.age = NULL;
+  data.estimated = TRUE;
+  data.estimate_error = 0.0;
+  baobab_fill_model(&data);
+
+  files = g_ptr_array_new_with_free_func(g_free);
+  dirs = g_ptr_array_new_with_free_func(g_free);
+
+  while ((child_info = g_file_enumerator_next_file(file_enum, NULL, NULL)) !=
+         NULL) {
+    switch (g_file_info_get_file_type(child_info)) {
+      case G_FILE_TYPE_DIRECTORY:
+        reservoir_add(dirs, EST_DIR_SAMPLES, ++n_dirs,
+                      g_file_info_get_name(child_info));
+        break;
+      case G_FILE_TYPE_REGULAR:
+        reservoir_add(files, EST_FILE_SAMPLES, ++n_files,
+                      g_file_info_get_name(child_info));
+        break;
+      default:
+        break;
+    }
+    g_object_unref(child_info);
+  }
+  g_object_unref(file_enum);
+
+  /* stat the sampled files */
+  for (i = 0; i < files->len && !baobab.STOP_SCANNING; i++) {
+    GFile *child = g_file_get_child(file, g_ptr_array_index(files, i));
+
+    child_info = g_file_query_info(child, sample_attributes,
+                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL,
+                                   NULL);
+    if (child_info != NULL) {
+      gdouble size = (gdouble)g_file_info_get_size(child_info);
+
+      f_sum += size;
+      f_sum_sq += size * size;
+      if (g_file_info_has_attribute(child_info, G_FILE_ATTRIBUTE_UNIX_BLOCKS))
+        f_alloc += (gdouble)(BLOCK_SIZE * g_file_info_get_attribute_uint64(
+                                              child_info,
+                                              G_FILE_ATTRIBUTE_UNIX_BLOCKS));
+      k++;
+      g_object_unref(child_info);
+    }
+    g_object_unref(child);
+  }
+
+  /* descend into the sampled subfolders while the budget lasts */
+  for (i = 0; i < dirs->len && !baobab.STOP_SCANNING; i++) {
+    GFile *child;
+    struct estimate est;
+
+    if (estimate_dirs_left == 0 || depth + 1 > EST_MAX_DEPTH) break;
+
+    child = g_file_get_child(file, g_ptr_array_index(dirs, i));
+    child_info = g_file_query_info(child, dir_attributes,
+                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL,
+                                   NULL);
+    if (child_info != NULL) {
+      estimate_dirs_left--;
+      est = estimate_dir(child, child_info, depth + 1);
+
+      d_sum += est.size;
+      d_sum_sq += est.size * est.size;
+      d_alloc += est.alloc_size;
+      d_var += est.variance;
+      m++;
+
+      estimate_levels[depth + 1].sum += est.size;
+      estimate_levels[depth + 1].sum_sq += est.size * est.size;
+      estimate_levels[depth + 1].alloc_sum += est.alloc_size;
+      estimate_levels[depth + 1].n++;
+
+      ret.depth = MAX(ret.depth, est.depth + 1);
+      g_object_unref(child_info);
+    }
+    g_object_unref(child);
+  }
+
+  if (k > 0) {
+    ret.size += n_files * (f_sum / k);
+    ret.alloc_size += n_files * (f_alloc / k);
+    ret.variance += total_variance(sample_variance(f_sum, f_sum_sq, k), k,
+                                   n_files);
+  }
+
+  if (m > 0) {
+    ret.size += n_dirs * (d_sum / m);
+    ret.alloc_size += n_dirs * (d_alloc / m);
+    ret.variance +=
+        total_variance(sample_variance(d_sum, d_sum_sq, m), m, n_dirs) +
+        ((gdouble)n_dirs / m) * ((gdouble)n_dirs / m) * d_var;
+  } else if (n_dirs > 0 && depth + 1 <= EST_MAX_DEPTH &&
+             estimate_levels[depth + 1].n > 0) {
+    EstimateLevel *level = &estimate_levels[depth + 1];
+
+    /* out of budget: borrow the mean of the folders sampled at the same
+     * depth elsewhere, and be pessimistic about the spread since they
+     * say little about this particular folder */
+
+    ret.size += n_dirs * (level->sum / level->n);
+    ret.alloc_size += n_dirs * (level->alloc_sum / level->n);
+    ret.variance += (gdouble)n_dirs * n_dirs *
+                    MAX(sample_variance(level->sum, level->sum_sq, level->n),
+                        (level->sum / level->n) * (level->sum / level->n));
+  }
+
+  data.display_name = display_name;
+  data.parse_name = parse_name;
+  data.size = (guint64)ret.size;
+  data.alloc_size = (guint64)ret.alloc_size;
+  data.depth = (gint)depth;
+  data.elements = (gint)(n_files + n_dirs);
+  data.tempHLsize = 0;
+  data.age = NULL;
+  data.estimated = TRUE;
+  /* 95% confidence margin, relative to the estimate */
+  data.estimate_error =
+      ret.size > 0.0 ? 1.96 * sqrt(ret.variance) / ret.size : 0.0;
+  baobab_fill_model(&data);
+
+  g_ptr_array_free(files, TRUE);
+  g_ptr_array_free(dirs, TRUE);
+  g_free(display_name);
+  g_free(parse_name);
+
+  return ret;
+}
+
+void baobab_scan_estimate(GFile *location) {
+  GFileInfo *info;
+  struct estimate est;
+
+  g_return_if_fail(location != NULL);
+
+  info = g_file_query_info(location, dir_attributes, G_FILE_QUERY_INFO_NONE,
+                           NULL, NULL);
+  if (info == NULL) return;
+
+  if (g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY) {
+    estimate_dirs_left = EST_MAX_DIRS;
+    memset(estimate_levels, 0, sizeof(estimate_levels));
+
+    est = estimate_dir(location, info, 0);
+    baobab.model_max_depth = est.depth;
+  }
+
+  g_object_unref(info);
+}
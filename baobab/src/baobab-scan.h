@@ -23,5 +23,6 @@
 #include <gio/gio.h>
 
 void baobab_scan_execute(GFile *location);
+void baobab_scan_estimate(GFile *location);
 
 #endif /* __BAOBAB_SCAN_H__ */
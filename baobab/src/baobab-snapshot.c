@@ -0,0 +1,732 @@
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gio/gio.h>
+#include <glib/gi18n.h>
+#include <gtk/gtk.h>
+#include <string.h>
+
+#include "baobab-snapshot.h"
+#include "baobab-treeview.h"
+#include "baobab-utils.h"
+#include "baobab.h"
+
+/*
+   Snapshot format.
+
+   A snapshot is the scanned tree written in pre-order, one record per
+   folder, with the children of every folder sorted by name (plain byte
+   order). All the integers are big endian:
+
+     header:  "BAOBABSNAP" version:u16 root:string scan-time:u64
+     record:  depth:u16 size:u64 alloc-size:u64 elements:i32 name:string
+     end:     depth:u16 = SNAPSHOT_END
+
+   where string is len:u32 followed by len bytes. The root is the first
+   record, at depth 0, and its name is the parse name of the location.
+
+   Since both files are sorted the same way, two snapshots can be
+   compared with a single merge pass that never holds more than the
+   current path and the folders that actually changed.
+*/
+
+#define SNAPSHOT_MAGIC "BAOBABSNAP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_END G_MAXUINT16
+#define SNAPSHOT_MAX_NAME 4096
+
+typedef struct {
+  gchar *name;
+  GtkTreeIter iter;
+} SnapshotChild;
+
+static gboolean write_string(GDataOutputStream *out, const gchar *str,
+                             GError **error) {
+  guint32 len = (guint32)strlen(str);
+
+  return g_data_output_stream_put_uint32(out, len, NULL, error) &&
+         g_data_output_stream_put_string(out, str, NULL, error);
+}
+
+static gint compare_children(gconstpointer a, gconstpointer b) {
+  const SnapshotChild *ca = a;
+  const SnapshotChild *cb = b;
+
+  return strcmp(ca->name, cb->name);
+}
+
+static gchar *get_basename(const gchar *parse_name) {
+  const gchar *p = strrchr(parse_name, '/');
+
+  return g_strdup((p != NULL && p[1] != '\0') ? p + 1 : parse_name);
+}
+
+static gboolean write_node(GDataOutputStream *out, GtkTreeModel *model,
+                           GtkTreeIter *iter, guint16 depth, const gchar *name,
+                           GError **error) {
+  GArray *children;
+  GtkTreeIter child;
+  guint64 size, alloc_size;
+  gint elements;
+  gboolean ret = TRUE;
+  guint i;
+
+  gtk_tree_model_get(model, iter, COL_H_SIZE, &size, COL_H_ALLOCSIZE,
+                     &alloc_size, COL_H_ELEMENTS, &elements, -1);
+
+  if (!g_data_output_stream_put_uint16(out, depth, NULL, error) ||
+      !g_data_output_stream_put_uint64(out, size, NULL, error) ||
+      !g_data_output_stream_put_uint64(out, alloc_size, NULL, error) ||
+      !g_data_output_stream_put_int32(out, elements, NULL, error) ||
+      !write_string(out, name, error))
+    return FALSE;
+
+  children = g_array_new(FALSE, FALSE, sizeof(SnapshotChild));
+
+  if (gtk_tree_model_iter_children(model, &child, iter)) {
+    do {
+      SnapshotChild c;
+      gchar *parse_name;
+
+      gtk_tree_model_get(model, &child, COL_H_PARSENAME, &parse_name,
+                         COL_H_ELEMENTS, &elements, -1);
+
+      /* skip folders whose scan did not complete */
+      if (elements != -1 && parse_name != NULL && *parse_name != '\0') {
+        c.name = get_basename(parse_name);
+        c.iter = child;
+        g_array_append_val(children, c);
+      }
+
+      g_free(parse_name);
+    } while (gtk_tree_model_iter_next(model, &child));
+  }
+
+  g_array_sort(children, compare_children);
+
+  for (i = 0; i < children->len; i++) {
+    SnapshotChild *c = &g_array_index(children, SnapshotChild, i);
+
+    if (ret) ret = write_node(out, model, &c->iter, depth + 1, c->name, error);
+    g_free(c->name);
+  }
+
+  g_array_free(children, TRUE);
+
+  return ret;
+}
+
+gboolean baobab_snapshot_save(GtkTreeModel *model, GFile *file,
+                              GError **error) {
+  GFileOutputStream *stream;
+  GDataOutputStream *out;
+  GtkTreeIter root;
+  gchar *root_name = NULL;
+  gint elements = -1;
+  gboolean ret;
+
+  g_return_val_if_fail(GTK_IS_TREE_MODEL(model), FALSE);
+  g_return_val_if_fail(G_IS_FILE(file), FALSE);
+
+  if (gtk_tree_model_get_iter_first(model, &root))
+    gtk_tree_model_get(model, &root, COL_H_PARSENAME, &root_name,
+                       COL_H_ELEMENTS, &elements, -1);
+
+  if (elements == -1 || root_name == NULL || *root_name == '\0') {
+    g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+                        _("There is no completed scan to save."));
+    g_free(root_name);
+    return FALSE;
+  }
+
+  stream = g_file_replace(file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, error);
+  if (stream == NULL) {
+    g_free(root_name);
+    return FALSE;
+  }
+
+  out = g_data_output_stream_new(G_OUTPUT_STREAM(stream));
+  g_object_unref(stream);
+
+  ret = g_data_output_stream_put_string(out, SNAPSHOT_MAGIC, NULL, error) &&
+        g_data_output_stream_put_uint16(out, SNAPSHOT_VERSION, NULL, error) &&
+        write_string(out, root_name, error) &&
+        g_data_output_stream_put_uint64(
+            out, (guint64)(g_get_real_time() / G_USEC_PER_SEC), NULL, error) &&
+        write_node(out, model, &root, 0, root_name, error) &&
+        g_data_output_stream_put_uint16(out, SNAPSHOT_END, NULL, error);
+
+  if (ret)
+    ret = g_output_stream_close(G_OUTPUT_STREAM(out), NULL, error);
+  else
+    g_output_stream_close(G_OUTPUT_STREAM(out), NULL, NULL);
+
+  g_object_unref(out);
+  g_free(root_name);
+
+  return ret;
+}
+
+/* streaming reader: holds only the current record */
+typedef struct {
+  GDataInputStream *in;
+  gboolean valid;
+  guint depth;
+  guint64 size;
+  guint64 alloc_size;
+  gint32 elements;
+  gchar *name;
+  GError *error;
+} SnapshotReader;
+
+static gchar *read_string(GDataInputStream *in, GError **error) {
+  guint32 len;
+  gchar *str;
+  gsize read;
+
+  len = g_data_input_stream_read_uint32(in, NULL, error);
+  if (error != NULL && *error != NULL) return NULL;
+
+  if (len > SNAPSHOT_MAX_NAME) {
+    g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                        _("The snapshot file is corrupted."));
+    return NULL;
+  }
+
+  str = g_malloc(len + 1);
+  if (!g_input_stream_read_all(G_INPUT_STREAM(in), str, len, &read, NULL,
+                               error)) {
+    g_free(str);
+    return NULL;
+  }
+
+  if (read != len) {
+    g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                        _("The snapshot file is truncated."));
+    g_free(str);
+    return NULL;
+  }
+
+  str[len] = '\0';
+
+  return str;
+}
+
+static void reader_next(SnapshotReader *r) {
+  GError **error = &r->error;
+  guint depth;
+
+  g_clear_pointer(&r->name, g_free);
+
+  if (!r->valid) return;
+
+  r->valid = FALSE;
+
+  depth = g_data_input_stream_read_uint16(r->in, NULL, error);
+  if (*error != NULL || depth == SNAPSHOT_END) return;
+
+  /* depth can only grow one level at a time in pre-order */
+  if (depth > r->depth + 1) {
+    g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                        _("The snapshot file is corrupted."));
+    return;
+  }
+
+  r->depth = depth;
+  r->size = g_data_input_stream_read_uint64(r->in, NULL, error);
+  if (*error == NULL)
+    r->alloc_size = g_data_input_stream_read_uint64(r->in, NULL, error);
+  if (*error == NULL)
+    r->elements = g_data_input_stream_read_int32(r->in, NULL, error);
+  if (*error == NULL) r->name = read_string(r->in, error);
+
+  r->valid = (*error == NULL);
+}
+
+static gboolean reader_open(SnapshotReader *r, GFile *file, gchar **root_name,
+                            GError **error) {
+  GFileInputStream *stream;
+  gchar magic[sizeof(SNAPSHOT_MAGIC) - 1];
+  gsize read;
+  guint version;
+
+  memset(r, 0, sizeof(SnapshotReader));
+
+  stream = g_file_read(file, NULL, error);
+  if (stream == NULL) return FALSE;
+
+  r->in = g_data_input_stream_new(G_INPUT_STREAM(stream));
+  g_object_unref(stream);
+
+  if (!g_input_stream_read_all(G_INPUT_STREAM(r->in), magic, sizeof(magic),
+                               &read, NULL, error))
+    return FALSE;
+
+  if (read != sizeof(magic) || memcmp(magic, SNAPSHOT_MAGIC, read) != 0) {
+    g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                        _("The file is not a disk usage snapshot."));
+    return FALSE;
+  }
+
+  version = g_data_input_stream_read_uint16(r->in, NULL, &r->error);
+  if (r->error == NULL && version != SNAPSHOT_VERSION)
+    g_set_error_literal(&r->error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                        _("The snapshot was written by an unsupported "
+                          "version."));
+  if (r->error == NULL) *root_name = read_string(r->in, &r->error);
+  if (r->error == NULL)
+    g_data_input_stream_read_uint64(r->in, NULL, &r->error); /* scan time */
+
+  if (r->error != NULL) {
+    g_propagate_error(error, r->error);
+    r->error = NULL;
+    return FALSE;
+  }
+
+  /* load the root record */
+  r->valid = TRUE;
+  r->depth = 0;
+  reader_next(r);
+
+  if (r->error != NULL) {
+    g_propagate_error(error, r->error);
+    r->error = NULL;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void reader_close(SnapshotReader *r) {
+  g_clear_object(&r->in);
+  g_clear_pointer(&r->name, g_free);
+  g_clear_error(&r->error);
+}
+
+/* move past the descendants of the record just consumed at @depth */
+static void reader_skip_subtree(SnapshotReader *r, guint depth) {
+  while (r->valid && r->depth > depth) reader_next(r);
+}
+
+typedef enum { DIFF_CHANGED, DIFF_ADDED, DIFF_REMOVED } DiffStatus;
+
+typedef struct _DiffNode DiffNode;
+
+struct _DiffNode {
+  gchar *name;
+  DiffStatus status;
+  guint64 old_size;
+  guint64 new_size;
+  GSList *children;
+};
+
+static void diff_node_free(DiffNode *node) {
+  g_slist_free_full(node->children, (GDestroyNotify)diff_node_free);
+  g_free(node->name);
+  g_slice_free(DiffNode, node);
+}
+
+static DiffNode *diff_node_new(const gchar *name, DiffStatus status,
+                               guint64 old_size, guint64 new_size) {
+  DiffNode *node = g_slice_new0(DiffNode);
+
+  node->name = g_strdup(name);
+  node->status = status;
+  node->old_size = old_size;
+  node->new_size = new_size;
+
+  return node;
+}
+
+#define READER_SIZE(r, alloc) ((alloc) ? (r)->alloc_size : (r)->size)
+
+/* merges the children (at @depth) of the two current folders */
+static void merge_children(SnapshotReader *ra, SnapshotReader *rb, guint depth,
+                           gboolean alloc, GSList **out) {
+  for (;;) {
+    gboolean a_has = ra->valid && ra->depth == depth;
+    gboolean b_has = rb->valid && rb->depth == depth;
+    DiffNode *node;
+    gint cmp;
+
+    if (!a_has && !b_has) break;
+
+    if (!a_has)
+      cmp = 1;
+    else if (!b_has)
+      cmp = -1;
+    else
+      cmp = strcmp(ra->name, rb->name);
+
+    if (cmp < 0) {
+      node = diff_node_new(ra->name, DIFF_REMOVED, READER_SIZE(ra, alloc), 0);
+      reader_next(ra);
+      reader_skip_subtree(ra, depth);
+      *out = g_slist_prepend(*out, node);
+    } else if (cmp > 0) {
+      node = diff_node_new(rb->name, DIFF_ADDED, 0, READER_SIZE(rb, alloc));
+      reader_next(rb);
+      reader_skip_subtree(rb, depth);
+      *out = g_slist_prepend(*out, node);
+    } else {
+      node = diff_node_new(ra->name, DIFF_CHANGED, READER_SIZE(ra, alloc),
+                           READER_SIZE(rb, alloc));
+      reader_next(ra);
+      reader_next(rb);
+      merge_children(ra, rb, depth + 1, alloc, &node->children);
+
+      /* unchanged subtrees are dropped right away */
+      if (node->old_size != node->new_size || node->children != NULL)
+        *out = g_slist_prepend(*out, node);
+      else
+        diff_node_free(node);
+    }
+  }
+}
+
+static gchar *format_delta(gint64 delta) {
+  gchar *size;
+  gchar *str;
+
+  if (delta == 0) return g_strdup("0");
+
+  size = g_format_size(delta > 0 ? (guint64)delta : (guint64)-delta);
+  str = g_strdup_printf("%c%s", delta > 0 ? '+' : '-', size);
+  g_free(size);
+
+  return str;
+}
+
+static void fill_diff_store(GtkTreeStore *store, GtkTreeIter *parent,
+                            DiffNode *node) {
+  GtkTreeIter iter;
+  const gchar *status;
+  gchar *delta_str, *old_str, *new_str;
+  gint64 delta;
+  GSList *l;
+
+  delta = (gint64)node->new_size - (gint64)node->old_size;
+
+  switch (node->status) {
+    case DIFF_ADDED:
+      status = _("New");
+      break;
+    case DIFF_REMOVED:
+      status = _("Removed");
+      break;
+    default:
+      status = "";
+      break;
+  }
+
+  delta_str = format_delta(delta);
+  old_str = node->status == DIFF_ADDED ? g_strdup("--")
+                                       : g_format_size(node->old_size);
+  new_str = node->status == DIFF_REMOVED ? g_strdup("--")
+                                         : g_format_size(node->new_size);
+
+  gtk_tree_store_append(store, &iter, parent);
+  gtk_tree_store_set(store, &iter, DIFF_COL_NAME, node->name, DIFF_COL_STATUS,
+                     status, DIFF_COL_DELTA, delta_str, DIFF_COL_OLD_SIZE,
+                     old_str, DIFF_COL_NEW_SIZE, new_str, DIFF_COL_H_DELTA,
+                     delta, -1);
+
+  g_free(delta_str);
+  g_free(old_str);
+  g_free(new_str);
+
+  for (l = node->children; l != NULL; l = l->next)
+    fill_diff_store(store, &iter, l->data);
+}
+
+GtkTreeStore *baobab_snapshot_diff(GFile *old_file, GFile *new_file,
+                                   gboolean use_alloc_size, GError **error) {
+  SnapshotReader ra, rb;
+  gchar *old_root = NULL;
+  gchar *new_root = NULL;
+  GtkTreeStore *store = NULL;
+  DiffNode *root;
+
+  g_return_val_if_fail(G_IS_FILE(old_file), NULL);
+  g_return_val_if_fail(G_IS_FILE(new_file), NULL);
+
+  if (!reader_open(&ra, old_file, &old_root, error)) {
+    reader_close(&ra);
+    return NULL;
+  }
+
+  if (!reader_open(&rb, new_file, &new_root, error)) goto out;
+
+  if (strcmp(old_root, new_root) != 0) {
+    g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                _("The snapshots are of different folders (%s and %s)."),
+                old_root, new_root);
+    goto out;
+  }
+
+  root = diff_node_new(new_root, DIFF_CHANGED, READER_SIZE(&ra, use_alloc_size),
+                       READER_SIZE(&rb, use_alloc_size));
+  reader_next(&ra);
+  reader_next(&rb);
+  merge_children(&ra, &rb, 1, use_alloc_size, &root->children);
+
+  if (ra.error != NULL || rb.error != NULL) {
+    g_propagate_error(error, ra.error != NULL ? ra.error : rb.error);
+    if (ra.error != NULL)
+      ra.error = NULL;
+    else
+      rb.error = NULL;
+    diff_node_free(root);
+    goto out;
+  }
+
+  store = gtk_tree_store_new(DIFF_NUM_COLUMNS, G_TYPE_STRING, /* NAME */
+                             G_TYPE_STRING,                   /* STATUS */
+                             G_TYPE_STRING,                   /* DELTA */
+                             G_TYPE_STRING,                   /* OLD_SIZE */
+                             G_TYPE_STRING,                   /* NEW_SIZE */
+                             G_TYPE_INT64                     /* H_DELTA */
+  );
+
+  fill_diff_store(store, NULL, root);
+  diff_node_free(root);
+
+  /* the biggest growth first */
+  gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(store),
+                                       DIFF_COL_H_DELTA, GTK_SORT_DESCENDING);
+
+out:
+  reader_close(&ra);
+  reader_close(&rb);
+  g_free(old_root);
+  g_free(new_root);
+
+  return store;
+}
+
+static GtkFileFilter *snapshot_file_filter(void) {
+  GtkFileFilter *filter;
+
+  filter = gtk_file_filter_new();
+  gtk_file_filter_set_name(filter, _("Disk usage snapshots"));
+  gtk_file_filter_add_pattern(filter, "*.baobab");
+
+  return filter;
+}
+
+void baobab_snapshot_save_dialog(void) {
+  GtkWidget *dialog;
+  gchar *basename;
+  gchar *date;
+  gchar *def_filename;
+  GDateTime *now;
+
+  g_return_if_fail(baobab.current_location != NULL);
+
+  dialog = gtk_file_chooser_dialog_new(
+      _("Save Scan Snapshot"), GTK_WINDOW(baobab.window),
+      GTK_FILE_CHOOSER_ACTION_SAVE, "gtk-cancel", GTK_RESPONSE_CANCEL,
+      "gtk-save", GTK_RESPONSE_ACCEPT, NULL);
+
+  now = g_date_time_new_now_local();
+  date = g_date_time_format(now, "%Y%m%d-%H%M");
+  basename = g_file_get_basename(baobab.current_location);
+  def_filename = g_strdup_printf(
+      "%s-%s.baobab",
+      (basename != NULL && strcmp(basename, "/") != 0) ? basename : "root",
+      date);
+  g_date_time_unref(now);
+  g_free(date);
+
+  gtk_file_chooser_set_current_name(GTK_FILE_CHOOSER(dialog), def_filename);
+  gtk_file_chooser_set_current_folder(GTK_FILE_CHOOSER(dialog),
+                                      g_get_home_dir());
+  gtk_file_chooser_set_do_overwrite_confirmation(GTK_FILE_CHOOSER(dialog),
+                                                 TRUE);
+  gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog),
+                              snapshot_file_filter());
+
+  g_free(basename);
+  g_free(def_filename);
+
+  if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_ACCEPT) {
+    GFile *file;
+    GError *error = NULL;
+
+    file = gtk_file_chooser_get_file(GTK_FILE_CHOOSER(dialog));
+    gtk_widget_hide(dialog);
+
+    if (!baobab_snapshot_save(GTK_TREE_MODEL(baobab.model), file, &error)) {
+      message(_("Could not save the snapshot"), error->message,
+              GTK_MESSAGE_ERROR, baobab.window);
+      g_error_free(error);
+    }
+
+    g_object_unref(file);
+  }
+
+  gtk_widget_destroy(dialog);
+}
+
+static void compare_dialog_response(GtkDialog *dialog, gint response,
+                                    gpointer data) {
+  GtkWidget *old_chooser, *new_chooser, *tree_view;
+  GFile *old_file, *new_file;
+  GtkTreeStore *store;
+  GtkTreePath *path;
+  GError *error = NULL;
+
+  if (response != GTK_RESPONSE_APPLY) {
+    gtk_widget_destroy(GTK_WIDGET(dialog));
+    return;
+  }
+
+  old_chooser = g_object_get_data(G_OBJECT(dialog), "old-chooser");
+  new_chooser = g_object_get_data(G_OBJECT(dialog), "new-chooser");
+  tree_view = g_object_get_data(G_OBJECT(dialog), "tree-view");
+
+  old_file = gtk_file_chooser_get_file(GTK_FILE_CHOOSER(old_chooser));
+  new_file = gtk_file_chooser_get_file(GTK_FILE_CHOOSER(new_chooser));
+
+  if (old_file == NULL || new_file == NULL) {
+    message(_("Could not compare the snapshots"),
+            _("Select both an older and a newer snapshot."),
+            GTK_MESSAGE_ERROR, GTK_WIDGET(dialog));
+    goto out;
+  }
+
+  store = baobab_snapshot_diff(old_file, new_file, baobab.show_allocated,
+                               &error);
+  if (store == NULL) {
+    message(_("Could not compare the snapshots"), error->message,
+            GTK_MESSAGE_ERROR, GTK_WIDGET(dialog));
+    g_error_free(error);
+    goto out;
+  }
+
+  gtk_tree_view_set_model(GTK_TREE_VIEW(tree_view), GTK_TREE_MODEL(store));
+  g_object_unref(store);
+
+  /* show the first level of changes */
+  path = gtk_tree_path_new_first();
+  gtk_tree_view_expand_row(GTK_TREE_VIEW(tree_view), path, FALSE);
+  gtk_tree_path_free(path);
+
+out:
+  if (old_file) g_object_unref(old_file);
+  if (new_file) g_object_unref(new_file);
+}
+
+static void append_text_column(GtkTreeView *tree_view, const gchar *title,
+                               gint column, gint sort_column, gfloat xalign) {
+  GtkCellRenderer *cell;
+  GtkTreeViewColumn *col;
+
+  cell = gtk_cell_renderer_text_new();
+  g_object_set(G_OBJECT(cell), "xalign", xalign, NULL);
+  col = gtk_tree_view_column_new_with_attributes(title, cell, "text", column,
+                                                 NULL);
+  gtk_tree_view_column_set_sort_column_id(col, sort_column);
+  gtk_tree_view_column_set_resizable(col, TRUE);
+  gtk_tree_view_append_column(tree_view, col);
+}
+
+static GtkWidget *snapshot_chooser_new(const gchar *title) {
+  GtkWidget *chooser;
+
+  chooser = gtk_file_chooser_button_new(title, GTK_FILE_CHOOSER_ACTION_OPEN);
+  gtk_file_chooser_set_current_folder(GTK_FILE_CHOOSER(chooser),
+                                      g_get_home_dir());
+  gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(chooser),
+                              snapshot_file_filter());
+
+  return chooser;
+}
+
+void baobab_snapshot_compare_dialog(void) {
+  GtkWidget *dialog;
+  GtkWidget *content;
+  GtkWidget *grid;
+  GtkWidget *label;
+  GtkWidget *old_chooser, *new_chooser;
+  GtkWidget *scrolled;
+  GtkWidget *tree_view;
+
+  dialog = gtk_dialog_new_with_buttons(
+      _("Compare Snapshots"), GTK_WINDOW(baobab.window),
+      GTK_DIALOG_DESTROY_WITH_PARENT, "gtk-close", GTK_RESPONSE_CLOSE,
+      _("_Compare"), GTK_RESPONSE_APPLY, NULL);
+  gtk_window_set_default_size(GTK_WINDOW(dialog), 640, 480);
+  gtk_dialog_set_default_response(GTK_DIALOG(dialog), GTK_RESPONSE_APPLY);
+
+  content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+
+  grid = gtk_grid_new();
+  gtk_grid_set_row_spacing(GTK_GRID(grid), 6);
+  gtk_grid_set_column_spacing(GTK_GRID(grid), 12);
+  gtk_container_set_border_width(GTK_CONTAINER(grid), 6);
+  gtk_box_pack_start(GTK_BOX(content), grid, FALSE, FALSE, 0);
+
+  old_chooser = snapshot_chooser_new(_("Select the Older Snapshot"));
+  label = gtk_label_new_with_mnemonic(_("_Older snapshot:"));
+  gtk_label_set_mnemonic_widget(GTK_LABEL(label), old_chooser);
+  gtk_widget_set_halign(label, GTK_ALIGN_START);
+  gtk_widget_set_hexpand(old_chooser, TRUE);
+  gtk_grid_attach(GTK_GRID(grid), label, 0, 0, 1, 1);
+  gtk_grid_attach(GTK_GRID(grid), old_chooser, 1, 0, 1, 1);
+
+  new_chooser = snapshot_chooser_new(_("Select the Newer Snapshot"));
+  label = gtk_label_new_with_mnemonic(_("_Newer snapshot:"));
+  gtk_label_set_mnemonic_widget(GTK_LABEL(label), new_chooser);
+  gtk_widget_set_halign(label, GTK_ALIGN_START);
+  gtk_grid_attach(GTK_GRID(grid), label, 0, 1, 1, 1);
+  gtk_grid_attach(GTK_GRID(grid), new_chooser, 1, 1, 1, 1);
+
+  scrolled = gtk_scrolled_window_new(NULL, NULL);
+  gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+                                 GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+  gtk_scrolled_window_set_shadow_type(GTK_SCROLLED_WINDOW(scrolled),
+                                      GTK_SHADOW_IN);
+  gtk_box_pack_start(GTK_BOX(content), scrolled, TRUE, TRUE, 6);
+
+  tree_view = gtk_tree_view_new();
+  append_text_column(GTK_TREE_VIEW(tree_view), _("Folder"), DIFF_COL_NAME,
+                     DIFF_COL_NAME, 0.0);
+  append_text_column(GTK_TREE_VIEW(tree_view), _("Change"), DIFF_COL_DELTA,
+                     DIFF_COL_H_DELTA, 1.0);
+  append_text_column(GTK_TREE_VIEW(tree_view), _("Before"), DIFF_COL_OLD_SIZE,
+                     DIFF_COL_H_DELTA, 1.0);
+  append_text_column(GTK_TREE_VIEW(tree_view), _("After"), DIFF_COL_NEW_SIZE,
+                     DIFF_COL_H_DELTA, 1.0);
+  append_text_column(GTK_TREE_VIEW(tree_view), _("Status"), DIFF_COL_STATUS,
+                     DIFF_COL_STATUS, 0.0);
+  gtk_container_add(GTK_CONTAINER(scrolled), tree_view);
+
+  g_object_set_data(G_OBJECT(dialog), "old-chooser", old_chooser);
+  g_object_set_data(G_OBJECT(dialog), "new-chooser", new_chooser);
+  g_object_set_data(G_OBJECT(dialog), "tree-view", tree_view);
+
+  g_signal_connect(dialog, "response", G_CALLBACK(compare_dialog_response),
+                   NULL);
+
+  gtk_widget_show_all(dialog);
+}
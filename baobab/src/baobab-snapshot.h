@@ -0,0 +1,44 @@
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BAOBAB_SNAPSHOT_H__
+#define __BAOBAB_SNAPSHOT_H__
+
+#include <gio/gio.h>
+#include <gtk/gtk.h>
+
+/* diff model columns (_H_ are hidden) */
+enum {
+  DIFF_COL_NAME,
+  DIFF_COL_STATUS,
+  DIFF_COL_DELTA,
+  DIFF_COL_OLD_SIZE,
+  DIFF_COL_NEW_SIZE,
+  DIFF_COL_H_DELTA,
+  DIFF_NUM_COLUMNS
+};
+
+gboolean baobab_snapshot_save(GtkTreeModel *model, GFile *file,
+                              GError **error);
+GtkTreeStore *baobab_snapshot_diff(GFile *old_file, GFile *new_file,
+                                   gboolean use_alloc_size, GError **error);
+
+void baobab_snapshot_save_dialog(void);
+void baobab_snapshot_compare_dialog(void);
+
+#endif /* __BAOBAB_SNAPSHOT_H__ */
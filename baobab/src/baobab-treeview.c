@@ -27,6 +27,7 @@
 #include <gtk/gtk.h>
 #include <string.h>
 
+#include "baobab-age.h"
 #include "baobab-cell-renderer-progress.h"
 #include "baobab-treeview.h"
 #include "baobab-utils.h"
@@ -46,7 +47,10 @@ static GtkTreeStore *create_model(void) {
                          G_TYPE_STRING,                   /* COL_ELEMENTS */
                          G_TYPE_INT,                      /* COL_H_ELEMENTS */
                          G_TYPE_STRING,                   /* COL_HARDLINK */
-                         G_TYPE_UINT64                    /* COL_H_HARDLINK */
+                         G_TYPE_UINT64,                   /* COL_H_HARDLINK */
+                         BAOBAB_TYPE_AGE_HISTOGRAM,       /* COL_H_AGE */
+                         G_TYPE_BOOLEAN,                  /* COL_H_ESTIMATED */
+                         G_TYPE_DOUBLE /* COL_H_ESTIMATE_ERROR */
       );
 
   return mdl;
@@ -127,6 +131,38 @@ static gboolean on_tv_button_press(GtkWidget *widget, GdkEventButton *event,
   return FALSE;
 }
 
+static gboolean on_tv_query_tooltip(GtkWidget *widget, gint x, gint y,
+                                    gboolean keyboard_mode,
+                                    GtkTooltip *tooltip, gpointer data) {
+  GtkTreeModel *model;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  BaobabAgeHistogram *age;
+  gchar *markup = NULL;
+  gboolean ret = FALSE;
+
+  if (!gtk_tree_view_get_tooltip_context(GTK_TREE_VIEW(widget), &x, &y,
+                                         keyboard_mode, &model, &path, &iter))
+    return FALSE;
+
+  gtk_tree_model_get(model, &iter, COL_H_AGE, &age, -1);
+  if (age != NULL) {
+    markup = baobab_age_histogram_to_markup(age);
+    baobab_age_histogram_free(age);
+  }
+
+  if (markup != NULL) {
+    gtk_tooltip_set_markup(tooltip, markup);
+    gtk_tree_view_set_tooltip_row(GTK_TREE_VIEW(widget), tooltip, path);
+    g_free(markup);
+    ret = TRUE;
+  }
+
+  gtk_tree_path_free(path);
+
+  return ret;
+}
+
 static gboolean baobab_treeview_equal_func(GtkTreeModel *model, gint column,
                                            const gchar *key, GtkTreeIter *iter,
                                            gpointer data) {
@@ -182,6 +218,11 @@ GtkWidget *create_directory_treeview(void) {
   g_signal_connect(tvw, "button-press-event", G_CALLBACK(on_tv_button_press),
                    NULL);
 
+  /* age histogram of the row */
+  gtk_widget_set_has_tooltip(tvw, TRUE);
+  g_signal_connect(tvw, "query-tooltip", G_CALLBACK(on_tv_query_tooltip),
+                   NULL);
+
   /* dir name column */
   g_signal_connect(gtk_tree_view_get_selection(GTK_TREE_VIEW(tvw)), "changed",
                    G_CALLBACK(on_tv_selection_changed), NULL);
@@ -34,6 +34,9 @@ enum {
   COL_H_ELEMENTS,
   COL_HARDLINK,
   COL_H_HARDLINK,
+  COL_H_AGE,
+  COL_H_ESTIMATED,
+  COL_H_ESTIMATE_ERROR,
   NUM_TREE_COLUMNS
 };
 
@@ -129,6 +129,35 @@ void on_toggled(GtkToggleButton *togglebutton, gpointer dialog) {
       !gtk_file_chooser_get_show_hidden(GTK_FILE_CHOOSER(dialog)));
 }
 
+/* estimated rows are shown in italics, with their confidence margin */
+gchar *baobab_format_estimate(guint64 size, gdouble error) {
+  gchar *size_str;
+  gchar *error_str;
+  gchar *markup;
+
+  size_str = g_format_size(size);
+  error_str = g_format_size((guint64)(error * (gdouble)size));
+
+  /* Translators: an estimated size and its error margin, e.g. ~1.2 GB ±80 MB */
+  markup = g_markup_printf_escaped(_("<i>~%s ±%s</i>"), size_str, error_str);
+
+  g_free(size_str);
+  g_free(error_str);
+
+  return markup;
+}
+
+static gchar *format_row_size(GtkTreeModel *mdl, GtkTreeIter *iter,
+                              guint64 size) {
+  gboolean estimated;
+  gdouble error;
+
+  gtk_tree_model_get(mdl, iter, COL_H_ESTIMATED, &estimated,
+                     COL_H_ESTIMATE_ERROR, &error, -1);
+
+  return estimated ? baobab_format_estimate(size, error) : g_format_size(size);
+}
+
 gboolean show_bars(GtkTreeModel *mdl, GtkTreePath *path, GtkTreeIter *iter,
                    gpointer data) {
   GtkTreeIter parent;
@@ -155,7 +184,7 @@ gboolean show_bars(GtkTreeModel *mdl, GtkTreePath *path, GtkTreeIter *iter,
 
     gtk_tree_model_get(mdl, iter, size_col, &size, -1);
 
-    sizecstr = g_format_size(size);
+    sizecstr = format_row_size(mdl, iter, size);
 
     if (readelements == -1) {
       gtk_tree_store_set(GTK_TREE_STORE(mdl), iter, COL_DIR_SIZE, sizecstr, -1);
@@ -177,7 +206,7 @@ gboolean show_bars(GtkTreeModel *mdl, GtkTreePath *path, GtkTreeIter *iter,
     if (readelements != -1) {
       gtk_tree_model_get(mdl, iter, size_col, &size, -1);
 
-      sizecstr = g_format_size(size);
+      sizecstr = format_row_size(mdl, iter, size);
 
       gtk_tree_store_set(GTK_TREE_STORE(mdl), iter, COL_H_PERC, 100.0,
                          COL_DIR_SIZE, sizecstr, -1);
@@ -192,6 +221,83 @@ gboolean show_bars(GtkTreeModel *mdl, GtkTreePath *path, GtkTreeIter *iter,
   return FALSE;
 }
 
+/*
+ * removes a folder that went away from the model, without a rescan:
+ * its sizes are subtracted from every ancestor and the percentages are
+ * recomputed only for the rows below those ancestors.
+ */
+void remove_folder_row(GtkTreeModel *mdl, GtkTreeIter *iter) {
+  GtkTreeIter child, parent;
+  GSList *ancestors = NULL;
+  GSList *l;
+  BaobabAgeHistogram *age;
+  guint64 size, alloc_size;
+  gboolean has_parent;
+
+  gtk_tree_model_get(mdl, iter, COL_H_SIZE, &size, COL_H_ALLOCSIZE,
+                     &alloc_size, COL_H_AGE, &age, -1);
+
+  has_parent = gtk_tree_model_iter_parent(mdl, &parent, iter);
+  gtk_tree_store_remove(GTK_TREE_STORE(mdl), iter);
+
+  while (has_parent) {
+    GtkTreeIter grandparent;
+    BaobabAgeHistogram *parent_age;
+    guint64 parent_size, parent_alloc_size;
+    gint readelements;
+
+    gtk_tree_model_get(mdl, &parent, COL_H_ELEMENTS, &readelements,
+                       COL_H_SIZE, &parent_size, COL_H_ALLOCSIZE,
+                       &parent_alloc_size, COL_H_AGE, &parent_age, -1);
+
+    /* skip the filesystem capacity row and rows still being scanned */
+    if (readelements != -1) {
+      parent_size -= MIN(parent_size, size);
+      parent_alloc_size -= MIN(parent_alloc_size, alloc_size);
+      if (parent_age != NULL && age != NULL)
+        baobab_age_histogram_subtract(parent_age, age);
+
+      gtk_tree_store_set(GTK_TREE_STORE(mdl), &parent, COL_H_SIZE, parent_size,
+                         COL_H_ALLOCSIZE, parent_alloc_size, COL_H_AGE,
+                         parent_age, -1);
+
+      /* only the direct parent loses an item */
+      if (ancestors == NULL && readelements > 0) {
+        gchar *elements;
+
+        readelements--;
+        elements = g_strdup_printf(
+            ngettext("%5d item", "%5d items", readelements), readelements);
+        gtk_tree_store_set(GTK_TREE_STORE(mdl), &parent, COL_ELEMENTS,
+                           elements, COL_H_ELEMENTS, readelements, -1);
+        g_free(elements);
+      }
+    }
+
+    if (parent_age != NULL) baobab_age_histogram_free(parent_age);
+
+    ancestors = g_slist_prepend(ancestors, gtk_tree_iter_copy(&parent));
+
+    has_parent = gtk_tree_model_iter_parent(mdl, &grandparent, &parent);
+    parent = grandparent;
+  }
+
+  if (age != NULL) baobab_age_histogram_free(age);
+
+  /* ancestors are now top-down: the topmost row, then the rows below */
+  if (ancestors != NULL) show_bars(mdl, NULL, ancestors->data, NULL);
+
+  for (l = ancestors; l != NULL; l = l->next) {
+    if (!gtk_tree_model_iter_children(mdl, &child, l->data)) continue;
+
+    do {
+      show_bars(mdl, NULL, &child, NULL);
+    } while (gtk_tree_model_iter_next(mdl, &child));
+  }
+
+  g_slist_free_full(ancestors, (GDestroyNotify)gtk_tree_iter_free);
+}
+
 void message(const gchar *primary_msg, const gchar *secondary_msg,
              GtkMessageType type, GtkWidget *parent) {
   GtkWidget *dialog;
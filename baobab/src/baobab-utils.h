@@ -26,8 +26,10 @@ void baobab_get_filesystem(BaobabFS *fs);
 gchar *dir_select(gboolean, GtkWidget *);
 void on_toggled(GtkToggleButton *, gpointer);
 void stop_scan(void);
+gchar *baobab_format_estimate(guint64 size, gdouble error);
 gboolean show_bars(GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter,
                    gpointer data);
+void remove_folder_row(GtkTreeModel *model, GtkTreeIter *iter);
 void message(const gchar *primary_msg, const gchar *secondary_msg,
              GtkMessageType type, GtkWidget *parent);
 gint messageyesno(const gchar *primary_msg, const gchar *secondary_msg,
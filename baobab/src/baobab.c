@@ -51,6 +51,10 @@ static GtkTreeIter currentiter;
 static GtkTreeIter firstiter;
 static GQueue *iterstack = NULL;
 
+/* rows filled by the estimate pass and not yet refined by the exact scan,
+ * indexed by parse name */
+static GHashTable *estimated_rows = NULL;
+
 enum { DND_TARGET_URI_LIST };
 
 static GtkTargetEntry dnd_target_list[] = {
@@ -141,6 +145,9 @@ static void check_menu_sens(gboolean scanning) {
                            !scanning && has_current_location);
   gtk_action_set_sensitive(GET_ACTION("preferenze1"), !scanning);
   gtk_action_set_sensitive(GET_ACTION("menu_scan_rem"), !scanning);
+  gtk_action_set_sensitive(GET_ACTION("menu_save_snapshot"),
+                           !scanning && has_current_location);
+  gtk_action_set_sensitive(GET_ACTION("menu_compare_snapshots"), !scanning);
   gtk_action_set_sensitive(GET_ACTION("ck_allocated"),
                            !scanning && baobab.is_local);
 
@@ -187,6 +194,74 @@ void baobab_update_filesystem(void) {
   update_scan_label();
 }
 
+static void remove_stale_estimates(void) {
+  GHashTableIter hash_iter;
+  gpointer value;
+
+  g_hash_table_iter_init(&hash_iter, estimated_rows);
+  while (g_hash_table_iter_next(&hash_iter, NULL, &value)) {
+    GtkTreePath *path;
+    GtkTreeIter iter;
+
+    path = gtk_tree_row_reference_get_path(value);
+    if (path == NULL) continue;
+
+    if (gtk_tree_model_get_iter(GTK_TREE_MODEL(baobab.model), &iter, path))
+      gtk_tree_store_remove(baobab.model, &iter);
+
+    gtk_tree_path_free(path);
+  }
+}
+
+/* quick sampled pass, the rows are then refined by the exact scan */
+static void scan_estimate(GFile *file) {
+  estimated_rows = g_hash_table_new_full(
+      g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify)gtk_tree_row_reference_free);
+
+  baobab_set_statusbar(_("Estimating..."));
+  baobab_scan_estimate(file);
+
+  if (baobab.STOP_SCANNING) return;
+
+  /* let the charts draw the estimate while the exact scan runs */
+  gtk_tree_model_foreach(GTK_TREE_MODEL(baobab.model), show_bars, NULL);
+  baobab_chart_set_max_depth(baobab.rings_chart, baobab.model_max_depth);
+  baobab_chart_set_max_depth(baobab.treemap_chart, baobab.model_max_depth);
+  baobab_chart_thaw_updates(baobab.rings_chart);
+  baobab_chart_thaw_updates(baobab.treemap_chart);
+  while (gtk_events_pending()) gtk_main_iteration();
+  baobab_chart_freeze_updates(baobab.rings_chart);
+  baobab_chart_freeze_updates(baobab.treemap_chart);
+
+  baobab_set_statusbar(_("Scanning..."));
+
+  /* the exact scan walks the tree again from the root */
+  currentdepth = -1;
+  g_queue_clear(iterstack);
+}
+
+/* returns the row left by the estimate pass for this folder, if any */
+static gboolean lookup_estimated_row(const gchar *parse_name,
+                                     GtkTreeIter *iter) {
+  GtkTreeRowReference *ref;
+  GtkTreePath *path;
+  gboolean ret;
+
+  if (estimated_rows == NULL || parse_name == NULL) return FALSE;
+
+  ref = g_hash_table_lookup(estimated_rows, parse_name);
+  if (ref == NULL) return FALSE;
+
+  path = gtk_tree_row_reference_get_path(ref);
+  if (path == NULL) return FALSE;
+
+  ret = gtk_tree_model_get_iter(GTK_TREE_MODEL(baobab.model), iter, path);
+  gtk_tree_path_free(path);
+
+  return ret;
+}
+
 void baobab_scan_location(GFile *file) {
   GtkToggleAction *ck_allocated;
 
@@ -216,7 +291,19 @@ void baobab_scan_location(GFile *file) {
     gtk_action_set_sensitive(GTK_ACTION(ck_allocated), TRUE);
   }
 
-  baobab_scan_execute(file);
+  if (g_settings_get_boolean(baobab.prefs_settings,
+                             BAOBAB_SETTINGS_ESTIMATE_FIRST))
+    scan_estimate(file);
+
+  if (!baobab.STOP_SCANNING) baobab_scan_execute(file);
+
+  if (estimated_rows != NULL) {
+    /* a completed scan leaves only the folders that went away */
+    if (!baobab.STOP_SCANNING) remove_stale_estimates();
+
+    g_hash_table_destroy(estimated_rows);
+    estimated_rows = NULL;
+  }
 
   /* set statusbar, percentage and allocated/normal size */
   baobab_set_statusbar(_("Calculating percentage bars..."));
@@ -271,13 +358,46 @@ void baobab_stop_scan(void) {
   gtk_tree_view_columns_autosize(GTK_TREE_VIEW(baobab.tree_view));
 }
 
+static void prefill_row(GtkTreeIter *iter, struct chan_data *data) {
+  char *name;
+  char *str;
+
+  /* in case filenames contains gmarkup */
+  name = g_markup_escape_text(data->display_name, -1);
+
+  str = g_strdup_printf("<small><i>%s</i></small>", _("Scanning..."));
+
+  gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(baobab.tree_view), TRUE);
+  gtk_tree_store_set(baobab.model, iter, COL_DIR_NAME, name, COL_H_PARSENAME,
+                     "", COL_H_ELEMENTS, -1, COL_H_PERC, -1.0, COL_DIR_SIZE,
+                     str, COL_ELEMENTS, str, -1);
+
+  g_free(name);
+  g_free(str);
+}
+
 /*
  * pre-fills model during scanning
  */
 static void prefill_model(struct chan_data *data) {
   GtkTreeIter iter, iterparent;
-  char *name;
-  char *str;
+
+  /* the exact scan reuses the rows of the estimate pass, which are
+   * already at the right place in the tree and keep their estimate
+   * until they are refined */
+  if (!data->estimated && lookup_estimated_row(data->parse_name, &iter)) {
+    if (data->depth == 0) firstiter = iter;
+
+    currentdepth = data->depth;
+    push_iter_in_stack(&iter);
+    currentiter = iter;
+
+    while (gtk_events_pending()) {
+      gtk_main_iteration();
+    }
+
+    return;
+  }
 
   if (currentdepth == -1) {
     gtk_tree_store_append(baobab.model, &iter, NULL);
@@ -311,18 +431,7 @@ static void prefill_model(struct chan_data *data) {
   push_iter_in_stack(&iter);
   currentiter = iter;
 
-  /* in case filenames contains gmarkup */
-  name = g_markup_escape_text(data->display_name, -1);
-
-  str = g_strdup_printf("<small><i>%s</i></small>", _("Scanning..."));
-
-  gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(baobab.tree_view), TRUE);
-  gtk_tree_store_set(baobab.model, &iter, COL_DIR_NAME, name, COL_H_PARSENAME,
-                     "", COL_H_ELEMENTS, -1, COL_H_PERC, -1.0, COL_DIR_SIZE,
-                     str, COL_ELEMENTS, str, -1);
-
-  g_free(name);
-  g_free(str);
+  prefill_row(&iter, data);
 
   while (gtk_events_pending()) {
     gtk_main_iteration();
@@ -374,22 +483,13 @@ static void first_row(void) {
   gtk_tree_view_expand_all(GTK_TREE_VIEW(baobab.tree_view));
 }
 
-/* fills model during scanning */
-void baobab_fill_model(struct chan_data *data) {
-  GtkTreeIter iter;
+static void fill_row(GtkTreeIter *iter, struct chan_data *data) {
   GString *hardlinks;
   GString *elements;
   char *name;
   char *size;
   char *alloc_size;
 
-  if (data->elements == -1) {
-    prefill_model(data);
-    return;
-  }
-
-  iter = pop_iter_from_stack();
-
   /* in case filenames contains gmarkup */
   name = g_markup_escape_text(data->display_name, -1);
 
@@ -412,17 +512,34 @@ void baobab_fill_model(struct chan_data *data) {
   size = g_format_size(data->size);
   alloc_size = g_format_size(data->alloc_size);
 
-  gtk_tree_store_set(baobab.model, &iter, COL_DIR_NAME, name, COL_H_PARSENAME,
+  if (data->estimated) {
+    g_free(size);
+    g_free(alloc_size);
+    size = baobab_format_estimate(data->size, data->estimate_error);
+    alloc_size = baobab_format_estimate(data->alloc_size, data->estimate_error);
+
+    if (estimated_rows != NULL) {
+      GtkTreePath *path;
+
+      path = gtk_tree_model_get_path(GTK_TREE_MODEL(baobab.model), iter);
+      g_hash_table_replace(
+          estimated_rows, g_strdup(data->parse_name),
+          gtk_tree_row_reference_new(GTK_TREE_MODEL(baobab.model), path));
+      gtk_tree_path_free(path);
+    }
+  } else if (estimated_rows != NULL) {
+    g_hash_table_remove(estimated_rows, data->parse_name);
+  }
+
+  gtk_tree_store_set(baobab.model, iter, COL_DIR_NAME, name, COL_H_PARSENAME,
                      data->parse_name, COL_H_PERC, -1.0, COL_DIR_SIZE,
                      baobab.show_allocated ? alloc_size : size, COL_H_SIZE,
                      data->size, COL_ELEMENTS, elements->str, COL_H_ELEMENTS,
                      data->elements, COL_HARDLINK, hardlinks->str,
                      COL_H_HARDLINK, data->tempHLsize, COL_H_ALLOCSIZE,
-                     data->alloc_size, -1);
-
-  while (gtk_events_pending()) {
-    gtk_main_iteration();
-  }
+                     data->alloc_size, COL_H_AGE, data->age, COL_H_ESTIMATED,
+                     data->estimated, COL_H_ESTIMATE_ERROR,
+                     data->estimate_error, -1);
 
   g_string_free(hardlinks, TRUE);
   g_string_free(elements, TRUE);
@@ -431,6 +548,53 @@ void baobab_fill_model(struct chan_data *data) {
   g_free(alloc_size);
 }
 
+/* fills model during scanning */
+void baobab_fill_model(struct chan_data *data) {
+  GtkTreeIter iter;
+
+  if (data->elements == -1) {
+    prefill_model(data);
+    return;
+  }
+
+  iter = pop_iter_from_stack();
+  fill_row(&iter, data);
+
+  while (gtk_events_pending()) {
+    gtk_main_iteration();
+  }
+}
+
+/*
+ * same as baobab_fill_model, but for scans that do not visit the folders
+ * depth-first: the prefill appends the row under parent (NULL for the
+ * root of the scan) and returns it in iter, the fill updates iter.
+ */
+void baobab_fill_model_at(struct chan_data *data, GtkTreeIter *parent,
+                          GtkTreeIter *iter) {
+  if (data->elements != -1) {
+    fill_row(iter, data);
+  } else if (!lookup_estimated_row(data->parse_name, iter)) {
+    gtk_tree_store_append(baobab.model, iter, parent);
+
+    if (parent != NULL && data->depth == 1) {
+      GtkTreePath *path;
+
+      path = gtk_tree_model_get_path(GTK_TREE_MODEL(baobab.model), parent);
+      gtk_tree_view_expand_row(GTK_TREE_VIEW(baobab.tree_view), path, FALSE);
+      gtk_tree_path_free(path);
+    }
+
+    prefill_row(iter, data);
+  }
+
+  if (data->depth == 0) firstiter = *iter;
+
+  while (gtk_events_pending()) {
+    gtk_main_iteration();
+  }
+}
+
 void push_iter_in_stack(GtkTreeIter *iter) {
   g_queue_push_head(iterstack, iter->user_data3);
   g_queue_push_head(iterstack, iter->user_data2);
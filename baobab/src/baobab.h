@@ -26,6 +26,8 @@
 #include <sys/types.h>
 #include <time.h>
 
+#include "baobab-age.h"
+
 struct BaobabSearchOpt;
 
 /* Settings */
@@ -37,6 +39,8 @@ struct BaobabSearchOpt;
 #define BAOBAB_SETTINGS_ACTIVE_CHART "active-chart"
 #define BAOBAB_SETTINGS_MONITOR_HOME "monitor-home"
 #define BAOBAB_SETTINGS_EXCLUDED_URIS "excluded-uris"
+#define BAOBAB_SETTINGS_ESTIMATE_FIRST "estimate-first"
+#define BAOBAB_SETTINGS_BREADTH_FIRST "breadth-first"
 
 typedef struct _BaobabChartMenu BaobabChartMenu;
 
@@ -106,6 +110,9 @@ struct chan_data {
   gint elements;
   gchar *display_name;
   gchar *parse_name;
+  BaobabAgeHistogram *age;
+  gboolean estimated;
+  gdouble estimate_error;
 };
 
 void baobab_set_busy(gboolean busy);
@@ -116,6 +123,8 @@ void baobab_scan_root(void);
 void baobab_rescan_current_dir(void);
 void baobab_stop_scan(void);
 void baobab_fill_model(struct chan_data *);
+void baobab_fill_model_at(struct chan_data *, GtkTreeIter *parent,
+                          GtkTreeIter *iter);
 gboolean baobab_is_excluded_location(GFile *);
 void baobab_set_toolbar_visible(gboolean visible);
 void baobab_set_statusbar_visible(gboolean visible);
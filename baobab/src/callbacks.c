@@ -29,6 +29,7 @@
 #include "baobab-chart.h"
 #include "baobab-prefs.h"
 #include "baobab-remote-connect-dialog.h"
+#include "baobab-snapshot.h"
 #include "baobab-treeview.h"
 #include "baobab-utils.h"
 #include "baobab.h"
@@ -141,6 +142,14 @@ void on_menu_scan_rem_activate(GtkMenuItem *menuitem, gpointer user_data) {
   on_tb_scan_remote_clicked(NULL, NULL);
 }
 
+void on_menu_save_snapshot_activate(GtkAction *a, gpointer user_data) {
+  baobab_snapshot_save_dialog();
+}
+
+void on_menu_compare_snapshots_activate(GtkAction *a, gpointer user_data) {
+  baobab_snapshot_compare_dialog();
+}
+
 void on_tbstop_clicked(GtkToolButton *toolbutton, gpointer user_data) {
   baobab_stop_scan();
 }
@@ -184,13 +193,11 @@ void trash_dir_cb(GtkMenuItem *pmenu, gpointer dummy) {
 
   if (trash_file(file)) {
     GtkTreeIter iter;
-    guint64 filesize;
     GtkTreeSelection *selection;
 
     selection = gtk_tree_view_get_selection((GtkTreeView *)baobab.tree_view);
-    gtk_tree_selection_get_selected(selection, NULL, &iter);
-    gtk_tree_model_get((GtkTreeModel *)baobab.model, &iter, 5, &filesize, -1);
-    gtk_tree_store_remove(GTK_TREE_STORE(baobab.model), &iter);
+    if (gtk_tree_selection_get_selected(selection, NULL, &iter))
+      remove_folder_row(GTK_TREE_MODEL(baobab.model), &iter);
   }
 
   g_object_unref(file);
@@ -49,6 +49,8 @@ void list_all_cb(GtkMenuItem *pmenu, gpointer dummy);
 void on_pref_menu(GtkAction *a, gpointer user_data);
 void on_tb_scan_remote_clicked(GtkToolButton *toolbutton, gpointer user_data);
 void on_menu_scan_rem_activate(GtkMenuItem *menuitem, gpointer user_data);
+void on_menu_save_snapshot_activate(GtkAction *a, gpointer user_data);
+void on_menu_compare_snapshots_activate(GtkAction *a, gpointer user_data);
 void on_ck_allocated_activate(GtkToggleAction *action, gpointer user_data);
 void on_helpcontents_activate(GtkAction *a, gpointer user_data);
 void on_tv_selection_changed(GtkTreeSelection *selection, gpointer user_data);
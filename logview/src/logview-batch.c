@@ -0,0 +1,350 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib/gi18n.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "logview-batch.h"
+#include "logview-filter-engine.h"
+#include "logview-log.h"
+#include "logview-prefs.h"
+#include "logview-utils.h"
+
+/* The batch mode goes through logs without showing them: the lines
+ * that match any of the saved filters given, or all of them, are
+ * printed on the standard output, optionally only those of a day. As
+ * in the window, a line that matches a filter whose tag is invisible
+ * is hidden; if all the filters given are, the other lines are all
+ * printed. The logs are read one after the other, by the same code as
+ * the window, so that the time each step takes can be reported too.
+ */
+
+typedef struct {
+  char **log_files;
+  guint current;
+
+  GList *filters;
+  guint n_filters;
+  GArray *invisible;
+  gboolean has_visible;
+  GDate *day;
+  gboolean timing;
+
+  LogviewLog *log;
+  LogviewFilterEngine *engine;
+  gulong filtered_id;
+  gboolean read_failed;
+  gint64 start_time;
+
+  GMainLoop *loop;
+  int status;
+} BatchJob;
+
+static void batch_next_log(BatchJob *job);
+
+static void batch_report_time(BatchJob *job, const char *step, guint n_lines) {
+  gint64 now;
+
+  if (!job->timing) {
+    return;
+  }
+
+  now = g_get_monotonic_time();
+
+  /* on stderr, not to mix with the lines */
+  g_printerr("%s: %s %u lines in %.3f s\n",
+             logview_log_get_display_name(job->log), step, n_lines,
+             (now - job->start_time) / (double)G_USEC_PER_SEC);
+
+  job->start_time = now;
+}
+
+/* the same rule as the window, which only shows the matches */
+static gboolean batch_line_is_printed(BatchJob *job, guint line) {
+  gboolean matched;
+  guint i;
+
+  if (job->engine == NULL) {
+    return TRUE;
+  }
+
+  matched = !job->has_visible;
+
+  for (i = 0; i < job->n_filters; i++) {
+    if (logview_filter_engine_get_match(job->engine, i, line)) {
+      if (g_array_index(job->invisible, gboolean, i)) {
+        return FALSE;
+      }
+
+      matched = TRUE;
+    }
+  }
+
+  return matched;
+}
+
+static void batch_print_range(BatchJob *job, guint first, guint last,
+                              guint *n_printed) {
+  const char *text;
+  gboolean prefix;
+  gsize len;
+  guint line;
+
+  prefix = (g_strv_length(job->log_files) > 1);
+
+  for (line = first; line <= last; line++) {
+    text = batch_line_is_printed(job, line)
+               ? logview_log_get_line(job->log, line, &len)
+               : NULL;
+
+    if (text == NULL) {
+      continue;
+    }
+
+    /* like grep does for several files */
+    if (prefix) {
+      fputs(logview_log_get_display_name(job->log), stdout);
+      fputs(": ", stdout);
+    }
+
+    fwrite(text, 1, len, stdout);
+    fputc('\n', stdout);
+    (*n_printed)++;
+  }
+}
+
+/* the lines of the log are all read and filtered */
+static gboolean batch_print_lines(gpointer user_data) {
+  BatchJob *job = user_data;
+  guint n_lines, n_printed = 0;
+  GSList *l;
+  Day *day;
+
+  n_lines = logview_log_get_cached_lines_number(job->log);
+
+  if (job->day == NULL) {
+    if (n_lines > 0) {
+      batch_print_range(job, 0, n_lines - 1, &n_printed);
+    }
+  } else {
+    for (l = logview_log_get_days_for_cached_lines(job->log); l != NULL;
+         l = l->next) {
+      day = l->data;
+
+      if (g_date_compare(day->date, job->day) == 0) {
+        batch_print_range(job, day->first_line, day->last_line, &n_printed);
+      }
+    }
+  }
+
+  fflush(stdout);
+  batch_report_time(job, "printed", n_printed);
+
+  batch_next_log(job);
+
+  return FALSE;
+}
+
+static void lines_filtered_cb(LogviewFilterEngine *engine, guint first_line,
+                              guint n_lines, gpointer user_data) {
+  BatchJob *job = user_data;
+  guint n_cached;
+
+  n_cached = logview_log_get_cached_lines_number(job->log);
+
+  if (logview_filter_engine_get_n_filtered(engine) < n_cached) {
+    return;
+  }
+
+  batch_report_time(job, "filtered", n_cached);
+
+  /* not while the engine is emitting */
+  g_signal_handler_disconnect(engine, job->filtered_id);
+  job->filtered_id = 0;
+  g_idle_add(batch_print_lines, job);
+}
+
+static void read_new_lines_cb(LogviewLog *log, guint first_line,
+                              guint n_lines, GSList *new_days, GError *error,
+                              gpointer user_data) {
+  BatchJob *job = user_data;
+
+  if (error != NULL) {
+    g_printerr(_("Can't read from \"%s\": %s\n"),
+               logview_log_get_display_name(log), error->message);
+    job->read_failed = TRUE;
+  }
+}
+
+static void read_done(gpointer user_data) {
+  BatchJob *job = user_data;
+  guint n_lines;
+
+  if (job->read_failed) {
+    job->status = EXIT_FAILURE;
+    batch_next_log(job);
+    return;
+  }
+
+  n_lines = logview_log_get_cached_lines_number(job->log);
+  batch_report_time(job, "read", n_lines);
+
+  if (job->filters == NULL || n_lines == 0) {
+    batch_print_lines(job);
+    return;
+  }
+
+  /* the same engine as the window, the lines are filtered in threads */
+  job->engine = logview_filter_engine_new();
+  job->filtered_id = g_signal_connect(job->engine, "lines-filtered",
+                                      G_CALLBACK(lines_filtered_cb), job);
+  logview_filter_engine_start(job->engine, job->log, job->filters, n_lines);
+}
+
+static void create_log_cb(LogviewLog *log, GError *error,
+                          gpointer user_data) {
+  BatchJob *job = user_data;
+
+  if (log == NULL) {
+    g_printerr(_("Impossible to open the file %s: %s\n"),
+               job->log_files[job->current - 1], error->message);
+    job->status = EXIT_FAILURE;
+    batch_next_log(job);
+    return;
+  }
+
+  job->log = log;
+  job->read_failed = FALSE;
+
+  logview_log_read_new_lines_full(log, NULL, read_new_lines_cb, read_done,
+                                  job);
+}
+
+static void batch_next_log(BatchJob *job) {
+  if (job->engine != NULL) {
+    g_clear_signal_handler(&job->filtered_id, job->engine);
+    g_clear_object(&job->engine);
+  }
+
+  g_clear_object(&job->log);
+
+  if (job->log_files[job->current] == NULL) {
+    g_main_loop_quit(job->loop);
+    return;
+  }
+
+  job->start_time = g_get_monotonic_time();
+  logview_log_create(job->log_files[job->current++], create_log_cb, job);
+}
+
+static GDate *parse_day(const char *text) {
+  GDate *date;
+  int year, month, day;
+
+  if (sscanf(text, "%d-%d-%d", &year, &month, &day) != 3 ||
+      !g_date_valid_dmy((GDateDay)day, (GDateMonth)month, (GDateYear)year)) {
+    return NULL;
+  }
+
+  date = g_date_new_dmy((GDateDay)day, (GDateMonth)month, (GDateYear)year);
+
+  return date;
+}
+
+/**
+ * logview_batch_run:
+ *
+ * @log_files: the logs to go through.
+ * @filter_names: the names of saved filters, or %NULL to print all the
+ *   lines.
+ * @day: a day as YYYY-MM-DD to print only its lines, or %NULL.
+ * @timing: whether to report on stderr how long each step took.
+ *
+ * Prints the lines of @log_files that match any of @filter_names, but
+ * for those that match an invisible filter, for scripts and for
+ * measuring the reader and the filters.
+ *
+ * Returns: the exit status of the program.
+ */
+int logview_batch_run(char **log_files, char **filter_names,
+                      const char *day, gboolean timing) {
+  LogviewPrefs *prefs;
+  LogviewFilter *filter;
+  GtkTextTag *tag;
+  BatchJob job = {0};
+  gboolean invisible;
+  int i;
+
+  if (log_files == NULL || log_files[0] == NULL) {
+    g_printerr(_("No log given to read\n"));
+    return EXIT_FAILURE;
+  }
+
+  if (day != NULL && (job.day = parse_day(day)) == NULL) {
+    g_printerr(_("Invalid day %s, it should be YYYY-MM-DD\n"), day);
+    return EXIT_FAILURE;
+  }
+
+  prefs = logview_prefs_get();
+  job.invisible = g_array_new(FALSE, FALSE, sizeof(gboolean));
+
+  for (i = 0; filter_names != NULL && filter_names[i] != NULL; i++) {
+    filter = logview_prefs_get_filter(prefs, filter_names[i]);
+
+    if (filter == NULL) {
+      g_printerr(_("No saved filter is called %s\n"), filter_names[i]);
+      job.status = EXIT_FAILURE;
+      goto out;
+    }
+
+    invisible = FALSE;
+    tag = logview_filter_get_tag(filter);
+
+    if (tag != NULL) {
+      g_object_get(tag, "invisible", &invisible, NULL);
+    }
+
+    job.filters = g_list_append(job.filters, filter);
+    job.n_filters++;
+    g_array_append_val(job.invisible, invisible);
+    job.has_visible |= !invisible;
+  }
+
+  job.log_files = log_files;
+  job.timing = timing;
+  job.status = EXIT_SUCCESS;
+  job.loop = g_main_loop_new(NULL, FALSE);
+
+  batch_next_log(&job);
+  g_main_loop_run(job.loop);
+
+  g_main_loop_unref(job.loop);
+
+out:
+  g_list_free(job.filters);
+  g_array_unref(job.invisible);
+  g_clear_pointer(&job.day, g_date_free);
+
+  return job.status;
+}
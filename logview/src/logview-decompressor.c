@@ -0,0 +1,704 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib/gi18n.h>
+
+#ifdef HAVE_BZIP2
+#include <bzlib.h>
+#endif
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "logview-decompressor.h"
+
+/* Compressed logs are read through a GConverter, like gzip ones are
+ * through GZlibDecompressor, so that the reader never needs to hold an
+ * uncompressed log as a whole. Rotated logs can be the concatenation of
+ * several compressed streams (or zstd frames), which are decoded as a
+ * single log.
+ */
+
+LogviewCompression logview_compression_detect(const char *data, gsize len) {
+  const guchar *magic = (const guchar *)data;
+
+  if (len >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+    return LOGVIEW_COMPRESSION_GZIP;
+  }
+
+  /* "BZh" is printable, so check the magic of the first block (or of
+   * the end of an empty stream) too */
+  if (len >= 10 && memcmp(magic, "BZh", 3) == 0 && magic[3] >= '1' &&
+      magic[3] <= '9' &&
+      (memcmp(magic + 4, "\x31\x41\x59\x26\x53\x59", 6) == 0 ||
+       memcmp(magic + 4, "\x17\x72\x45\x38\x50\x90", 6) == 0)) {
+    return LOGVIEW_COMPRESSION_BZIP2;
+  }
+
+  if (len >= 6 && memcmp(magic, "\xfd\x37\x7a\x58\x5a\x00", 6) == 0) {
+    return LOGVIEW_COMPRESSION_XZ;
+  }
+
+  /* a zstd frame, or a skippable frame as written by pzstd */
+  if (len >= 4 && ((memcmp(magic, "\x28\xb5\x2f\xfd", 4) == 0) ||
+                   ((magic[0] & 0xf0) == 0x50 &&
+                    memcmp(magic + 1, "\x2a\x4d\x18", 3) == 0))) {
+    return LOGVIEW_COMPRESSION_ZSTD;
+  }
+
+  return LOGVIEW_COMPRESSION_NONE;
+}
+
+const char *logview_compression_get_name(LogviewCompression compression) {
+  switch (compression) {
+    case LOGVIEW_COMPRESSION_GZIP:
+      return "gzip";
+    case LOGVIEW_COMPRESSION_BZIP2:
+      return "bzip2";
+    case LOGVIEW_COMPRESSION_XZ:
+      return "xz";
+    case LOGVIEW_COMPRESSION_ZSTD:
+      return "zstd";
+    case LOGVIEW_COMPRESSION_NONE:
+    default:
+      return NULL;
+  }
+}
+
+gboolean logview_compression_is_supported(LogviewCompression compression) {
+  switch (compression) {
+    case LOGVIEW_COMPRESSION_NONE:
+      return TRUE;
+#ifdef HAVE_ZLIB
+    case LOGVIEW_COMPRESSION_GZIP:
+      return TRUE;
+#endif
+#ifdef HAVE_BZIP2
+    case LOGVIEW_COMPRESSION_BZIP2:
+      return TRUE;
+#endif
+#ifdef HAVE_LZMA
+    case LOGVIEW_COMPRESSION_XZ:
+      return TRUE;
+#endif
+#ifdef HAVE_ZSTD
+    case LOGVIEW_COMPRESSION_ZSTD:
+      return TRUE;
+#endif
+    default:
+      return FALSE;
+  }
+}
+
+static void set_corrupt_error(GError **error) {
+  g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                      _("Invalid compressed data"));
+}
+
+/* the bzip2, xz and zstd converter */
+
+typedef struct {
+  GObject parent;
+
+  LogviewCompression compression;
+
+  /* set at the end of a compressed stream, which might be followed by
+   * another one */
+  gboolean at_boundary;
+
+#ifdef HAVE_BZIP2
+  bz_stream bz;
+#endif
+#ifdef HAVE_LZMA
+  lzma_stream lzma;
+#endif
+#ifdef HAVE_ZSTD
+  ZSTD_DStream *zstd;
+#endif
+} LogviewDecompressor;
+
+typedef struct {
+  GObjectClass parent_class;
+} LogviewDecompressorClass;
+
+static void logview_decompressor_iface_init(GConverterIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(LogviewDecompressor, logview_decompressor,
+                        G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(G_TYPE_CONVERTER,
+                                              logview_decompressor_iface_init))
+
+static void decompressor_begin(LogviewDecompressor *self) {
+  self->at_boundary = FALSE;
+
+  switch (self->compression) {
+#ifdef HAVE_BZIP2
+    case LOGVIEW_COMPRESSION_BZIP2:
+      memset(&self->bz, 0, sizeof(bz_stream));
+      BZ2_bzDecompressInit(&self->bz, 0, 0);
+      break;
+#endif
+#ifdef HAVE_LZMA
+    case LOGVIEW_COMPRESSION_XZ: {
+      lzma_stream init = LZMA_STREAM_INIT;
+
+      self->lzma = init;
+      lzma_stream_decoder(&self->lzma, UINT64_MAX, LZMA_CONCATENATED);
+      break;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    case LOGVIEW_COMPRESSION_ZSTD:
+      self->zstd = ZSTD_createDStream();
+      ZSTD_initDStream(self->zstd);
+      break;
+#endif
+    default:
+      break;
+  }
+}
+
+static void decompressor_end(LogviewDecompressor *self) {
+  switch (self->compression) {
+#ifdef HAVE_BZIP2
+    case LOGVIEW_COMPRESSION_BZIP2:
+      BZ2_bzDecompressEnd(&self->bz);
+      break;
+#endif
+#ifdef HAVE_LZMA
+    case LOGVIEW_COMPRESSION_XZ:
+      lzma_end(&self->lzma);
+      break;
+#endif
+#ifdef HAVE_ZSTD
+    case LOGVIEW_COMPRESSION_ZSTD:
+      g_clear_pointer(&self->zstd, ZSTD_freeDStream);
+      break;
+#endif
+    default:
+      break;
+  }
+}
+
+#ifdef HAVE_BZIP2
+static gboolean bzip2_convert(LogviewDecompressor *self, const void *inbuf,
+                              gsize inbuf_size, void *outbuf,
+                              gsize outbuf_size, gsize *bytes_read,
+                              gsize *bytes_written, gboolean *stream_end,
+                              GError **error) {
+  int ret;
+
+  if (self->at_boundary) {
+    /* libbz2 needs a new decoder for the next stream */
+    decompressor_end(self);
+    decompressor_begin(self);
+  }
+
+  self->bz.next_in = (char *)inbuf;
+  self->bz.avail_in = (unsigned int)MIN(inbuf_size, G_MAXUINT);
+  self->bz.next_out = outbuf;
+  self->bz.avail_out = (unsigned int)MIN(outbuf_size, G_MAXUINT);
+
+  ret = BZ2_bzDecompress(&self->bz);
+
+  *bytes_read = self->bz.next_in - (char *)inbuf;
+  *bytes_written = self->bz.next_out - (char *)outbuf;
+
+  if (ret == BZ_STREAM_END) {
+    *stream_end = TRUE;
+  } else if (ret != BZ_OK) {
+    set_corrupt_error(error);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+#endif /* HAVE_BZIP2 */
+
+#ifdef HAVE_LZMA
+static gboolean xz_convert(LogviewDecompressor *self, const void *inbuf,
+                           gsize inbuf_size, void *outbuf, gsize outbuf_size,
+                           gboolean at_end, gsize *bytes_read,
+                           gsize *bytes_written, gboolean *stream_end,
+                           GError **error) {
+  lzma_ret ret;
+
+  self->lzma.next_in = inbuf;
+  self->lzma.avail_in = inbuf_size;
+  self->lzma.next_out = outbuf;
+  self->lzma.avail_out = outbuf_size;
+
+  /* liblzma handles concatenated streams itself, and only reports the
+   * end once told there's no more input */
+  ret = lzma_code(&self->lzma, at_end ? LZMA_FINISH : LZMA_RUN);
+
+  *bytes_read = inbuf_size - self->lzma.avail_in;
+  *bytes_written = outbuf_size - self->lzma.avail_out;
+
+  if (ret == LZMA_STREAM_END) {
+    *stream_end = TRUE;
+  } else if (ret != LZMA_OK && ret != LZMA_BUF_ERROR) {
+    set_corrupt_error(error);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+#endif /* HAVE_LZMA */
+
+#ifdef HAVE_ZSTD
+static gboolean zstd_convert(LogviewDecompressor *self, const void *inbuf,
+                             gsize inbuf_size, void *outbuf,
+                             gsize outbuf_size, gsize *bytes_read,
+                             gsize *bytes_written, gboolean *stream_end,
+                             GError **error) {
+  ZSTD_inBuffer in = {inbuf, inbuf_size, 0};
+  ZSTD_outBuffer out = {outbuf, outbuf_size, 0};
+  size_t ret;
+
+  /* the decoder goes on with the next frame by itself */
+  ret = ZSTD_decompressStream(self->zstd, &out, &in);
+
+  if (ZSTD_isError(ret)) {
+    set_corrupt_error(error);
+    return FALSE;
+  }
+
+  *bytes_read = in.pos;
+  *bytes_written = out.pos;
+  *stream_end = (ret == 0);
+
+  return TRUE;
+}
+#endif /* HAVE_ZSTD */
+
+static GConverterResult logview_decompressor_convert(
+    GConverter *converter, const void *inbuf, gsize inbuf_size, void *outbuf,
+    gsize outbuf_size, GConverterFlags flags, gsize *bytes_read,
+    gsize *bytes_written, GError **error) {
+  LogviewDecompressor *self = (LogviewDecompressor *)converter;
+  gboolean at_end, stream_end, res;
+
+  at_end = (flags & G_CONVERTER_INPUT_AT_END) != 0;
+  stream_end = FALSE;
+  res = FALSE;
+
+  *bytes_read = 0;
+  *bytes_written = 0;
+
+  /* only the end of the input ends the log */
+  if (self->at_boundary && inbuf_size == 0) {
+    if (at_end) {
+      return G_CONVERTER_FINISHED;
+    }
+
+    g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+                        _("Need more input"));
+    return G_CONVERTER_ERROR;
+  }
+
+  switch (self->compression) {
+#ifdef HAVE_BZIP2
+    case LOGVIEW_COMPRESSION_BZIP2:
+      res = bzip2_convert(self, inbuf, inbuf_size, outbuf, outbuf_size,
+                          bytes_read, bytes_written, &stream_end, error);
+      break;
+#endif
+#ifdef HAVE_LZMA
+    case LOGVIEW_COMPRESSION_XZ:
+      res = xz_convert(self, inbuf, inbuf_size, outbuf, outbuf_size, at_end,
+                       bytes_read, bytes_written, &stream_end, error);
+      break;
+#endif
+#ifdef HAVE_ZSTD
+    case LOGVIEW_COMPRESSION_ZSTD:
+      res = zstd_convert(self, inbuf, inbuf_size, outbuf, outbuf_size,
+                         bytes_read, bytes_written, &stream_end, error);
+      break;
+#endif
+    default:
+      g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                          _("Unsupported compression format"));
+      break;
+  }
+
+  if (!res) {
+    return G_CONVERTER_ERROR;
+  }
+
+  if (stream_end) {
+    self->at_boundary = TRUE;
+
+    if (at_end && *bytes_read == inbuf_size) {
+      return G_CONVERTER_FINISHED;
+    }
+  } else if (*bytes_read > 0 || *bytes_written > 0) {
+    self->at_boundary = FALSE;
+  }
+
+  if (*bytes_read == 0 && *bytes_written == 0) {
+    if (stream_end && self->compression == LOGVIEW_COMPRESSION_BZIP2) {
+      /* the end was all that was left, go on with the next stream */
+      return logview_decompressor_convert(converter, inbuf, inbuf_size,
+                                          outbuf, outbuf_size, flags,
+                                          bytes_read, bytes_written, error);
+    }
+
+    if (at_end) {
+      set_corrupt_error(error);
+    } else {
+      g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+                          _("Need more input"));
+    }
+
+    return G_CONVERTER_ERROR;
+  }
+
+  return G_CONVERTER_CONVERTED;
+}
+
+static void logview_decompressor_reset(GConverter *converter) {
+  LogviewDecompressor *self = (LogviewDecompressor *)converter;
+
+  decompressor_end(self);
+  decompressor_begin(self);
+}
+
+static void logview_decompressor_finalize(GObject *object) {
+  decompressor_end((LogviewDecompressor *)object);
+
+  G_OBJECT_CLASS(logview_decompressor_parent_class)->finalize(object);
+}
+
+static void logview_decompressor_iface_init(GConverterIface *iface) {
+  iface->convert = logview_decompressor_convert;
+  iface->reset = logview_decompressor_reset;
+}
+
+static void logview_decompressor_class_init(LogviewDecompressorClass *klass) {
+  GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+  object_class->finalize = logview_decompressor_finalize;
+}
+
+static void logview_decompressor_init(LogviewDecompressor *self) {}
+
+/**
+ * logview_decompressor_new:
+ *
+ * @compression: a #LogviewCompression.
+ *
+ * Returns: a new #GConverter uncompressing @compression, or %NULL if
+ *   the format is not supported by this build.
+ */
+GConverter *logview_decompressor_new(LogviewCompression compression) {
+  LogviewDecompressor *self;
+
+  if (compression == LOGVIEW_COMPRESSION_NONE ||
+      !logview_compression_is_supported(compression)) {
+    return NULL;
+  }
+
+#ifdef HAVE_ZLIB
+  if (compression == LOGVIEW_COMPRESSION_GZIP) {
+    return G_CONVERTER(
+        g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_GZIP));
+  }
+#endif
+
+  self = g_object_new(logview_decompressor_get_type(), NULL);
+  self->compression = compression;
+  decompressor_begin(self);
+
+  return G_CONVERTER(self);
+}
+
+#ifdef HAVE_ZSTD
+
+/* Multi-frame zstd logs (as written by pzstd or zstd --rsyncable) are
+ * decoded ahead of the reader in a thread pool, a few frames at a time
+ * so that memory stays bounded, and read back in order.
+ */
+
+typedef struct {
+  const char *data;
+  gsize len;
+
+  GBytes *bytes;
+  GError *error;
+  gboolean done;
+} ZstdFrame;
+
+typedef struct {
+  GInputStream parent;
+
+  GMappedFile *map;
+  GArray *frames;
+  GThreadPool *pool;
+
+  GMutex lock;
+  GCond cond;
+
+  /* the frame being read and the position in it */
+  guint current;
+  gsize pos;
+
+  /* frames handed to the pool, at most window ahead of current */
+  guint queued;
+  guint window;
+} LogviewZstdStream;
+
+typedef struct {
+  GInputStreamClass parent_class;
+} LogviewZstdStreamClass;
+
+G_DEFINE_TYPE(LogviewZstdStream, logview_zstd_stream, G_TYPE_INPUT_STREAM)
+
+static GBytes *zstd_decode_frame(const char *data, gsize len,
+                                 GError **error) {
+  ZSTD_DStream *zstd;
+  ZSTD_inBuffer in = {data, len, 0};
+  ZSTD_outBuffer out;
+  unsigned long long content_size;
+  size_t ret;
+
+  content_size = ZSTD_getFrameContentSize(data, len);
+
+  if (content_size != ZSTD_CONTENTSIZE_UNKNOWN &&
+      content_size != ZSTD_CONTENTSIZE_ERROR && content_size < G_MAXSIZE) {
+    out.size = (size_t)content_size + 1;
+  } else {
+    out.size = len * 4;
+  }
+
+  out.size = MAX(out.size, 4096);
+  out.dst = g_malloc(out.size);
+  out.pos = 0;
+
+  zstd = ZSTD_createDStream();
+  ZSTD_initDStream(zstd);
+
+  do {
+    if (out.pos == out.size) {
+      out.size *= 2;
+      out.dst = g_realloc(out.dst, out.size);
+    }
+
+    ret = ZSTD_decompressStream(zstd, &out, &in);
+  } while (!ZSTD_isError(ret) && ret != 0 &&
+           (in.pos < in.size || out.pos == out.size));
+
+  ZSTD_freeDStream(zstd);
+
+  if (ZSTD_isError(ret) || ret != 0) {
+    g_free(out.dst);
+    set_corrupt_error(error);
+    return NULL;
+  }
+
+  return g_bytes_new_take(g_realloc(out.dst, out.pos), out.pos);
+}
+
+static void zstd_stream_decode_func(gpointer data, gpointer user_data) {
+  /* this runs in a pool thread */
+  ZstdFrame *frame = data;
+  LogviewZstdStream *stream = user_data;
+  GError *error = NULL;
+  GBytes *bytes;
+
+  bytes = zstd_decode_frame(frame->data, frame->len, &error);
+
+  g_mutex_lock(&stream->lock);
+  frame->bytes = bytes;
+  frame->error = error;
+  frame->done = TRUE;
+  g_cond_broadcast(&stream->cond);
+  g_mutex_unlock(&stream->lock);
+}
+
+static void zstd_stream_queue_frames(LogviewZstdStream *stream) {
+  while (stream->queued < stream->frames->len &&
+         stream->queued < stream->current + stream->window) {
+    g_thread_pool_push(stream->pool,
+                       &g_array_index(stream->frames, ZstdFrame,
+                                      stream->queued),
+                       NULL);
+    stream->queued++;
+  }
+}
+
+static gssize logview_zstd_stream_read(GInputStream *input_stream,
+                                       void *buffer, gsize count,
+                                       GCancellable *cancellable,
+                                       GError **error) {
+  LogviewZstdStream *stream = (LogviewZstdStream *)input_stream;
+  ZstdFrame *frame;
+  const char *data;
+  gsize size, n;
+
+  g_mutex_lock(&stream->lock);
+
+  while (stream->current < stream->frames->len) {
+    frame = &g_array_index(stream->frames, ZstdFrame, stream->current);
+
+    while (!frame->done) {
+      if (g_cancellable_set_error_if_cancelled(cancellable, error)) {
+        g_mutex_unlock(&stream->lock);
+        return -1;
+      }
+
+      g_cond_wait_until(&stream->cond, &stream->lock,
+                        g_get_monotonic_time() + G_TIME_SPAN_SECOND / 10);
+    }
+
+    if (frame->error != NULL) {
+      g_propagate_error(error, g_error_copy(frame->error));
+      g_mutex_unlock(&stream->lock);
+      return -1;
+    }
+
+    data = g_bytes_get_data(frame->bytes, &size);
+
+    if (stream->pos < size) {
+      n = MIN(count, size - stream->pos);
+      memcpy(buffer, data + stream->pos, n);
+      stream->pos += n;
+
+      g_mutex_unlock(&stream->lock);
+      return (gssize)n;
+    }
+
+    /* the frame has been read, make room for the next ones */
+    g_clear_pointer(&frame->bytes, g_bytes_unref);
+    stream->current++;
+    stream->pos = 0;
+    zstd_stream_queue_frames(stream);
+  }
+
+  g_mutex_unlock(&stream->lock);
+
+  return 0;
+}
+
+static void logview_zstd_stream_finalize(GObject *object) {
+  LogviewZstdStream *stream = (LogviewZstdStream *)object;
+  guint i;
+
+  /* drop the queued frames and wait for the ones being decoded */
+  g_thread_pool_free(stream->pool, TRUE, TRUE);
+
+  for (i = 0; i < stream->frames->len; i++) {
+    ZstdFrame *frame = &g_array_index(stream->frames, ZstdFrame, i);
+
+    g_clear_pointer(&frame->bytes, g_bytes_unref);
+    g_clear_error(&frame->error);
+  }
+
+  g_array_free(stream->frames, TRUE);
+  g_mapped_file_unref(stream->map);
+
+  g_mutex_clear(&stream->lock);
+  g_cond_clear(&stream->cond);
+
+  G_OBJECT_CLASS(logview_zstd_stream_parent_class)->finalize(object);
+}
+
+static void logview_zstd_stream_class_init(LogviewZstdStreamClass *klass) {
+  GObjectClass *object_class = G_OBJECT_CLASS(klass);
+  GInputStreamClass *stream_class = G_INPUT_STREAM_CLASS(klass);
+
+  object_class->finalize = logview_zstd_stream_finalize;
+  stream_class->read_fn = logview_zstd_stream_read;
+}
+
+static void logview_zstd_stream_init(LogviewZstdStream *stream) {
+  g_mutex_init(&stream->lock);
+  g_cond_init(&stream->cond);
+}
+
+#endif /* HAVE_ZSTD */
+
+/**
+ * logview_decompressor_open_frames:
+ *
+ * @map: a mapped zstd compressed log.
+ *
+ * Returns: a stream decoding the frames of @map in parallel, or %NULL if
+ *   @map doesn't hold several frames, in which case it should be read
+ *   through logview_decompressor_new().
+ */
+GInputStream *logview_decompressor_open_frames(GMappedFile *map) {
+#ifdef HAVE_ZSTD
+  LogviewZstdStream *stream;
+  ZstdFrame frame = {0};
+  GArray *frames;
+  const char *data;
+  gsize len, offset;
+  size_t size;
+  guint n_threads;
+
+  data = g_mapped_file_get_contents(map);
+  len = g_mapped_file_get_length(map);
+
+  frames = g_array_new(FALSE, FALSE, sizeof(ZstdFrame));
+
+  for (offset = 0; offset < len; offset += size) {
+    size = ZSTD_findFrameCompressedSize(data + offset, len - offset);
+
+    if (ZSTD_isError(size)) {
+      /* leave the error to the sequential decoder */
+      g_array_free(frames, TRUE);
+      return NULL;
+    }
+
+    frame.data = data + offset;
+    frame.len = size;
+    g_array_append_val(frames, frame);
+  }
+
+  if (frames->len < 2) {
+    g_array_free(frames, TRUE);
+    return NULL;
+  }
+
+  n_threads = g_get_num_processors();
+
+  stream = g_object_new(logview_zstd_stream_get_type(), NULL);
+  stream->map = g_mapped_file_ref(map);
+  stream->frames = frames;
+  stream->window = 2 * n_threads;
+  stream->pool = g_thread_pool_new(zstd_stream_decode_func, stream, n_threads,
+                                   FALSE, NULL);
+
+  zstd_stream_queue_frames(stream);
+
+  return G_INPUT_STREAM(stream);
+#else  /* HAVE_ZSTD */
+  return NULL;
+#endif /* HAVE_ZSTD */
+}
@@ -0,0 +1,49 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* logview-decompressor.h */
+
+#ifndef __LOGVIEW_DECOMPRESSOR_H__
+#define __LOGVIEW_DECOMPRESSOR_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+  LOGVIEW_COMPRESSION_NONE,
+  LOGVIEW_COMPRESSION_GZIP,
+  LOGVIEW_COMPRESSION_BZIP2,
+  LOGVIEW_COMPRESSION_XZ,
+  LOGVIEW_COMPRESSION_ZSTD
+} LogviewCompression;
+
+/* bytes needed to tell the formats apart */
+#define LOGVIEW_MAGIC_LENGTH 10
+
+LogviewCompression logview_compression_detect(const char *data, gsize len);
+const char *logview_compression_get_name(LogviewCompression compression);
+gboolean logview_compression_is_supported(LogviewCompression compression);
+
+GConverter *logview_decompressor_new(LogviewCompression compression);
+GInputStream *logview_decompressor_open_frames(GMappedFile *map);
+
+G_END_DECLS
+
+#endif /* __LOGVIEW_DECOMPRESSOR_H__ */
@@ -0,0 +1,309 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "logview-filter-engine.h"
+
+#include "logview-filter-matcher.h"
+#include "logview-line-pool.h"
+#include "logview-marshal.h"
+
+/* The engine matches the lines of a log against a set of filters in a
+ * line pool, a chunk of lines at a time. Each filter gets a bitmap of
+ * the lines it matches; the pool hands the chunks back in line order,
+ * so that the lines [0, n_filtered) are always known.
+ */
+
+#define CHUNK_LINES 4096
+
+#define BITMAP_WORD(line) ((line) / 64)
+#define BITMAP_BIT(line) (G_GUINT64_CONSTANT(1) << ((line) % 64))
+
+enum { LINES_FILTERED, LAST_SIGNAL };
+
+static guint signals[LAST_SIGNAL] = {0};
+
+struct _LogviewFilterEnginePrivate {
+  /* the jobs have the matcher of the filters as their data */
+  LogviewLinePool *pool;
+
+  /* one GArray of guint64 per filter */
+  GPtrArray *bitmaps;
+};
+
+typedef struct {
+  guint first_line;
+
+  /* the bits of each filter, in words aligned to the whole bitmaps */
+  guint n_words;
+  guint64 *bits;
+
+  /* what each filter says of the current line */
+  gboolean *matched;
+} FilterChunk;
+
+G_DEFINE_TYPE_WITH_PRIVATE(LogviewFilterEngine, logview_filter_engine,
+                           G_TYPE_OBJECT);
+
+static guint count_bits(guint64 word) {
+  guint n = 0;
+
+  for (; word != 0; word &= word - 1) {
+    n++;
+  }
+
+  return n;
+}
+
+static gpointer filter_chunk_new(gpointer job_data, guint first_line,
+                                 guint n_lines) {
+  LogviewFilterMatcher *matcher = job_data;
+  FilterChunk *chunk;
+  guint n_filters;
+
+  n_filters = logview_filter_matcher_get_n_filters(matcher);
+
+  chunk = g_slice_new0(FilterChunk);
+  chunk->first_line = first_line;
+  chunk->n_words =
+      BITMAP_WORD(first_line + n_lines - 1) - BITMAP_WORD(first_line) + 1;
+  chunk->bits = g_new0(guint64, chunk->n_words * n_filters);
+  chunk->matched = g_new(gboolean, n_filters);
+
+  return chunk;
+}
+
+static void filter_chunk_free(gpointer data) {
+  FilterChunk *chunk = data;
+
+  g_free(chunk->bits);
+  g_free(chunk->matched);
+
+  g_slice_free(FilterChunk, chunk);
+}
+
+/* runs in one of the pool threads */
+static void filter_chunk_line(gpointer data, gpointer job_data, guint line,
+                              const char *text, gsize len) {
+  FilterChunk *chunk = data;
+  LogviewFilterMatcher *matcher = job_data;
+  guint n_filters, bit, i;
+
+  n_filters = logview_filter_matcher_get_n_filters(matcher);
+  bit = line - BITMAP_WORD(chunk->first_line) * 64;
+
+  /* all the filters at once */
+  logview_filter_matcher_match(matcher, text, len, chunk->matched);
+
+  for (i = 0; i < n_filters; i++) {
+    if (chunk->matched[i]) {
+      chunk->bits[i * chunk->n_words + BITMAP_WORD(bit)] |= BITMAP_BIT(bit);
+    }
+  }
+}
+
+/* runs in the main thread */
+static void filter_chunk_done(gpointer data, gpointer user_data) {
+  FilterChunk *chunk = data;
+  LogviewFilterEngine *engine = user_data;
+  GPtrArray *bitmaps = engine->priv->bitmaps;
+  guint64 *src, *dest;
+  guint i, j;
+
+  for (i = 0; i < bitmaps->len; i++) {
+    dest = (guint64 *)((GArray *)g_ptr_array_index(bitmaps, i))->data;
+    dest += BITMAP_WORD(chunk->first_line);
+    src = chunk->bits + i * chunk->n_words;
+
+    /* the chunks around share the words at the edges */
+    for (j = 0; j < chunk->n_words; j++) {
+      dest[j] |= src[j];
+    }
+  }
+}
+
+static void filter_lines_done(guint first_line, guint n_lines,
+                              gpointer user_data) {
+  g_signal_emit(user_data, signals[LINES_FILTERED], 0, first_line, n_lines);
+}
+
+static const LogviewLinePoolFuncs filter_pool_funcs = {
+    filter_chunk_new, filter_chunk_line, filter_chunk_done, filter_chunk_free,
+    filter_lines_done};
+
+static void logview_filter_engine_finalize(GObject *object) {
+  LogviewFilterEnginePrivate *priv = LOGVIEW_FILTER_ENGINE(object)->priv;
+
+  logview_line_pool_free(priv->pool);
+  g_ptr_array_unref(priv->bitmaps);
+
+  G_OBJECT_CLASS(logview_filter_engine_parent_class)->finalize(object);
+}
+
+static void logview_filter_engine_class_init(LogviewFilterEngineClass *klass) {
+  GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+  object_class->finalize = logview_filter_engine_finalize;
+
+  signals[LINES_FILTERED] = g_signal_new(
+      "lines-filtered", G_OBJECT_CLASS_TYPE(object_class), G_SIGNAL_RUN_LAST,
+      G_STRUCT_OFFSET(LogviewFilterEngineClass, lines_filtered), NULL, NULL,
+      logview_marshal_VOID__UINT_UINT, G_TYPE_NONE, 2, G_TYPE_UINT,
+      G_TYPE_UINT);
+}
+
+static void logview_filter_engine_init(LogviewFilterEngine *engine) {
+  LogviewFilterEnginePrivate *priv;
+
+  priv = engine->priv = logview_filter_engine_get_instance_private(engine);
+
+  priv->pool = logview_line_pool_new(&filter_pool_funcs, CHUNK_LINES, engine);
+  priv->bitmaps = g_ptr_array_new_with_free_func((GDestroyNotify)g_array_unref);
+}
+
+/* public methods */
+
+LogviewFilterEngine *logview_filter_engine_new(void) {
+  return g_object_new(LOGVIEW_TYPE_FILTER_ENGINE, NULL);
+}
+
+/* drops the results so far and filters the first n_lines of log */
+void logview_filter_engine_start(LogviewFilterEngine *engine, LogviewLog *log,
+                                 GList *filters, guint n_lines) {
+  LogviewFilterEnginePrivate *priv;
+  GList *l;
+
+  g_return_if_fail(LOGVIEW_IS_FILTER_ENGINE(engine));
+  g_return_if_fail(LOGVIEW_IS_LOG(log));
+
+  logview_filter_engine_stop(engine);
+
+  priv = engine->priv;
+
+  for (l = filters; l != NULL; l = l->next) {
+    g_ptr_array_add(priv->bitmaps, g_array_new(FALSE, TRUE, sizeof(guint64)));
+  }
+
+  /* the patterns are compiled together once, for all the chunks */
+  logview_line_pool_start(priv->pool, log, logview_filter_matcher_new(filters),
+                          (GDestroyNotify)logview_filter_matcher_unref, 0);
+
+  logview_filter_engine_add_lines(engine, n_lines);
+}
+
+/* the log now has n_lines, filter the new ones */
+void logview_filter_engine_add_lines(LogviewFilterEngine *engine,
+                                     guint n_lines) {
+  LogviewFilterEnginePrivate *priv;
+  guint i;
+
+  g_return_if_fail(LOGVIEW_IS_FILTER_ENGINE(engine));
+
+  priv = engine->priv;
+
+  if (logview_line_pool_get_job_data(priv->pool) == NULL ||
+      n_lines <= logview_line_pool_get_n_lines(priv->pool)) {
+    return;
+  }
+
+  for (i = 0; i < priv->bitmaps->len; i++) {
+    g_array_set_size(g_ptr_array_index(priv->bitmaps, i),
+                     BITMAP_WORD(n_lines - 1) + 1);
+  }
+
+  logview_line_pool_add_lines(priv->pool, n_lines);
+}
+
+void logview_filter_engine_stop(LogviewFilterEngine *engine) {
+  g_return_if_fail(LOGVIEW_IS_FILTER_ENGINE(engine));
+
+  /* the chunks still queued will skip their lines */
+  logview_line_pool_stop(engine->priv->pool);
+  g_ptr_array_set_size(engine->priv->bitmaps, 0);
+}
+
+/* the lines before this one have their results */
+guint logview_filter_engine_get_n_filtered(LogviewFilterEngine *engine) {
+  g_return_val_if_fail(LOGVIEW_IS_FILTER_ENGINE(engine), 0);
+
+  return logview_line_pool_get_n_done(engine->priv->pool);
+}
+
+/* whether the filter at position filter in the list given to start
+ * matches line, which must have been filtered already */
+gboolean logview_filter_engine_get_match(LogviewFilterEngine *engine,
+                                         guint filter, guint line) {
+  GArray *bitmap;
+
+  g_assert(filter < engine->priv->bitmaps->len);
+  g_assert(line < logview_line_pool_get_n_done(engine->priv->pool));
+
+  bitmap = g_ptr_array_index(engine->priv->bitmaps, filter);
+
+  return (g_array_index(bitmap, guint64, BITMAP_WORD(line)) &
+          BITMAP_BIT(line)) != 0;
+}
+
+/* the number of lines in [first_line, last_line) that match any of the
+ * filters, counted a word of each bitmap at a time; the lines must have
+ * been filtered already */
+guint logview_filter_engine_count_matches(LogviewFilterEngine *engine,
+                                          guint first_line, guint last_line) {
+  LogviewFilterEnginePrivate *priv;
+  GArray *bitmap;
+  guint64 word, mask;
+  guint n_matches = 0, w, i;
+
+  g_return_val_if_fail(LOGVIEW_IS_FILTER_ENGINE(engine), 0);
+
+  priv = engine->priv;
+
+  g_assert(last_line <= logview_line_pool_get_n_done(priv->pool));
+
+  if (first_line >= last_line || priv->bitmaps->len == 0) {
+    return 0;
+  }
+
+  for (w = BITMAP_WORD(first_line); w <= BITMAP_WORD(last_line - 1); w++) {
+    word = 0;
+
+    for (i = 0; i < priv->bitmaps->len; i++) {
+      bitmap = g_ptr_array_index(priv->bitmaps, i);
+      word |= g_array_index(bitmap, guint64, w);
+    }
+
+    /* the lines of the word outside of the range */
+    mask = G_MAXUINT64;
+
+    if (w == BITMAP_WORD(first_line)) {
+      mask &= ~(BITMAP_BIT(first_line) - 1);
+    }
+
+    if (w == BITMAP_WORD(last_line - 1) && (last_line % 64) != 0) {
+      mask &= BITMAP_BIT(last_line) - 1;
+    }
+
+    n_matches += count_bits(word & mask);
+  }
+
+  return n_matches;
+}
@@ -0,0 +1,82 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* logview-filter-engine.h */
+
+#ifndef __LOGVIEW_FILTER_ENGINE_H__
+#define __LOGVIEW_FILTER_ENGINE_H__
+
+#include <glib-object.h>
+
+#include "logview-log.h"
+
+G_BEGIN_DECLS
+
+#define LOGVIEW_TYPE_FILTER_ENGINE logview_filter_engine_get_type()
+#define LOGVIEW_FILTER_ENGINE(obj)                               \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj), LOGVIEW_TYPE_FILTER_ENGINE, \
+                              LogviewFilterEngine))
+#define LOGVIEW_FILTER_ENGINE_CLASS(klass)                      \
+  (G_TYPE_CHECK_CLASS_CAST((klass), LOGVIEW_TYPE_FILTER_ENGINE, \
+                           LogviewFilterEngineClass))
+#define LOGVIEW_IS_FILTER_ENGINE(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj), LOGVIEW_TYPE_FILTER_ENGINE))
+#define LOGVIEW_IS_FILTER_ENGINE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass), LOGVIEW_TYPE_FILTER_ENGINE))
+#define LOGVIEW_FILTER_ENGINE_GET_CLASS(obj)                    \
+  (G_TYPE_INSTANCE_GET_CLASS((obj), LOGVIEW_TYPE_FILTER_ENGINE, \
+                             LogviewFilterEngineClass))
+
+typedef struct _LogviewFilterEngine LogviewFilterEngine;
+typedef struct _LogviewFilterEngineClass LogviewFilterEngineClass;
+typedef struct _LogviewFilterEnginePrivate LogviewFilterEnginePrivate;
+
+struct _LogviewFilterEngine {
+  GObject parent;
+  LogviewFilterEnginePrivate *priv;
+};
+
+struct _LogviewFilterEngineClass {
+  GObjectClass parent_class;
+
+  /* signals */
+  void (*lines_filtered)(LogviewFilterEngine *engine, guint first_line,
+                         guint n_lines);
+};
+
+GType logview_filter_engine_get_type(void);
+
+/* public methods */
+LogviewFilterEngine *logview_filter_engine_new(void);
+
+void logview_filter_engine_start(LogviewFilterEngine *engine, LogviewLog *log,
+                                 GList *filters, guint n_lines);
+void logview_filter_engine_add_lines(LogviewFilterEngine *engine,
+                                     guint n_lines);
+void logview_filter_engine_stop(LogviewFilterEngine *engine);
+
+guint logview_filter_engine_get_n_filtered(LogviewFilterEngine *engine);
+gboolean logview_filter_engine_get_match(LogviewFilterEngine *engine,
+                                         guint filter, guint line);
+guint logview_filter_engine_count_matches(LogviewFilterEngine *engine,
+                                          guint first_line, guint last_line);
+
+G_END_DECLS
+
+#endif /* __LOGVIEW_FILTER_ENGINE_H__ */
@@ -0,0 +1,265 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "logview-filter-matcher.h"
+#include "logview-filter.h"
+
+/* The matcher tells which of a set of filters match a line. The text
+ * each pattern requires is looked for in a single pass over the line,
+ * the regular expressions then only run on the lines that contain it,
+ * and not at all for patterns that are plain text.
+ *
+ * The regular expressions are combined into a single one, which is
+ * matched once against the line: each filter is a lookahead from the
+ * start of the line, with a capture group around its pattern that is
+ * only set if the filter matches, and an empty alternative so that the
+ * lookaheads after it are tried either way. A pattern with back
+ * references, which would point to other groups once combined, runs on
+ * its own. Once built, the matcher is read only and can be used from
+ * several threads.
+ */
+
+typedef struct {
+  LogviewFilter *filter;
+
+  /* owned by the filter */
+  const char *literal;
+  gsize literal_len;
+  gboolean exact;
+
+  /* the group of the pattern in the combined one, 0 if it runs alone */
+  gint group;
+} MatcherEntry;
+
+struct _LogviewFilterMatcher {
+  gint ref_count;
+
+  guint n_filters;
+  MatcherEntry *entries;
+
+  /* the filters with a literal, by its first byte: those starting
+   * with byte b are by_byte[first[b]] to by_byte[first[b + 1] - 1] */
+  guint n_literals;
+  guint *by_byte;
+  guint first[257];
+
+  /* the patterns the literals can't decide alone, or NULL */
+  GRegex *combined;
+};
+
+static void matcher_combine_patterns(LogviewFilterMatcher *matcher) {
+  MatcherEntry *entry;
+  GString *pattern;
+  GRegex *regex;
+  gint group = 1;
+  guint i;
+
+  pattern = g_string_new("^");
+
+  for (i = 0; i < matcher->n_filters; i++) {
+    entry = &matcher->entries[i];
+    regex = logview_filter_get_regex(entry->filter);
+
+    if (entry->exact || regex == NULL || g_regex_get_max_backref(regex) > 0) {
+      continue;
+    }
+
+    g_string_append_printf(pattern, "(?:(?=.*?(%s))|)",
+                           g_regex_get_pattern(regex));
+
+    /* the groups of the pattern come after its own */
+    entry->group = group;
+    group += 1 + g_regex_get_capture_count(regex);
+  }
+
+  if (group > 1) {
+    matcher->combined = g_regex_new(pattern->str, G_REGEX_OPTIMIZE, 0, NULL);
+  }
+
+  if (matcher->combined == NULL) {
+    /* e.g. two patterns with a group of the same name, they all run on
+     * their own then */
+    for (i = 0; i < matcher->n_filters; i++) {
+      matcher->entries[i].group = 0;
+    }
+  }
+
+  g_string_free(pattern, TRUE);
+}
+
+LogviewFilterMatcher *logview_filter_matcher_new(GList *filters) {
+  LogviewFilterMatcher *matcher;
+  MatcherEntry *entry;
+  guint counts[256] = {0};
+  guint i, b;
+  GList *l;
+
+  matcher = g_slice_new0(LogviewFilterMatcher);
+  matcher->ref_count = 1;
+  matcher->n_filters = g_list_length(filters);
+  matcher->entries = g_new0(MatcherEntry, matcher->n_filters);
+
+  for (l = filters, i = 0; l != NULL; l = l->next, i++) {
+    entry = &matcher->entries[i];
+    entry->filter = g_object_ref(l->data);
+    entry->literal = logview_filter_get_literal(entry->filter, &entry->exact);
+
+    if (entry->literal != NULL) {
+      entry->literal_len = strlen(entry->literal);
+      counts[(guchar)entry->literal[0]]++;
+      matcher->n_literals++;
+    }
+  }
+
+  for (b = 0; b < 256; b++) {
+    matcher->first[b + 1] = matcher->first[b] + counts[b];
+  }
+
+  matcher->by_byte = g_new(guint, MAX(matcher->n_literals, 1));
+
+  for (i = 0; i < matcher->n_filters; i++) {
+    entry = &matcher->entries[i];
+
+    if (entry->literal != NULL) {
+      b = (guchar)entry->literal[0];
+      matcher->by_byte[matcher->first[b + 1] - counts[b]] = i;
+      counts[b]--;
+    }
+  }
+
+  matcher_combine_patterns(matcher);
+
+  return matcher;
+}
+
+LogviewFilterMatcher *logview_filter_matcher_ref(
+    LogviewFilterMatcher *matcher) {
+  g_atomic_int_inc(&matcher->ref_count);
+
+  return matcher;
+}
+
+void logview_filter_matcher_unref(LogviewFilterMatcher *matcher) {
+  guint i;
+
+  if (!g_atomic_int_dec_and_test(&matcher->ref_count)) {
+    return;
+  }
+
+  for (i = 0; i < matcher->n_filters; i++) {
+    g_object_unref(matcher->entries[i].filter);
+  }
+
+  if (matcher->combined != NULL) {
+    g_regex_unref(matcher->combined);
+  }
+
+  g_free(matcher->entries);
+  g_free(matcher->by_byte);
+  g_slice_free(LogviewFilterMatcher, matcher);
+}
+
+guint logview_filter_matcher_get_n_filters(LogviewFilterMatcher *matcher) {
+  return matcher->n_filters;
+}
+
+/**
+ * logview_filter_matcher_match:
+ *
+ * @matcher: a #LogviewFilterMatcher.
+ * @line: the text of the line, in UTF-8 and not NUL-terminated.
+ * @len: the length of @line.
+ * @matched: an array with an element for each filter, set to whether
+ *   the filter matches @line.
+ *
+ * The patterns that have to run are matched in a single pass, this only
+ * allocates the #GMatchInfo of that pass.
+ */
+void logview_filter_matcher_match(LogviewFilterMatcher *matcher,
+                                  const char *line, gsize len,
+                                  gboolean *matched) {
+  MatcherEntry *entry;
+  GMatchInfo *match_info;
+  gboolean run_combined = FALSE;
+  guint n_found = 0, i, j;
+  gint start;
+  gsize pos;
+  guchar b;
+
+  memset(matched, 0, matcher->n_filters * sizeof(gboolean));
+
+  /* look for all the literals at once */
+  for (pos = 0; pos < len && n_found < matcher->n_literals; pos++) {
+    b = (guchar)line[pos];
+
+    for (j = matcher->first[b]; j < matcher->first[b + 1]; j++) {
+      i = matcher->by_byte[j];
+      entry = &matcher->entries[i];
+
+      if (!matched[i] && entry->literal_len <= len - pos &&
+          memcmp(line + pos, entry->literal, entry->literal_len) == 0) {
+        matched[i] = TRUE;
+        n_found++;
+      }
+    }
+  }
+
+  /* then the patterns that the literals can't decide alone */
+  for (i = 0; i < matcher->n_filters; i++) {
+    entry = &matcher->entries[i];
+
+    if (entry->exact || (entry->literal != NULL && !matched[i])) {
+      continue;
+    }
+
+    if (entry->group > 0) {
+      run_combined = TRUE;
+    } else {
+      matched[i] = logview_filter_filter(entry->filter, line, (gssize)len);
+    }
+  }
+
+  if (!run_combined) {
+    return;
+  }
+
+  g_regex_match_full(matcher->combined, line, (gssize)len, 0, 0, &match_info,
+                     NULL);
+
+  for (i = 0; i < matcher->n_filters; i++) {
+    entry = &matcher->entries[i];
+
+    if (entry->group == 0 || (entry->literal != NULL && !matched[i])) {
+      continue;
+    }
+
+    /* a group that isn't set is at -1 */
+    matched[i] = g_match_info_fetch_pos(match_info, entry->group, &start,
+                                        NULL) &&
+                 start >= 0;
+  }
+
+  g_match_info_free(match_info);
+}
@@ -0,0 +1,42 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* logview-filter-matcher.h */
+
+#ifndef __LOGVIEW_FILTER_MATCHER_H__
+#define __LOGVIEW_FILTER_MATCHER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _LogviewFilterMatcher LogviewFilterMatcher;
+
+LogviewFilterMatcher *logview_filter_matcher_new(GList *filters);
+LogviewFilterMatcher *logview_filter_matcher_ref(LogviewFilterMatcher *matcher);
+void logview_filter_matcher_unref(LogviewFilterMatcher *matcher);
+
+guint logview_filter_matcher_get_n_filters(LogviewFilterMatcher *matcher);
+void logview_filter_matcher_match(LogviewFilterMatcher *matcher,
+                                  const char *line, gsize len,
+                                  gboolean *matched);
+
+G_END_DECLS
+
+#endif /* __LOGVIEW_FILTER_MATCHER_H__ */
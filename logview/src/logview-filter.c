@@ -22,6 +22,8 @@
 #include <config.h>
 #endif
 
+#include <string.h>
+
 #include "logview-filter.h"
 
 enum { PROP_0, PROP_REGEX, PROP_NAME, PROP_TEXTTAG };
@@ -30,10 +32,133 @@ struct _LogviewFilterPrivate {
   GRegex *regex;
   gchar *name;
   GtkTextTag *tag;
+
+  /* text every matching line contains, if the pattern has any; when
+   * exact, containing it is all it takes to match */
+  gchar *literal;
+  gboolean literal_exact;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE(LogviewFilter, logview_filter, G_TYPE_OBJECT);
 
+/* looks for the longest run of plain characters that any match of the
+ * pattern has to contain; anything that could make it optional (a
+ * group, an alternation, a quantifier) ends the run or gives up */
+static gchar *extract_literal(const gchar *pattern, gboolean *exact) {
+  GString *run, *best;
+  const gchar *p, *prev;
+  gboolean plain = TRUE;
+
+  run = g_string_new(NULL);
+  best = g_string_new(NULL);
+
+  for (p = pattern; *p != '\0'; p++) {
+    switch (*p) {
+      case '|':
+      case '(':
+      case ')':
+        /* the pieces of an alternation or a group might be optional */
+        g_string_truncate(best, 0);
+        g_string_truncate(run, 0);
+        plain = FALSE;
+        goto out;
+      case '?':
+      case '*':
+      case '{':
+        /* the last character might be missing */
+        if (run->len > 0) {
+          prev = g_utf8_find_prev_char(run->str, run->str + run->len);
+          g_string_truncate(run, prev ? (gsize)(prev - run->str) : 0);
+        }
+        /* fall through */
+      case '+':
+      case '.':
+      case '^':
+      case '$':
+        if (run->len > best->len) {
+          g_string_assign(best, run->str);
+        }
+
+        g_string_truncate(run, 0);
+        plain = FALSE;
+
+        if (*p == '{') {
+          while (p[1] != '\0' && *p != '}') {
+            p++;
+          }
+        }
+        break;
+      case '[':
+        if (run->len > best->len) {
+          g_string_assign(best, run->str);
+        }
+
+        g_string_truncate(run, 0);
+        plain = FALSE;
+
+        /* skip the class, a leading ] belongs to it */
+        p++;
+        if (*p == '^') {
+          p++;
+        }
+        if (*p == ']') {
+          p++;
+        }
+        while (*p != '\0' && *p != ']') {
+          if (*p == '\\' && p[1] != '\0') {
+            p++;
+          }
+          p++;
+        }
+        if (*p == '\0') {
+          goto out;
+        }
+        break;
+      case '\\':
+        if (p[1] != '\0' && !g_ascii_isalnum(p[1])) {
+          /* an escaped punctuation character stands for itself */
+          p++;
+          g_string_append_c(run, *p);
+          break;
+        }
+
+        /* classes, anchors, back references and the like */
+        if (run->len > best->len) {
+          g_string_assign(best, run->str);
+        }
+
+        g_string_truncate(run, 0);
+        plain = FALSE;
+
+        if (p[1] == '\0' || strchr("dDwWsSbBAzZGhHvVRXntrfea", p[1]) == NULL) {
+          /* these might hide characters in what follows */
+          goto out;
+        }
+
+        p++;
+        break;
+      default:
+        g_string_append_c(run, *p);
+        break;
+    }
+  }
+
+  if (run->len > best->len) {
+    g_string_assign(best, run->str);
+  }
+
+out:
+  *exact = plain && best->len > 0;
+  g_string_free(run, TRUE);
+
+  if (best->len == 0) {
+    g_string_free(best, TRUE);
+    return NULL;
+  }
+
+  return g_string_free(best, FALSE);
+}
+
 static void logview_filter_init(LogviewFilter *object) {
   object->priv = logview_filter_get_instance_private(object);
   object->priv->tag = NULL;
@@ -46,8 +171,12 @@ static void logview_filter_finalize(GObject *object) {
     g_object_unref(priv->tag);
   }
 
-  g_regex_unref(priv->regex);
+  if (priv->regex) {
+    g_regex_unref(priv->regex);
+  }
+
   g_free(priv->name);
+  g_free(priv->literal);
 
   G_OBJECT_CLASS(logview_filter_parent_class)->finalize(object);
 }
@@ -68,13 +197,13 @@ static void logview_filter_set_property(GObject *object, guint prop_id,
       err = NULL;
 
       regex = g_value_get_string(value);
-      priv->regex = g_regex_new(regex, 0, 0, &err);
+      priv->regex = g_regex_new(regex, G_REGEX_OPTIMIZE, 0, &err);
 
       if (err) {
-        g_regex_unref(priv->regex);
-        priv->regex = NULL;
         g_warning("Couldn't create GRegex object: %s", err->message);
         g_error_free(err);
+      } else {
+        priv->literal = extract_literal(regex, &priv->literal_exact);
       }
 
       break;
@@ -145,23 +274,45 @@ LogviewFilter *logview_filter_new(const gchar *name, const gchar *regex) {
   return g_object_new(LOGVIEW_TYPE_FILTER, "name", name, "regex", regex, NULL);
 }
 
-gboolean logview_filter_filter(LogviewFilter *filter, const gchar *line) {
-  GMatchInfo *match_info;
+gboolean logview_filter_filter(LogviewFilter *filter, const gchar *line,
+                               gssize len) {
   LogviewFilterPrivate *priv;
-  gboolean retval;
 
   g_return_val_if_fail(LOGVIEW_IS_FILTER(filter), FALSE);
   g_return_val_if_fail(line != NULL, FALSE);
 
   priv = filter->priv;
 
-  g_regex_match(priv->regex, line, 0, &match_info);
+  if (priv->regex == NULL) {
+    return FALSE;
+  }
+
+  return g_regex_match_full(priv->regex, line, len, 0, 0, NULL, NULL);
+}
+
+/**
+ * logview_filter_get_literal:
+ *
+ * @filter: a #LogviewFilter.
+ * @exact: return location for whether the literal alone decides a match.
+ *
+ * Returns: a string that every line matched by @filter contains, or %NULL
+ *   if the pattern doesn't have one.
+ */
+const gchar *logview_filter_get_literal(LogviewFilter *filter,
+                                        gboolean *exact) {
+  g_return_val_if_fail(LOGVIEW_IS_FILTER(filter), NULL);
+
+  *exact = filter->priv->literal_exact;
 
-  retval = g_match_info_matches(match_info);
+  return filter->priv->literal;
+}
 
-  g_match_info_free(match_info);
+/* the compiled pattern, or NULL if it isn't valid */
+GRegex *logview_filter_get_regex(LogviewFilter *filter) {
+  g_return_val_if_fail(LOGVIEW_IS_FILTER(filter), NULL);
 
-  return retval;
+  return filter->priv->regex;
 }
 
 GtkTextTag *logview_filter_get_tag(LogviewFilter *filter) {
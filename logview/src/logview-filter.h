@@ -55,7 +55,11 @@ struct _LogviewFilter {
 
 GType logview_filter_get_type(void) G_GNUC_CONST;
 LogviewFilter *logview_filter_new(const gchar *name, const gchar *regex);
-gboolean logview_filter_filter(LogviewFilter *filter, const gchar *line);
+gboolean logview_filter_filter(LogviewFilter *filter, const gchar *line,
+                               gssize len);
+const gchar *logview_filter_get_literal(LogviewFilter *filter,
+                                        gboolean *exact);
+GRegex *logview_filter_get_regex(LogviewFilter *filter);
 GtkTextTag *logview_filter_get_tag(LogviewFilter *filter);
 
 G_END_DECLS
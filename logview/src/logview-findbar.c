@@ -32,6 +32,8 @@
 struct _LogviewFindbarPrivate {
   GtkWidget *entry;
   GtkWidget *message;
+  GtkWidget *case_check;
+  GtkWidget *regex_check;
 
   GtkToolItem *clear_button;
   GtkToolItem *back_button;
@@ -94,6 +96,14 @@ static void entry_changed_cb(GtkEditable *editable, gpointer user_data) {
   }
 }
 
+static void option_toggled_cb(GtkToggleButton *button, gpointer user_data) {
+  LogviewFindbar *findbar = user_data;
+
+  if (findbar->priv->string != NULL) {
+    g_signal_emit(findbar, signals[TEXT_CHANGED], 0);
+  }
+}
+
 static gboolean entry_key_press_event_cb(GtkWidget *entry, GdkEventKey *event,
                                          gpointer user_data) {
   LogviewFindbar *findbar = user_data;
@@ -176,6 +186,25 @@ static void logview_findbar_init(LogviewFindbar *findbar) {
   gtk_toolbar_insert(gtoolbar, priv->clear_button, -1);
   gtk_widget_show_all(GTK_WIDGET(priv->clear_button));
 
+  /* search options */
+  box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 6);
+  gtk_widget_set_margin_start(box, 6);
+
+  priv->case_check = gtk_check_button_new_with_mnemonic(_("Match _Case"));
+  gtk_box_pack_start(GTK_BOX(box), priv->case_check, FALSE, FALSE, 0);
+
+  priv->regex_check =
+      gtk_check_button_new_with_mnemonic(_("_Regular Expression"));
+  gtk_widget_set_tooltip_text(priv->regex_check,
+                              _("Search for a Perl-compatible regular "
+                                "expression"));
+  gtk_box_pack_start(GTK_BOX(box), priv->regex_check, FALSE, FALSE, 0);
+
+  item = gtk_tool_item_new();
+  gtk_container_add(GTK_CONTAINER(item), box);
+  gtk_toolbar_insert(gtoolbar, item, -1);
+  gtk_widget_show_all(GTK_WIDGET(item));
+
   /* separator */
   priv->separator = gtk_separator_tool_item_new();
   gtk_toolbar_insert(gtoolbar, priv->separator, -1);
@@ -206,6 +235,10 @@ static void logview_findbar_init(LogviewFindbar *findbar) {
                    findbar);
   g_signal_connect(priv->entry, "key-press-event",
                    G_CALLBACK(entry_key_press_event_cb), findbar);
+  g_signal_connect(priv->case_check, "toggled", G_CALLBACK(option_toggled_cb),
+                   findbar);
+  g_signal_connect(priv->regex_check, "toggled", G_CALLBACK(option_toggled_cb),
+                   findbar);
 }
 
 static void do_grab_focus(GtkWidget *widget) {
@@ -272,6 +305,20 @@ const char *logview_findbar_get_text(LogviewFindbar *findbar) {
   return findbar->priv->string;
 }
 
+gboolean logview_findbar_get_match_case(LogviewFindbar *findbar) {
+  g_assert(LOGVIEW_IS_FINDBAR(findbar));
+
+  return gtk_toggle_button_get_active(
+      GTK_TOGGLE_BUTTON(findbar->priv->case_check));
+}
+
+gboolean logview_findbar_get_use_regex(LogviewFindbar *findbar) {
+  g_assert(LOGVIEW_IS_FINDBAR(findbar));
+
+  return gtk_toggle_button_get_active(
+      GTK_TOGGLE_BUTTON(findbar->priv->regex_check));
+}
+
 void logview_findbar_set_message(LogviewFindbar *findbar, const char *text) {
   PangoFontDescription *desc;
 
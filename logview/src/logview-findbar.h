@@ -63,6 +63,8 @@ GType logview_findbar_get_type(void);
 GtkWidget *logview_findbar_new(void);
 void logview_findbar_open(LogviewFindbar *findbar);
 const char *logview_findbar_get_text(LogviewFindbar *findbar);
+gboolean logview_findbar_get_match_case(LogviewFindbar *findbar);
+gboolean logview_findbar_get_use_regex(LogviewFindbar *findbar);
 void logview_findbar_set_message(LogviewFindbar *findbar, const char *message);
 
 G_END_DECLS
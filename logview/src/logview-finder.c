@@ -0,0 +1,327 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "logview-finder.h"
+
+#include "logview-line-pool.h"
+
+/* The finder looks for a string in the whole log, in a line pool and a
+ * chunk of lines at a time, like the filter engine. The matches of the
+ * chunks are added in line order, so they are always sorted and a
+ * match can be looked up by position.
+ */
+
+#define CHUNK_LINES 8192
+
+enum { PROGRESS, LAST_SIGNAL };
+
+static guint signals[LAST_SIGNAL] = {0};
+
+/* what to look for, shared by the chunks */
+typedef struct {
+  /* plain text if there's no regex */
+  char *text;
+  gsize len;
+  GRegex *regex;
+} FinderPattern;
+
+struct _LogviewFinderPrivate {
+  /* the jobs have the pattern as their data */
+  LogviewLinePool *pool;
+
+  GArray *matches;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE(LogviewFinder, logview_finder, G_TYPE_OBJECT);
+
+static void finder_pattern_free(FinderPattern *pattern) {
+  if (pattern->regex != NULL) {
+    g_regex_unref(pattern->regex);
+  }
+
+  g_free(pattern->text);
+  g_slice_free(FinderPattern, pattern);
+}
+
+static gpointer finder_chunk_new(gpointer job_data, guint first_line,
+                                 guint n_lines) {
+  return g_array_new(FALSE, FALSE, sizeof(LogviewMatch));
+}
+
+static void finder_chunk_free(gpointer data) {
+  g_array_unref(data);
+}
+
+/* memchr() is vectorized in most C libraries, so the first byte of the
+ * text is looked for with it before comparing the rest */
+static const char *find_text(const char *haystack, gsize haystack_len,
+                             const char *needle, gsize needle_len) {
+  const char *p, *end;
+
+  if (needle_len > haystack_len) {
+    return NULL;
+  }
+
+  end = haystack + haystack_len - needle_len + 1;
+
+  for (p = haystack; p < end; p++) {
+    p = memchr(p, needle[0], end - p);
+
+    if (p == NULL) {
+      break;
+    }
+
+    if (memcmp(p + 1, needle + 1, needle_len - 1) == 0) {
+      return p;
+    }
+  }
+
+  return NULL;
+}
+
+/* runs in one of the pool threads */
+static void finder_chunk_line(gpointer data, gpointer job_data, guint line,
+                              const char *text, gsize len) {
+  GArray *matches = data;
+  FinderPattern *pattern = job_data;
+  LogviewMatch match;
+  GMatchInfo *info;
+  const char *p;
+  gsize pos;
+  gint start, end;
+
+  match.line = line;
+
+  if (pattern->regex == NULL) {
+    for (pos = 0;
+         (p = find_text(text + pos, len - pos, pattern->text, pattern->len));
+         pos = match.end) {
+      match.start = p - text;
+      match.end = match.start + pattern->len;
+      g_array_append_val(matches, match);
+    }
+
+    return;
+  }
+
+  g_regex_match_full(pattern->regex, text, (gssize)len, 0, 0, &info, NULL);
+
+  while (g_match_info_matches(info)) {
+    if (g_match_info_fetch_pos(info, 0, &start, &end) && end > start) {
+      match.start = start;
+      match.end = end;
+      g_array_append_val(matches, match);
+    }
+
+    g_match_info_next(info, NULL);
+  }
+
+  g_match_info_free(info);
+}
+
+/* runs in the main thread */
+static void finder_chunk_done(gpointer data, gpointer user_data) {
+  GArray *matches = data;
+  LogviewFinder *finder = user_data;
+
+  g_array_append_vals(finder->priv->matches, matches->data, matches->len);
+}
+
+static void finder_lines_done(guint first_line, guint n_lines,
+                              gpointer user_data) {
+  g_signal_emit(user_data, signals[PROGRESS], 0);
+}
+
+static const LogviewLinePoolFuncs finder_pool_funcs = {
+    finder_chunk_new, finder_chunk_line, finder_chunk_done, finder_chunk_free,
+    finder_lines_done};
+
+static void logview_finder_finalize(GObject *object) {
+  LogviewFinderPrivate *priv = LOGVIEW_FINDER(object)->priv;
+
+  logview_line_pool_free(priv->pool);
+  g_array_unref(priv->matches);
+
+  G_OBJECT_CLASS(logview_finder_parent_class)->finalize(object);
+}
+
+static void logview_finder_class_init(LogviewFinderClass *klass) {
+  GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+  object_class->finalize = logview_finder_finalize;
+
+  signals[PROGRESS] = g_signal_new(
+      "progress", G_OBJECT_CLASS_TYPE(object_class), G_SIGNAL_RUN_LAST,
+      G_STRUCT_OFFSET(LogviewFinderClass, progress), NULL, NULL,
+      g_cclosure_marshal_VOID__VOID, G_TYPE_NONE, 0);
+}
+
+static void logview_finder_init(LogviewFinder *finder) {
+  LogviewFinderPrivate *priv;
+
+  priv = finder->priv = logview_finder_get_instance_private(finder);
+
+  priv->pool = logview_line_pool_new(&finder_pool_funcs, CHUNK_LINES, finder);
+  priv->matches = g_array_new(FALSE, FALSE, sizeof(LogviewMatch));
+}
+
+/* public methods */
+
+LogviewFinder *logview_finder_new(void) {
+  return g_object_new(LOGVIEW_TYPE_FINDER, NULL);
+}
+
+/* drops the matches so far and looks for text in the first n_lines of
+ * log; fails if text is not a valid regular expression */
+gboolean logview_finder_start(LogviewFinder *finder, LogviewLog *log,
+                              const char *text, LogviewFinderFlags flags,
+                              guint n_lines, GError **error) {
+  FinderPattern *pattern;
+  GRegexCompileFlags compile_flags = G_REGEX_OPTIMIZE;
+  char *escaped = NULL;
+
+  g_return_val_if_fail(LOGVIEW_IS_FINDER(finder), FALSE);
+  g_return_val_if_fail(LOGVIEW_IS_LOG(log), FALSE);
+  g_return_val_if_fail(text != NULL && *text != '\0', FALSE);
+
+  logview_finder_stop(finder);
+
+  pattern = g_slice_new0(FinderPattern);
+  pattern->text = g_strdup(text);
+  pattern->len = strlen(text);
+
+  /* plain text is compared bytewise, the rest is left to GRegex */
+  if (!(flags & LOGVIEW_FINDER_MATCH_CASE) || (flags & LOGVIEW_FINDER_REGEX)) {
+    if (!(flags & LOGVIEW_FINDER_MATCH_CASE)) {
+      compile_flags |= G_REGEX_CASELESS;
+    }
+
+    if (!(flags & LOGVIEW_FINDER_REGEX)) {
+      text = escaped = g_regex_escape_string(text, -1);
+    }
+
+    pattern->regex = g_regex_new(text, compile_flags, 0, error);
+    g_free(escaped);
+
+    if (pattern->regex == NULL) {
+      finder_pattern_free(pattern);
+      return FALSE;
+    }
+  }
+
+  logview_line_pool_start(finder->priv->pool, log, pattern,
+                          (GDestroyNotify)finder_pattern_free, n_lines);
+
+  return TRUE;
+}
+
+/* the log now has n_lines, look into the new ones */
+void logview_finder_add_lines(LogviewFinder *finder, guint n_lines) {
+  g_return_if_fail(LOGVIEW_IS_FINDER(finder));
+
+  logview_line_pool_add_lines(finder->priv->pool, n_lines);
+}
+
+void logview_finder_stop(LogviewFinder *finder) {
+  g_return_if_fail(LOGVIEW_IS_FINDER(finder));
+
+  /* the chunks still running will notice and give up */
+  logview_line_pool_stop(finder->priv->pool);
+  g_array_set_size(finder->priv->matches, 0);
+}
+
+/* whether a search was started and hasn't been stopped since */
+gboolean logview_finder_has_pattern(LogviewFinder *finder) {
+  g_return_val_if_fail(LOGVIEW_IS_FINDER(finder), FALSE);
+
+  return logview_line_pool_get_job_data(finder->priv->pool) != NULL;
+}
+
+gboolean logview_finder_is_done(LogviewFinder *finder) {
+  g_return_val_if_fail(LOGVIEW_IS_FINDER(finder), TRUE);
+
+  return logview_line_pool_get_n_done(finder->priv->pool) ==
+         logview_line_pool_get_n_lines(finder->priv->pool);
+}
+
+guint logview_finder_get_n_matches(LogviewFinder *finder) {
+  g_return_val_if_fail(LOGVIEW_IS_FINDER(finder), 0);
+
+  return finder->priv->matches->len;
+}
+
+const LogviewMatch *logview_finder_get_match(LogviewFinder *finder, guint i) {
+  g_return_val_if_fail(LOGVIEW_IS_FINDER(finder), NULL);
+  g_return_val_if_fail(i < finder->priv->matches->len, NULL);
+
+  return &g_array_index(finder->priv->matches, LogviewMatch, i);
+}
+
+/* returns the position of the first match in line or after it, or the
+ * number of matches if there's none */
+guint logview_finder_get_first_match(LogviewFinder *finder, guint line) {
+  GArray *matches;
+  guint low, high, mid;
+
+  g_return_val_if_fail(LOGVIEW_IS_FINDER(finder), 0);
+
+  matches = finder->priv->matches;
+  low = 0;
+  high = matches->len;
+
+  while (low < high) {
+    mid = low + (high - low) / 2;
+
+    if (g_array_index(matches, LogviewMatch, mid).line < line) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  return low;
+}
+
+/* the matches in line, sorted by offset */
+const LogviewMatch *logview_finder_get_line_matches(LogviewFinder *finder,
+                                                    guint line,
+                                                    guint *n_matches) {
+  GArray *matches;
+  guint first, last;
+
+  g_return_val_if_fail(LOGVIEW_IS_FINDER(finder), NULL);
+
+  matches = finder->priv->matches;
+  first = last = logview_finder_get_first_match(finder, line);
+
+  while (last < matches->len &&
+         g_array_index(matches, LogviewMatch, last).line == line) {
+    last++;
+  }
+
+  *n_matches = last - first;
+
+  return (last > first) ? &g_array_index(matches, LogviewMatch, first) : NULL;
+}
@@ -0,0 +1,93 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* logview-finder.h */
+
+#ifndef __LOGVIEW_FINDER_H__
+#define __LOGVIEW_FINDER_H__
+
+#include <glib-object.h>
+
+#include "logview-log.h"
+
+G_BEGIN_DECLS
+
+#define LOGVIEW_TYPE_FINDER logview_finder_get_type()
+#define LOGVIEW_FINDER(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj), LOGVIEW_TYPE_FINDER, LogviewFinder))
+#define LOGVIEW_FINDER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass), LOGVIEW_TYPE_FINDER, LogviewFinderClass))
+#define LOGVIEW_IS_FINDER(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj), LOGVIEW_TYPE_FINDER))
+#define LOGVIEW_IS_FINDER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass), LOGVIEW_TYPE_FINDER))
+#define LOGVIEW_FINDER_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS((obj), LOGVIEW_TYPE_FINDER, LogviewFinderClass))
+
+typedef struct _LogviewFinder LogviewFinder;
+typedef struct _LogviewFinderClass LogviewFinderClass;
+typedef struct _LogviewFinderPrivate LogviewFinderPrivate;
+
+typedef enum {
+  LOGVIEW_FINDER_MATCH_CASE = 1 << 0,
+  LOGVIEW_FINDER_REGEX = 1 << 1
+} LogviewFinderFlags;
+
+/* a match, the offsets are in bytes of the line as it's shown */
+typedef struct {
+  guint line;
+  guint start;
+  guint end;
+} LogviewMatch;
+
+struct _LogviewFinder {
+  GObject parent;
+  LogviewFinderPrivate *priv;
+};
+
+struct _LogviewFinderClass {
+  GObjectClass parent_class;
+
+  /* signals */
+  void (*progress)(LogviewFinder *finder);
+};
+
+GType logview_finder_get_type(void);
+
+/* public methods */
+LogviewFinder *logview_finder_new(void);
+
+gboolean logview_finder_start(LogviewFinder *finder, LogviewLog *log,
+                              const char *text, LogviewFinderFlags flags,
+                              guint n_lines, GError **error);
+void logview_finder_add_lines(LogviewFinder *finder, guint n_lines);
+void logview_finder_stop(LogviewFinder *finder);
+gboolean logview_finder_has_pattern(LogviewFinder *finder);
+gboolean logview_finder_is_done(LogviewFinder *finder);
+
+guint logview_finder_get_n_matches(LogviewFinder *finder);
+const LogviewMatch *logview_finder_get_match(LogviewFinder *finder, guint i);
+guint logview_finder_get_first_match(LogviewFinder *finder, guint line);
+const LogviewMatch *logview_finder_get_line_matches(LogviewFinder *finder,
+                                                    guint line,
+                                                    guint *n_matches);
+
+G_END_DECLS
+
+#endif /* __LOGVIEW_FINDER_H__ */
@@ -0,0 +1,550 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib/gi18n.h>
+
+#include "logview-histogram.h"
+#include "logview-utils.h"
+
+/* The histogram shows how many lines each hour of the log has, with the
+ * lines matching the active filters over them. The counts come from the
+ * first line of each hour, which the days of the log already record, so
+ * the lines themselves aren't read; the matches are counted in the
+ * bitmaps of the filter engine of the view, as it fills them.
+ */
+
+#define HISTOGRAM_HEIGHT 48
+
+enum { LINE_ACTIVATED, LAST_SIGNAL };
+
+static guint signals[LAST_SIGNAL] = {0};
+
+/* an hour of a day, the empty hours between those of a day with lines
+ * get a bin too */
+typedef struct {
+  guint32 julian;
+  guint hour;
+  guint first_line;
+  guint n_lines;
+  guint n_matches;
+} HistogramBin;
+
+typedef struct {
+  GArray *bins;
+
+  /* the lines the bins were made for, and those with counted matches */
+  guint n_lines;
+  guint n_matched;
+} HistogramData;
+
+struct _LogviewHistogramPrivate {
+  LogviewFilterEngine *engine;
+  LogviewLog *log;
+
+  /* the bins of each log, kept for as long as the log is around */
+  GHashTable *cache;
+  HistogramData *data;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE(LogviewHistogram, logview_histogram,
+                           GTK_TYPE_DRAWING_AREA);
+
+static void histogram_data_free(HistogramData *data) {
+  g_array_free(data->bins, TRUE);
+  g_slice_free(HistogramData, data);
+}
+
+static void histogram_reset_matches(HistogramData *data) {
+  guint i;
+
+  for (i = 0; i < data->bins->len; i++) {
+    g_array_index(data->bins, HistogramBin, i).n_matches = 0;
+  }
+
+  data->n_matched = 0;
+}
+
+static void histogram_count_bin_matches(LogviewHistogram *histogram,
+                                        HistogramBin *bin, guint first_line,
+                                        guint last_line) {
+  first_line = MAX(first_line, bin->first_line);
+  last_line = MIN(last_line, bin->first_line + bin->n_lines);
+
+  if (first_line < last_line) {
+    bin->n_matches += logview_filter_engine_count_matches(
+        histogram->priv->engine, first_line, last_line);
+  }
+}
+
+/* counts the matches of the lines [first_line, last_line) in the bins
+ * they belong to */
+static void histogram_add_matches(LogviewHistogram *histogram,
+                                  guint first_line, guint last_line) {
+  GArray *bins = histogram->priv->data->bins;
+  HistogramBin *bin;
+  guint low, high, mid, i;
+
+  low = 0;
+  high = bins->len;
+
+  while (low < high) {
+    mid = (low + high) / 2;
+    bin = &g_array_index(bins, HistogramBin, mid);
+
+    if (bin->first_line + bin->n_lines <= first_line) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  for (i = low; i < bins->len; i++) {
+    bin = &g_array_index(bins, HistogramBin, i);
+
+    if (bin->first_line >= last_line) {
+      break;
+    }
+
+    histogram_count_bin_matches(histogram, bin, first_line, last_line);
+  }
+}
+
+static HistogramBin *histogram_last_bin(HistogramData *data) {
+  if (data->bins->len == 0) {
+    return NULL;
+  }
+
+  return &g_array_index(data->bins, HistogramBin, data->bins->len - 1);
+}
+
+/* the first hour after hour whose lines come after those of hour; with
+ * a change of DST or lines out of order, the hours in between can start
+ * before it, their lines are then counted with those of hour */
+static int day_next_hour(Day *day, int hour) {
+  int next;
+
+  for (next = hour + 1; next < 24; next++) {
+    if (day->hour_lines[next] > day->hour_lines[hour]) {
+      break;
+    }
+  }
+
+  return next;
+}
+
+/* the bins are kept in the order of their lines, even when the hours
+ * or the days aren't, so that they can be searched */
+static void histogram_add_day(HistogramData *data, Day *day) {
+  HistogramBin bin = {0}, *last;
+  int hour, next, end;
+  guint start = 0;
+
+  bin.julian = g_date_get_julian(day->date);
+
+  if ((last = histogram_last_bin(data)) != NULL) {
+    start = last->first_line + last->n_lines;
+  }
+
+  for (hour = 0; hour < 24 && day->hour_lines[hour] < 0; hour++) {
+  }
+
+  while (hour < 24) {
+    next = day_next_hour(day, hour);
+    end = (next < 24) ? day->hour_lines[next] : day->last_line + 1;
+
+    bin.hour = hour;
+    bin.first_line = MAX((guint)day->hour_lines[hour], start);
+    bin.n_lines = ((guint)end > bin.first_line) ? end - bin.first_line : 0;
+    g_array_append_val(data->bins, bin);
+
+    start = bin.first_line + bin.n_lines;
+
+    if (next == 24) {
+      break;
+    }
+
+    /* the empty hours in between jump to the next one */
+    for (hour++; hour < next; hour++) {
+      bin.hour = hour;
+      bin.first_line = start;
+      bin.n_lines = 0;
+      g_array_append_val(data->bins, bin);
+    }
+  }
+}
+
+/* makes the bins of the lines read since the last time; the last day
+ * can have grown, so its bins are made again too */
+static gboolean histogram_update_bins(LogviewHistogram *histogram) {
+  LogviewHistogramPrivate *priv = histogram->priv;
+  HistogramData *data = priv->data;
+  HistogramBin *bin;
+  GSList *l;
+  Day *day;
+  guint n_lines, first_bin, first_line = 0;
+
+  n_lines = logview_log_get_cached_lines_number(priv->log);
+
+  if (n_lines < data->n_lines) {
+    /* the log has been read again */
+    g_array_set_size(data->bins, 0);
+    data->n_lines = data->n_matched = 0;
+  }
+
+  if (n_lines == data->n_lines) {
+    return FALSE;
+  }
+
+  first_bin = data->bins->len;
+
+  if ((bin = histogram_last_bin(data)) != NULL) {
+    while (first_bin > 0 &&
+           g_array_index(data->bins, HistogramBin, first_bin - 1).julian ==
+               bin->julian) {
+      first_bin--;
+    }
+
+    first_line = g_array_index(data->bins, HistogramBin, first_bin).first_line;
+    g_array_set_size(data->bins, first_bin);
+  }
+
+  for (l = logview_log_get_days_for_cached_lines(priv->log); l != NULL;
+       l = l->next) {
+    day = l->data;
+
+    if (day->last_line >= 0 && (guint)day->last_line >= first_line) {
+      histogram_add_day(data, day);
+    }
+  }
+
+  /* the matches of the lines already filtered */
+  for (; first_bin < data->bins->len; first_bin++) {
+    histogram_count_bin_matches(
+        histogram, &g_array_index(data->bins, HistogramBin, first_bin), 0,
+        data->n_matched);
+  }
+
+  data->n_lines = n_lines;
+
+  return TRUE;
+}
+
+static void engine_lines_filtered_cb(LogviewFilterEngine *engine,
+                                     guint first_line, guint n_lines,
+                                     gpointer user_data) {
+  LogviewHistogram *histogram = user_data;
+  HistogramData *data = histogram->priv->data;
+
+  if (data == NULL) {
+    return;
+  }
+
+  if (first_line < data->n_matched) {
+    /* the filters have changed */
+    histogram_reset_matches(data);
+  }
+
+  histogram_add_matches(histogram, data->n_matched, first_line + n_lines);
+  data->n_matched = first_line + n_lines;
+
+  gtk_widget_queue_draw(GTK_WIDGET(histogram));
+}
+
+static void log_finalized_cb(gpointer user_data, GObject *log) {
+  LogviewHistogram *histogram = user_data;
+
+  g_hash_table_remove(histogram->priv->cache, log);
+}
+
+static gboolean histogram_get_bin_at(LogviewHistogram *histogram, gdouble x,
+                                     HistogramBin **bin) {
+  GArray *bins;
+  int width;
+  guint i;
+
+  if (histogram->priv->data == NULL ||
+      histogram->priv->data->bins->len == 0) {
+    return FALSE;
+  }
+
+  bins = histogram->priv->data->bins;
+  width = gtk_widget_get_allocated_width(GTK_WIDGET(histogram));
+
+  if (x < 0 || x >= width) {
+    return FALSE;
+  }
+
+  i = (guint)(x * bins->len / width);
+  *bin = &g_array_index(bins, HistogramBin, MIN(i, bins->len - 1));
+
+  return TRUE;
+}
+
+static gboolean logview_histogram_draw(GtkWidget *widget, cairo_t *cr) {
+  LogviewHistogram *histogram = LOGVIEW_HISTOGRAM(widget);
+  HistogramData *data = histogram->priv->data;
+  GtkStyleContext *context;
+  GtkStateFlags state;
+  GdkRGBA color, match_color, *background;
+  HistogramBin *bin;
+  gboolean filtered;
+  gdouble bar_width, x;
+  guint max_lines = 1, i;
+  int width, height;
+
+  width = gtk_widget_get_allocated_width(widget);
+  height = gtk_widget_get_allocated_height(widget);
+  context = gtk_widget_get_style_context(widget);
+  state = gtk_widget_get_state_flags(widget);
+
+  gtk_render_background(context, cr, 0, 0, width, height);
+
+  if (data == NULL || data->bins->len == 0) {
+    return FALSE;
+  }
+
+  gtk_style_context_save(context);
+  gtk_style_context_add_class(context, "dim-label");
+  gtk_style_context_get_color(context, state, &color);
+  gtk_style_context_restore(context);
+
+  gtk_style_context_save(context);
+  gtk_style_context_set_state(context, state | GTK_STATE_FLAG_SELECTED);
+  gtk_style_context_get(context, state | GTK_STATE_FLAG_SELECTED,
+                        GTK_STYLE_PROPERTY_BACKGROUND_COLOR, &background,
+                        NULL);
+  match_color = *background;
+  gdk_rgba_free(background);
+  gtk_style_context_restore(context);
+
+  for (i = 0; i < data->bins->len; i++) {
+    bin = &g_array_index(data->bins, HistogramBin, i);
+    max_lines = MAX(max_lines, bin->n_lines);
+  }
+
+  filtered = logview_filter_engine_get_n_filtered(histogram->priv->engine) > 0;
+  bar_width = (gdouble)width / data->bins->len;
+
+  for (i = 0; i < data->bins->len; i++) {
+    bin = &g_array_index(data->bins, HistogramBin, i);
+    x = i * bar_width;
+
+    gdk_cairo_set_source_rgba(cr, &color);
+    cairo_rectangle(cr, x, height,
+                    (bar_width > 2) ? bar_width - 1 : bar_width,
+                    -(gdouble)height * bin->n_lines / max_lines);
+    cairo_fill(cr);
+
+    if (filtered && bin->n_matches > 0) {
+      gdk_cairo_set_source_rgba(cr, &match_color);
+      cairo_rectangle(cr, x, height,
+                      (bar_width > 2) ? bar_width - 1 : bar_width,
+                      -(gdouble)height * bin->n_matches / max_lines);
+      cairo_fill(cr);
+    }
+  }
+
+  return FALSE;
+}
+
+static gboolean logview_histogram_button_press(GtkWidget *widget,
+                                               GdkEventButton *event) {
+  LogviewHistogram *histogram = LOGVIEW_HISTOGRAM(widget);
+  HistogramBin *bin;
+
+  if (event->button != GDK_BUTTON_PRIMARY ||
+      !histogram_get_bin_at(histogram, event->x, &bin)) {
+    return FALSE;
+  }
+
+  g_signal_emit(histogram, signals[LINE_ACTIVATED], 0, bin->first_line);
+
+  return TRUE;
+}
+
+static gboolean logview_histogram_query_tooltip(GtkWidget *widget, int x,
+                                                int y, gboolean keyboard_mode,
+                                                GtkTooltip *tooltip) {
+  LogviewHistogram *histogram = LOGVIEW_HISTOGRAM(widget);
+  HistogramBin *bin;
+  GDate date;
+  char date_str[200], *lines, *text;
+
+  if (keyboard_mode || !histogram_get_bin_at(histogram, x, &bin)) {
+    return FALSE;
+  }
+
+  g_date_clear(&date, 1);
+  g_date_set_julian(&date, bin->julian);
+  g_date_strftime(date_str, sizeof(date_str), "%x", &date);
+
+  lines = g_strdup_printf(
+      ngettext("%u line", "%u lines", bin->n_lines), bin->n_lines);
+
+  if (logview_filter_engine_get_n_filtered(histogram->priv->engine) > 0) {
+    /* Translators: a date and hour, then the number of lines and of
+     * those matching the filters */
+    text = g_strdup_printf(_("%s, %02u:00\n%s, %u matching"), date_str,
+                           bin->hour, lines, bin->n_matches);
+  } else {
+    /* Translators: a date and hour, then the number of lines */
+    text = g_strdup_printf(_("%s, %02u:00\n%s"), date_str, bin->hour, lines);
+  }
+
+  gtk_tooltip_set_text(tooltip, text);
+
+  g_free(lines);
+  g_free(text);
+
+  return TRUE;
+}
+
+static void logview_histogram_dispose(GObject *object) {
+  LogviewHistogramPrivate *priv = LOGVIEW_HISTOGRAM(object)->priv;
+  GHashTableIter iter;
+  gpointer log;
+
+  if (priv->engine != NULL) {
+    g_signal_handlers_disconnect_by_func(
+        priv->engine, G_CALLBACK(engine_lines_filtered_cb), object);
+    g_clear_object(&priv->engine);
+  }
+
+  if (priv->cache != NULL) {
+    g_hash_table_iter_init(&iter, priv->cache);
+
+    while (g_hash_table_iter_next(&iter, &log, NULL)) {
+      g_object_weak_unref(log, log_finalized_cb, object);
+    }
+
+    g_clear_pointer(&priv->cache, g_hash_table_destroy);
+  }
+
+  priv->data = NULL;
+  g_clear_object(&priv->log);
+
+  G_OBJECT_CLASS(logview_histogram_parent_class)->dispose(object);
+}
+
+static void logview_histogram_class_init(LogviewHistogramClass *klass) {
+  GObjectClass *object_class = G_OBJECT_CLASS(klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS(klass);
+
+  object_class->dispose = logview_histogram_dispose;
+
+  widget_class->draw = logview_histogram_draw;
+  widget_class->button_press_event = logview_histogram_button_press;
+  widget_class->query_tooltip = logview_histogram_query_tooltip;
+
+  signals[LINE_ACTIVATED] = g_signal_new(
+      "line-activated", G_OBJECT_CLASS_TYPE(object_class), G_SIGNAL_RUN_LAST,
+      G_STRUCT_OFFSET(LogviewHistogramClass, line_activated), NULL, NULL,
+      g_cclosure_marshal_VOID__UINT, G_TYPE_NONE, 1, G_TYPE_UINT);
+}
+
+static void logview_histogram_init(LogviewHistogram *histogram) {
+  LogviewHistogramPrivate *priv;
+
+  priv = histogram->priv = logview_histogram_get_instance_private(histogram);
+
+  priv->cache = g_hash_table_new_full(NULL, NULL, NULL,
+                                      (GDestroyNotify)histogram_data_free);
+
+  gtk_widget_set_size_request(GTK_WIDGET(histogram), -1, HISTOGRAM_HEIGHT);
+  gtk_widget_set_has_tooltip(GTK_WIDGET(histogram), TRUE);
+  gtk_widget_add_events(GTK_WIDGET(histogram), GDK_BUTTON_PRESS_MASK);
+  gtk_style_context_add_class(
+      gtk_widget_get_style_context(GTK_WIDGET(histogram)),
+      GTK_STYLE_CLASS_VIEW);
+}
+
+/* public methods */
+
+/* the matches counted are those of engine, which must be filtering the
+ * log the histogram shows */
+GtkWidget *logview_histogram_new(LogviewFilterEngine *engine) {
+  LogviewHistogram *histogram;
+
+  g_return_val_if_fail(LOGVIEW_IS_FILTER_ENGINE(engine), NULL);
+
+  histogram = g_object_new(LOGVIEW_TYPE_HISTOGRAM, NULL);
+  histogram->priv->engine = g_object_ref(engine);
+  g_signal_connect(engine, "lines-filtered",
+                   G_CALLBACK(engine_lines_filtered_cb), histogram);
+
+  return GTK_WIDGET(histogram);
+}
+
+void logview_histogram_set_log(LogviewHistogram *histogram, LogviewLog *log) {
+  LogviewHistogramPrivate *priv;
+
+  g_return_if_fail(LOGVIEW_IS_HISTOGRAM(histogram));
+
+  priv = histogram->priv;
+
+  g_clear_object(&priv->log);
+  priv->data = NULL;
+
+  if (log != NULL) {
+    priv->log = g_object_ref(log);
+    priv->data = g_hash_table_lookup(priv->cache, log);
+
+    if (priv->data == NULL) {
+      priv->data = g_slice_new0(HistogramData);
+      priv->data->bins = g_array_new(FALSE, FALSE, sizeof(HistogramBin));
+      g_hash_table_insert(priv->cache, log, priv->data);
+      g_object_weak_ref(G_OBJECT(log), log_finalized_cb, histogram);
+    }
+
+    /* the engine starts over with the log */
+    histogram_reset_matches(priv->data);
+    histogram_update_bins(histogram);
+  }
+
+  gtk_widget_queue_draw(GTK_WIDGET(histogram));
+}
+
+/* to be called when lines have been read, or the filters changed */
+void logview_histogram_update(LogviewHistogram *histogram) {
+  LogviewHistogramPrivate *priv;
+  gboolean changed = FALSE;
+
+  g_return_if_fail(LOGVIEW_IS_HISTOGRAM(histogram));
+
+  priv = histogram->priv;
+
+  if (priv->data == NULL) {
+    return;
+  }
+
+  if (logview_filter_engine_get_n_filtered(priv->engine) <
+      priv->data->n_matched) {
+    /* the engine started over, or has stopped */
+    histogram_reset_matches(priv->data);
+    changed = TRUE;
+  }
+
+  if (histogram_update_bins(histogram) || changed) {
+    gtk_widget_queue_draw(GTK_WIDGET(histogram));
+  }
+}
@@ -0,0 +1,72 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* logview-histogram.h */
+
+#ifndef __LOGVIEW_HISTOGRAM_H__
+#define __LOGVIEW_HISTOGRAM_H__
+
+#include <gtk/gtk.h>
+
+#include "logview-filter-engine.h"
+#include "logview-log.h"
+
+G_BEGIN_DECLS
+
+#define LOGVIEW_TYPE_HISTOGRAM logview_histogram_get_type()
+#define LOGVIEW_HISTOGRAM(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj), LOGVIEW_TYPE_HISTOGRAM, LogviewHistogram))
+#define LOGVIEW_HISTOGRAM_CLASS(klass)                      \
+  (G_TYPE_CHECK_CLASS_CAST((klass), LOGVIEW_TYPE_HISTOGRAM, \
+                           LogviewHistogramClass))
+#define LOGVIEW_IS_HISTOGRAM(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj), LOGVIEW_TYPE_HISTOGRAM))
+#define LOGVIEW_IS_HISTOGRAM_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass), LOGVIEW_TYPE_HISTOGRAM))
+#define LOGVIEW_HISTOGRAM_GET_CLASS(obj)                    \
+  (G_TYPE_INSTANCE_GET_CLASS((obj), LOGVIEW_TYPE_HISTOGRAM, \
+                             LogviewHistogramClass))
+
+typedef struct _LogviewHistogram LogviewHistogram;
+typedef struct _LogviewHistogramClass LogviewHistogramClass;
+typedef struct _LogviewHistogramPrivate LogviewHistogramPrivate;
+
+struct _LogviewHistogram {
+  GtkDrawingArea parent;
+  LogviewHistogramPrivate *priv;
+};
+
+struct _LogviewHistogramClass {
+  GtkDrawingAreaClass parent_class;
+
+  /* signals */
+  void (*line_activated)(LogviewHistogram *histogram, guint line);
+};
+
+GType logview_histogram_get_type(void);
+
+/* public methods */
+GtkWidget *logview_histogram_new(LogviewFilterEngine *engine);
+
+void logview_histogram_set_log(LogviewHistogram *histogram, LogviewLog *log);
+void logview_histogram_update(LogviewHistogram *histogram);
+
+G_END_DECLS
+
+#endif /* __LOGVIEW_HISTOGRAM_H__ */
@@ -0,0 +1,375 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "logview-index-cache.h"
+#include "logview-utils.h"
+
+/* The index of a plain log is saved under the user cache directory, so
+ * that the next time the log is opened only what has been appended to
+ * it since has to be read. The cache is only used for the same file
+ * (device and inode), if it hasn't shrunk and still starts with the
+ * same bytes; it holds no text of the log, only the length of each line,
+ * the days and the lines that aren't valid UTF-8.
+ */
+
+#define CACHE_MAGIC "LVINDEX2"
+#define CACHE_DIR "mate-system-log"
+
+/* the bytes at the start of the log that have to be the same */
+#define HEAD_LENGTH 4096
+
+/* smaller logs are indexed faster than the cache is read */
+#define MIN_CACHED_SIZE (64 * 1024)
+
+typedef struct {
+  char magic[8];
+
+  /* the log when the cache was written */
+  guint64 dev;
+  guint64 inode;
+  guint64 size;
+  gint64 mtime;
+  guint8 head_digest[16];
+
+  /* the bytes covered by the lines */
+  guint64 end;
+
+  guint32 format;
+  guint32 n_lines;
+  guint32 n_days;
+  guint32 n_invalid;
+} CacheHeader;
+
+typedef struct {
+  guint32 julian;
+  gint32 first_line;
+  gint32 last_line;
+  gint32 timestamp_len;
+  gint32 hour_lines[24];
+} CacheDay;
+
+typedef struct {
+  guint32 first;
+  guint32 last;
+} CacheRange;
+
+static char *cache_get_filename(const char *path) {
+  char *checksum, *basename, *filename;
+
+  checksum = g_compute_checksum_for_string(G_CHECKSUM_SHA1, path, -1);
+  basename = g_strconcat(checksum, ".index", NULL);
+  filename =
+      g_build_filename(g_get_user_cache_dir(), CACHE_DIR, basename, NULL);
+
+  g_free(basename);
+  g_free(checksum);
+
+  return filename;
+}
+
+/* the head is read rather than mapped, the log can be truncated under
+ * a mapping */
+static gboolean get_head_digest(int fd, guint64 size, guint8 *digest) {
+  GChecksum *checksum;
+  guchar head[HEAD_LENGTH];
+  gsize digest_len = 16;
+  gssize len;
+
+  len = (gssize)MIN(size, HEAD_LENGTH);
+
+  if (pread(fd, head, len, 0) != len) {
+    return FALSE;
+  }
+
+  checksum = g_checksum_new(G_CHECKSUM_MD5);
+  g_checksum_update(checksum, head, len);
+  g_checksum_get_digest(checksum, digest, &digest_len);
+  g_checksum_free(checksum);
+
+  return TRUE;
+}
+
+static GSList *cache_read_days(const CacheDay *cached, guint n_days,
+                               guint n_lines) {
+  GSList *days = NULL;
+  Day *day;
+  guint i;
+
+  for (i = 0; i < n_days; i++) {
+    if (!g_date_valid_julian(cached[i].julian) ||
+        cached[i].first_line < 0 ||
+        cached[i].first_line > cached[i].last_line ||
+        (guint)cached[i].last_line >= n_lines) {
+      g_slist_free_full(days, (GDestroyNotify)logview_utils_day_free);
+      return NULL;
+    }
+
+    day = g_slice_new0(Day);
+    day->date = g_date_new_julian(cached[i].julian);
+    day->first_line = cached[i].first_line;
+    day->last_line = cached[i].last_line;
+    day->timestamp_len = cached[i].timestamp_len;
+    memcpy(day->hour_lines, cached[i].hour_lines, sizeof(day->hour_lines));
+
+    days = g_slist_prepend(days, day);
+  }
+
+  return g_slist_reverse(days);
+}
+
+static gboolean cache_read_invalid(const CacheRange *cached, guint n_invalid,
+                                   guint n_lines, GArray **invalid) {
+  GArray *ranges;
+  guint i;
+
+  ranges = g_array_sized_new(FALSE, FALSE, sizeof(LineRange), n_invalid);
+
+  for (i = 0; i < n_invalid; i++) {
+    if (cached[i].first > cached[i].last || cached[i].last >= n_lines ||
+        (i > 0 && cached[i].first <= cached[i - 1].last)) {
+      g_array_unref(ranges);
+      return FALSE;
+    }
+
+    logview_utils_line_ranges_add(ranges, cached[i].first, cached[i].last);
+  }
+
+  *invalid = ranges;
+
+  return TRUE;
+}
+
+/**
+ * logview_index_cache_load:
+ *
+ * @path: the path of the log.
+ * @fd: a descriptor of the log.
+ * @index: return location for the index of the cached lines.
+ * @days: return location for the days of the cached lines.
+ * @invalid: return location for the #LineRange of the cached lines
+ *   that aren't valid UTF-8.
+ * @format: return location for the format of the timestamps.
+ *
+ * Returns: whether the log had a valid cache; the lines after it are
+ *   still to be read.
+ */
+gboolean logview_index_cache_load(const char *path, int fd,
+                                  LogviewLineIndex **index, GSList **days,
+                                  GArray **invalid,
+                                  LogviewTimestampFormat *format) {
+  const CacheHeader *header;
+  const CacheDay *cached_days;
+  const CacheRange *cached_invalid;
+  const guint32 *lengths;
+  LogviewLineIndex *new_index;
+  struct stat st;
+  guint8 digest[16];
+  char *filename, *data = NULL;
+  gsize data_len, length;
+  gboolean retval = FALSE;
+
+  if (fstat(fd, &st) != 0 || st.st_size < MIN_CACHED_SIZE) {
+    return FALSE;
+  }
+
+  length = (gsize)st.st_size;
+
+  filename = cache_get_filename(path);
+
+  if (!g_file_get_contents(filename, &data, &data_len, NULL) ||
+      data_len < sizeof(CacheHeader)) {
+    goto out;
+  }
+
+  header = (const CacheHeader *)data;
+
+  if (memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+      data_len != sizeof(CacheHeader) + header->n_days * sizeof(CacheDay) +
+                      header->n_invalid * sizeof(CacheRange) +
+                      header->n_lines * sizeof(guint32)) {
+    goto out;
+  }
+
+  /* a log of the same size has to be unchanged, a longer one has been
+   * appended to */
+  if (header->dev != (guint64)st.st_dev ||
+      header->inode != (guint64)st.st_ino || header->size > length ||
+      (header->size == length && header->mtime != (gint64)st.st_mtime) ||
+      header->end > header->size) {
+    goto out;
+  }
+
+  if (!get_head_digest(fd, header->size, digest) ||
+      memcmp(digest, header->head_digest, sizeof(digest)) != 0) {
+    goto out;
+  }
+
+  cached_days = (const CacheDay *)(header + 1);
+  cached_invalid = (const CacheRange *)(cached_days + header->n_days);
+  lengths = (const guint32 *)(cached_invalid + header->n_invalid);
+
+  new_index = logview_line_index_new();
+  logview_line_index_add_lengths(new_index, 0, lengths, header->n_lines);
+
+  if (logview_line_index_get_end(new_index) != header->end ||
+      !cache_read_invalid(cached_invalid, header->n_invalid, header->n_lines,
+                          invalid)) {
+    logview_line_index_free(new_index);
+    goto out;
+  }
+
+  *index = new_index;
+  *days = cache_read_days(cached_days, header->n_days, header->n_lines);
+  *format = header->format;
+  retval = TRUE;
+
+out:
+  g_free(data);
+  g_free(filename);
+
+  return retval;
+}
+
+static void cache_saved_cb(GObject *source, GAsyncResult *result,
+                           gpointer user_data) {
+  /* the cache is only there to save time, a failure doesn't matter */
+  g_file_replace_contents_finish(G_FILE(source), result, NULL, NULL);
+}
+
+/* writes the cache of the log in the background */
+void logview_index_cache_save(const char *path, int fd,
+                              LogviewLineIndex *index, GSList *days,
+                              GArray *invalid, LogviewTimestampFormat format) {
+  CacheHeader *header;
+  CacheDay *cached_days;
+  CacheRange *cached_invalid;
+  LineRange *range;
+  guint32 *lengths;
+  struct stat st;
+  GFile *file;
+  GBytes *bytes;
+  GSList *l;
+  char *filename, *dirname;
+  guint n_lines, n_days, n_invalid, i, hour;
+  gsize size;
+
+  if (fstat(fd, &st) != 0 || st.st_size < MIN_CACHED_SIZE) {
+    return;
+  }
+
+  /* the lines that might still grow are left out */
+  lengths = logview_line_index_get_lengths(index, &n_lines);
+
+  n_days = 0;
+  for (l = days; l != NULL; l = l->next) {
+    if (((Day *)l->data)->first_line < (int)n_lines) {
+      n_days++;
+    }
+  }
+
+  n_invalid = 0;
+  for (i = 0; i < invalid->len; i++) {
+    if (g_array_index(invalid, LineRange, i).first < n_lines) {
+      n_invalid++;
+    }
+  }
+
+  size = sizeof(CacheHeader) + n_days * sizeof(CacheDay) +
+         n_invalid * sizeof(CacheRange) + n_lines * sizeof(guint32);
+  header = g_malloc0(size);
+
+  memcpy(header->magic, CACHE_MAGIC, sizeof(header->magic));
+  header->dev = st.st_dev;
+  header->inode = st.st_ino;
+  header->size = st.st_size;
+  header->mtime = st.st_mtime;
+  header->format = format;
+  header->n_lines = n_lines;
+  header->n_days = n_days;
+  header->n_invalid = n_invalid;
+
+  for (i = 0; i < n_lines; i++) {
+    header->end += lengths[i];
+  }
+
+  if (!get_head_digest(fd, header->size, header->head_digest)) {
+    g_free(lengths);
+    g_free(header);
+    return;
+  }
+
+  cached_days = (CacheDay *)(header + 1);
+
+  for (l = days, i = 0; l != NULL && i < n_days; l = l->next) {
+    Day *day = l->data;
+
+    if (day->first_line >= (int)n_lines) {
+      continue;
+    }
+
+    cached_days[i].julian = g_date_get_julian(day->date);
+    cached_days[i].first_line = day->first_line;
+    cached_days[i].last_line = MIN(day->last_line, (int)n_lines - 1);
+    cached_days[i].timestamp_len = day->timestamp_len;
+
+    for (hour = 0; hour < 24; hour++) {
+      cached_days[i].hour_lines[hour] =
+          (day->hour_lines[hour] < (int)n_lines) ? day->hour_lines[hour] : -1;
+    }
+
+    i++;
+  }
+
+  cached_invalid = (CacheRange *)(cached_days + n_days);
+
+  for (i = 0; i < n_invalid; i++) {
+    range = &g_array_index(invalid, LineRange, i);
+    cached_invalid[i].first = range->first;
+    cached_invalid[i].last = MIN(range->last, n_lines - 1);
+  }
+
+  memcpy(cached_invalid + n_invalid, lengths, n_lines * sizeof(guint32));
+  g_free(lengths);
+
+  filename = cache_get_filename(path);
+  dirname = g_path_get_dirname(filename);
+  g_mkdir_with_parents(dirname, 0700);
+
+  file = g_file_new_for_path(filename);
+  bytes = g_bytes_new_take(header, size);
+  g_file_replace_contents_bytes_async(
+      file, bytes, NULL, FALSE,
+      G_FILE_CREATE_PRIVATE | G_FILE_CREATE_REPLACE_DESTINATION, NULL,
+      cache_saved_cb, NULL);
+
+  g_bytes_unref(bytes);
+  g_object_unref(file);
+  g_free(dirname);
+  g_free(filename);
+}
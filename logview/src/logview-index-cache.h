@@ -0,0 +1,42 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* logview-index-cache.h */
+
+#ifndef __LOGVIEW_INDEX_CACHE_H__
+#define __LOGVIEW_INDEX_CACHE_H__
+
+#include <glib.h>
+
+#include "logview-line-index.h"
+#include "logview-timestamp.h"
+
+G_BEGIN_DECLS
+
+gboolean logview_index_cache_load(const char *path, int fd,
+                                  LogviewLineIndex **index, GSList **days,
+                                  GArray **invalid,
+                                  LogviewTimestampFormat *format);
+void logview_index_cache_save(const char *path, int fd,
+                              LogviewLineIndex *index, GSList *days,
+                              GArray *invalid, LogviewTimestampFormat format);
+
+G_END_DECLS
+
+#endif /* __LOGVIEW_INDEX_CACHE_H__ */
@@ -0,0 +1,52 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* logview-journal.h */
+
+#ifndef __LOGVIEW_JOURNAL_H__
+#define __LOGVIEW_JOURNAL_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _LogviewJournal LogviewJournal;
+
+typedef void (*LogviewJournalChangedFunc)(gpointer user_data);
+
+void logview_journal_set_matches(char **matches);
+
+gboolean logview_journal_is_journal(const char *path, gboolean is_directory);
+LogviewJournal *logview_journal_open(const char *path, gboolean is_directory,
+                                     GError **error);
+void logview_journal_free(LogviewJournal *journal);
+
+guint64 logview_journal_get_usage(LogviewJournal *journal);
+void logview_journal_watch(LogviewJournal *journal,
+                           LogviewJournalChangedFunc func, gpointer user_data);
+
+guint logview_journal_read_entries(LogviewJournal *journal, guint *first_entry,
+                                   GArray *times, GError **error);
+const char *logview_journal_get_line(LogviewJournal *journal, guint entry,
+                                     gsize *len);
+gsize logview_journal_format_time(gint64 usec, char *buf, gsize size);
+
+G_END_DECLS
+
+#endif /* __LOGVIEW_JOURNAL_H__ */
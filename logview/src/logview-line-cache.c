@@ -0,0 +1,271 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <unistd.h>
+
+#include "logview-line-cache.h"
+
+/* The cache reads the text of the lines of a plain log back from the
+ * file, only the index of the lines is kept in memory.
+ *
+ * The lines are read BLOCK_LINES at a time, with a single pread(), and
+ * only the blocks used last are kept, up to CACHE_BYTES: going through
+ * the whole log costs a read per block, not the size of the log in
+ * memory. Each thread holds on to the block of the line it got last,
+ * whose text then stays valid when the block is dropped by another
+ * thread, and which is looked at first for the next line.
+ */
+
+#define BLOCK_LINES 256
+#define CACHE_BYTES (4 * 1024 * 1024)
+
+typedef struct {
+  /* the cache the block was read by, which might be gone */
+  guint cache_id;
+
+  guint first_line;
+  guint n_lines;
+  guint64 base;
+  gsize size;
+
+  GList lru_link;
+  char data[];
+} CacheBlock;
+
+struct _LogviewLineCache {
+  guint id;
+  int fd;
+
+  GMutex lock;
+  GHashTable *blocks;
+
+  /* the blocks, the one used last first */
+  GQueue lru;
+  gsize bytes;
+};
+
+static guint next_cache_id = 0;
+
+/* the block of the line each thread got last */
+static GPrivate pinned_block = G_PRIVATE_INIT(g_atomic_rc_box_release);
+
+/* the descriptor isn't owned by the cache, it's only read; -1 if the
+ * lines can't be read back anymore */
+LogviewLineCache *logview_line_cache_new(int fd) {
+  LogviewLineCache *cache;
+
+  cache = g_slice_new0(LogviewLineCache);
+  cache->id = (guint)g_atomic_int_add(&next_cache_id, 1);
+  cache->fd = fd;
+  g_mutex_init(&cache->lock);
+  cache->blocks = g_hash_table_new(NULL, NULL);
+
+  return cache;
+}
+
+void logview_line_cache_free(LogviewLineCache *cache) {
+  GList *link;
+
+  if (cache == NULL) {
+    return;
+  }
+
+  /* the blocks pinned by a thread stay until it gets another line */
+  while ((link = g_queue_pop_head_link(&cache->lru)) != NULL) {
+    g_atomic_rc_box_release(link->data);
+  }
+
+  g_hash_table_destroy(cache->blocks);
+  g_mutex_clear(&cache->lock);
+  g_slice_free(LogviewLineCache, cache);
+}
+
+static gboolean block_has_line(CacheBlock *block, guint line) {
+  return line >= block->first_line && line - block->first_line < block->n_lines;
+}
+
+/* reads the lines of a block that are indexed, returns NULL if none of
+ * them could be read, e.g. the file has been truncated meanwhile */
+static CacheBlock *cache_read_block(LogviewLineCache *cache,
+                                    LogviewLineIndex *index, guint number) {
+  CacheBlock *block;
+  guint64 base, start;
+  gsize size, done, len;
+  guint first_line, n_lines, line;
+  gssize n_read;
+
+  first_line = number * BLOCK_LINES;
+  n_lines = MIN(BLOCK_LINES,
+                logview_line_index_get_n_lines(index) - first_line);
+
+  if (cache->fd < 0 ||
+      !logview_line_index_get_line(index, first_line, &base, &len) ||
+      !logview_line_index_get_line(index, first_line + n_lines - 1, &start,
+                                   &len)) {
+    return NULL;
+  }
+
+  size = (gsize)(start + len - base);
+  block = g_atomic_rc_box_alloc0(sizeof(CacheBlock) + size);
+
+  for (done = 0; done < size; done += n_read) {
+    n_read = pread(cache->fd, block->data + done, size - done,
+                   (off_t)(base + done));
+
+    if (n_read < 0 && errno == EINTR) {
+      n_read = 0;
+    } else if (n_read <= 0) {
+      break;
+    }
+  }
+
+  /* only the lines read whole */
+  for (line = first_line; line < first_line + n_lines; line++) {
+    logview_line_index_get_line(index, line, &start, &len);
+
+    if (start + len - base > done) {
+      break;
+    }
+  }
+
+  if (line == first_line) {
+    g_atomic_rc_box_release(block);
+    return NULL;
+  }
+
+  block->cache_id = cache->id;
+  block->first_line = first_line;
+  block->n_lines = line - first_line;
+  block->base = base;
+  block->size = size;
+  block->lru_link.data = block;
+
+  return block;
+}
+
+/* adds a block that has just been read, in place of the one with fewer
+ * lines it might have been read again for */
+static void cache_add_block(LogviewLineCache *cache, guint number,
+                            CacheBlock *block) {
+  CacheBlock *old;
+
+  old = g_hash_table_lookup(cache->blocks, GUINT_TO_POINTER(number));
+
+  if (old != NULL) {
+    g_queue_unlink(&cache->lru, &old->lru_link);
+    cache->bytes -= old->size;
+    g_atomic_rc_box_release(old);
+  }
+
+  g_hash_table_insert(cache->blocks, GUINT_TO_POINTER(number),
+                      g_atomic_rc_box_acquire(block));
+  g_queue_push_head_link(&cache->lru, &block->lru_link);
+  cache->bytes += block->size;
+
+  while (cache->bytes > CACHE_BYTES && cache->lru.length > 1) {
+    old = g_queue_pop_tail_link(&cache->lru)->data;
+    g_hash_table_remove(cache->blocks,
+                        GUINT_TO_POINTER(old->first_line / BLOCK_LINES));
+    cache->bytes -= old->size;
+    g_atomic_rc_box_release(old);
+  }
+}
+
+/* returns a reference to the block of line, read if needed */
+static CacheBlock *cache_get_block(LogviewLineCache *cache,
+                                   LogviewLineIndex *index, guint line) {
+  CacheBlock *block;
+  guint number = line / BLOCK_LINES;
+
+  g_mutex_lock(&cache->lock);
+
+  block = g_hash_table_lookup(cache->blocks, GUINT_TO_POINTER(number));
+
+  if (block != NULL && block_has_line(block, line)) {
+    if (cache->lru.head != &block->lru_link) {
+      g_queue_unlink(&cache->lru, &block->lru_link);
+      g_queue_push_head_link(&cache->lru, &block->lru_link);
+    }
+
+    g_mutex_unlock(&cache->lock);
+    return g_atomic_rc_box_acquire(block);
+  }
+
+  g_mutex_unlock(&cache->lock);
+
+  /* the file is read without the lock, another thread might read the
+   * same block meanwhile */
+  block = cache_read_block(cache, index, number);
+
+  if (block != NULL) {
+    g_mutex_lock(&cache->lock);
+    cache_add_block(cache, number, block);
+    g_mutex_unlock(&cache->lock);
+  }
+
+  return block;
+}
+
+/**
+ * logview_line_cache_get_line:
+ *
+ * @cache: a #LogviewLineCache.
+ * @index: the index of the lines of the file, which doesn't change
+ *   meanwhile.
+ * @line: the number of a line of @index.
+ * @len: return location for the length of the line.
+ *
+ * Returns: the text of the line, not NUL-terminated, which is only valid
+ *   until the calling thread gets another line from a cache; %NULL if
+ *   the line can't be read from the file anymore.
+ */
+const char *logview_line_cache_get_line(LogviewLineCache *cache,
+                                        LogviewLineIndex *index, guint line,
+                                        gsize *len) {
+  CacheBlock *block;
+  guint64 start;
+
+  if (!logview_line_index_get_line(index, line, &start, len)) {
+    return NULL;
+  }
+
+  block = g_private_get(&pinned_block);
+
+  if (block == NULL || block->cache_id != cache->id ||
+      !block_has_line(block, line)) {
+    block = cache_get_block(cache, index, line);
+
+    if (block == NULL || !block_has_line(block, line)) {
+      if (block != NULL) {
+        g_atomic_rc_box_release(block);
+      }
+
+      return NULL;
+    }
+
+    g_private_replace(&pinned_block, block);
+  }
+
+  return block->data + (start - block->base);
+}
@@ -0,0 +1,42 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* logview-line-cache.h */
+
+#ifndef __LOGVIEW_LINE_CACHE_H__
+#define __LOGVIEW_LINE_CACHE_H__
+
+#include <glib.h>
+
+#include "logview-line-index.h"
+
+G_BEGIN_DECLS
+
+typedef struct _LogviewLineCache LogviewLineCache;
+
+LogviewLineCache *logview_line_cache_new(int fd);
+void logview_line_cache_free(LogviewLineCache *cache);
+
+const char *logview_line_cache_get_line(LogviewLineCache *cache,
+                                        LogviewLineIndex *index, guint line,
+                                        gsize *len);
+
+G_END_DECLS
+
+#endif /* __LOGVIEW_LINE_CACHE_H__ */
@@ -0,0 +1,326 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "logview-line-index.h"
+
+/* The index keeps the start offset of every line of a log.
+ *
+ * Offsets are stored in blocks of up to BLOCK_LINES lines: each block
+ * has a 64 bits base offset and 32 bits offsets relative to it, so a
+ * line costs four bytes instead of a pointer plus a malloc'd string.
+ * A block is closed early when a relative offset would not fit in 32
+ * bits, which is why blocks are looked up by binary search.
+ */
+
+#define BLOCK_LINES 1024
+
+typedef struct {
+  guint64 base;
+  guint first_line;
+  guint n_lines;
+  guint32 rel[BLOCK_LINES];
+} IndexBlock;
+
+struct _LogviewLineIndex {
+  GPtrArray *blocks;
+  guint n_lines;
+
+  /* offset right after the last indexed line */
+  guint64 end;
+
+  /* lines cut by the end of the data instead of a newline, sorted */
+  GArray *unterminated;
+};
+
+LogviewLineIndex *logview_line_index_new(void) {
+  LogviewLineIndex *index;
+
+  index = g_slice_new0(LogviewLineIndex);
+  index->blocks = g_ptr_array_new_with_free_func(g_free);
+  index->unterminated = g_array_new(FALSE, FALSE, sizeof(guint));
+
+  return index;
+}
+
+void logview_line_index_free(LogviewLineIndex *index) {
+  if (index == NULL) {
+    return;
+  }
+
+  g_ptr_array_free(index->blocks, TRUE);
+  g_array_free(index->unterminated, TRUE);
+  g_slice_free(LogviewLineIndex, index);
+}
+
+guint logview_line_index_get_n_lines(LogviewLineIndex *index) {
+  return index->n_lines;
+}
+
+guint64 logview_line_index_get_end(LogviewLineIndex *index) {
+  return index->end;
+}
+
+static void index_append_line(LogviewLineIndex *index, guint64 start) {
+  IndexBlock *block = NULL;
+
+  if (index->blocks->len > 0) {
+    block = g_ptr_array_index(index->blocks, index->blocks->len - 1);
+
+    if (block->n_lines == BLOCK_LINES || start - block->base > G_MAXUINT32) {
+      block = NULL;
+    }
+  }
+
+  if (block == NULL) {
+    block = g_new(IndexBlock, 1);
+    block->base = start;
+    block->first_line = index->n_lines;
+    block->n_lines = 0;
+    g_ptr_array_add(index->blocks, block);
+  }
+
+  block->rel[block->n_lines++] = (guint32)(start - block->base);
+  index->n_lines++;
+}
+
+static IndexBlock *index_lookup_block(LogviewLineIndex *index, guint line) {
+  IndexBlock *block;
+  guint low, high, mid;
+
+  low = 0;
+  high = index->blocks->len;
+
+  while (high - low > 1) {
+    mid = low + (high - low) / 2;
+    block = g_ptr_array_index(index->blocks, mid);
+
+    if (block->first_line > line) {
+      high = mid;
+    } else {
+      low = mid;
+    }
+  }
+
+  return g_ptr_array_index(index->blocks, low);
+}
+
+static guint64 index_get_start(LogviewLineIndex *index, guint line) {
+  IndexBlock *block;
+
+  block = index_lookup_block(index, line);
+
+  return block->base + block->rel[line - block->first_line];
+}
+
+static gboolean index_is_unterminated(LogviewLineIndex *index, guint line) {
+  guint low, high, mid;
+
+  low = 0;
+  high = index->unterminated->len;
+
+  while (low < high) {
+    mid = low + (high - low) / 2;
+
+    if (g_array_index(index->unterminated, guint, mid) < line) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  return low < index->unterminated->len &&
+         g_array_index(index->unterminated, guint, low) == line;
+}
+
+/**
+ * logview_line_index_get_line:
+ *
+ * @index: a #LogviewLineIndex.
+ * @line: the line number.
+ * @start: return location for the offset of the line.
+ * @len: return location for the length of the line, without the newline.
+ *
+ * Returns: %FALSE if @line is out of range.
+ */
+gboolean logview_line_index_get_line(LogviewLineIndex *index, guint line,
+                                     guint64 *start, gsize *len) {
+  guint64 line_start, line_end;
+
+  if (line >= index->n_lines) {
+    return FALSE;
+  }
+
+  line_start = index_get_start(index, line);
+
+  if (line + 1 < index->n_lines) {
+    line_end = index_get_start(index, line + 1);
+  } else {
+    line_end = index->end;
+  }
+
+  if (!index_is_unterminated(index, line)) {
+    /* strip the newline */
+    line_end--;
+  }
+
+  *start = line_start;
+  *len = (gsize)(line_end - line_start);
+
+  return TRUE;
+}
+
+/**
+ * logview_line_index_scan:
+ *
+ * @index: a #LogviewLineIndex.
+ * @data: the bytes following the last indexed line.
+ * @data_offset: the offset of @data, which must be the end of the index
+ *   unless the index is empty.
+ * @len: the length of @data.
+ * @at_eof: whether @data ends the log.
+ *
+ * Indexes the lines found in @data. A trailing line without a newline is
+ * indexed only if @at_eof is set, and the next scan will then start a
+ * new line; otherwise it's left for the next scan.
+ *
+ * Returns: the offset right after the last indexed line.
+ */
+guint64 logview_line_index_scan(LogviewLineIndex *index, const char *data,
+                                guint64 data_offset, gsize len,
+                                gboolean at_eof) {
+  const char *p, *nl, *data_end;
+
+  g_return_val_if_fail(index->n_lines == 0 || data_offset == index->end,
+                       index->end);
+
+  p = data;
+  data_end = data + len;
+
+  /* memchr is vectorized by the C library, so this runs at memory speed
+   * on long lines */
+  while (p < data_end && (nl = memchr(p, '\n', data_end - p)) != NULL) {
+    index_append_line(index, data_offset + (p - data));
+    p = nl + 1;
+  }
+
+  if (p < data_end && at_eof) {
+    g_array_append_val(index->unterminated, index->n_lines);
+    index_append_line(index, data_offset + (p - data));
+    p = data_end;
+  }
+
+  index->end = data_offset + (p - data);
+
+  return index->end;
+}
+
+/* appends the lines of @other, which must start where @index ends */
+void logview_line_index_append_index(LogviewLineIndex *index,
+                                     LogviewLineIndex *other) {
+  guint i, j, first_line;
+
+  g_return_if_fail(other->n_lines == 0 ||
+                   index_get_start(other, 0) == index->end);
+
+  first_line = index->n_lines;
+
+  for (i = 0; i < other->blocks->len; i++) {
+    IndexBlock *block = g_ptr_array_index(other->blocks, i);
+
+    for (j = 0; j < block->n_lines; j++) {
+      index_append_line(index, block->base + block->rel[j]);
+    }
+  }
+
+  for (i = 0; i < other->unterminated->len; i++) {
+    guint line = g_array_index(other->unterminated, guint, i) + first_line;
+
+    g_array_append_val(index->unterminated, line);
+  }
+
+  if (other->n_lines > 0) {
+    index->end = other->end;
+  }
+}
+
+/**
+ * logview_line_index_get_lengths:
+ *
+ * @index: a #LogviewLineIndex.
+ * @n_lines: return location for the number of lengths.
+ *
+ * Returns the length of each line with its newline, from the first one
+ * up to the first line without a newline, which might still grow. This
+ * is the compact form used to save the index.
+ *
+ * Returns: a newly allocated array of lengths.
+ */
+guint32 *logview_line_index_get_lengths(LogviewLineIndex *index,
+                                        guint *n_lines) {
+  guint32 *lengths;
+  guint64 start, next;
+  guint line, n;
+
+  n = index->n_lines;
+
+  if (index->unterminated->len > 0) {
+    n = MIN(n, g_array_index(index->unterminated, guint, 0));
+  }
+
+  lengths = g_new(guint32, MAX(n, 1));
+  start = (n > 0) ? index_get_start(index, 0) : 0;
+
+  for (line = 0; line < n; line++) {
+    next = (line + 1 < index->n_lines) ? index_get_start(index, line + 1)
+                                       : index->end;
+
+    if (next - start > G_MAXUINT32) {
+      break;
+    }
+
+    lengths[line] = (guint32)(next - start);
+    start = next;
+  }
+
+  *n_lines = line;
+
+  return lengths;
+}
+
+/* appends n_lines lines of the given lengths starting at start, which
+ * must be the end of the index unless it's empty */
+void logview_line_index_add_lengths(LogviewLineIndex *index, guint64 start,
+                                    const guint32 *lengths, guint n_lines) {
+  guint line;
+
+  g_return_if_fail(index->n_lines == 0 || start == index->end);
+
+  for (line = 0; line < n_lines; line++) {
+    index_append_line(index, start);
+    start += lengths[line];
+  }
+
+  index->end = start;
+}
@@ -0,0 +1,52 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* logview-line-index.h */
+
+#ifndef __LOGVIEW_LINE_INDEX_H__
+#define __LOGVIEW_LINE_INDEX_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _LogviewLineIndex LogviewLineIndex;
+
+LogviewLineIndex *logview_line_index_new(void);
+void logview_line_index_free(LogviewLineIndex *index);
+
+guint logview_line_index_get_n_lines(LogviewLineIndex *index);
+guint64 logview_line_index_get_end(LogviewLineIndex *index);
+gboolean logview_line_index_get_line(LogviewLineIndex *index, guint line,
+                                     guint64 *start, gsize *len);
+
+guint64 logview_line_index_scan(LogviewLineIndex *index, const char *data,
+                                guint64 data_offset, gsize len,
+                                gboolean at_eof);
+void logview_line_index_append_index(LogviewLineIndex *index,
+                                     LogviewLineIndex *other);
+
+guint32 *logview_line_index_get_lengths(LogviewLineIndex *index,
+                                        guint *n_lines);
+void logview_line_index_add_lengths(LogviewLineIndex *index, guint64 start,
+                                    const guint32 *lengths, guint n_lines);
+
+G_END_DECLS
+
+#endif /* __LOGVIEW_LINE_INDEX_H__ */
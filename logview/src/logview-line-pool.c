@@ -0,0 +1,314 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "logview-line-pool.h"
+
+/* The pool runs a job over the lines of a log in a pool of threads, a
+ * chunk of lines at a time, for the filter engine and the finder.
+ * Chunks can finish in any order, but they are handed back to the main
+ * thread in line order, so that the lines [0, n_done) are always done.
+ *
+ * The reader lock of the lines is only held for BATCH_LINES lines at a
+ * time, the main thread takes the writer one to add the lines it has
+ * read and shouldn't wait for a whole chunk.
+ *
+ * Restarting or stopping bumps the generation, the chunks of older
+ * ones are dropped. Every chunk holds a reference on the pool and on
+ * its job, so the owner can free the pool with chunks still running.
+ */
+
+#define BATCH_LINES 256
+
+typedef struct {
+  gint ref_count;
+
+  LogviewLog *log;
+  gpointer data;
+  GDestroyNotify data_free;
+} LinePoolJob;
+
+struct _LogviewLinePool {
+  gint ref_count;
+  GThreadPool *threads;
+
+  const LogviewLinePoolFuncs *funcs;
+  gpointer user_data;
+  guint chunk_lines;
+
+  /* bumped on every restart, chunks of older ones are dropped */
+  gint generation;
+
+  /* NULL when stopped */
+  LinePoolJob *job;
+
+  /* lines pushed to the threads, and lines done */
+  guint n_lines;
+  guint n_done;
+
+  /* finished chunks waiting for the ones before them */
+  GHashTable *pending;
+};
+
+typedef struct {
+  LogviewLinePool *pool;
+  LinePoolJob *job;
+  gint generation;
+
+  guint first_line;
+  guint n_lines;
+
+  /* from chunk_new(), NULL if the chunk was dropped before it ran */
+  gpointer data;
+} LinePoolChunk;
+
+static LinePoolJob *line_pool_job_ref(LinePoolJob *job) {
+  g_atomic_int_inc(&job->ref_count);
+
+  return job;
+}
+
+static void line_pool_job_unref(LinePoolJob *job) {
+  if (!g_atomic_int_dec_and_test(&job->ref_count)) {
+    return;
+  }
+
+  g_object_unref(job->log);
+
+  if (job->data_free != NULL) {
+    job->data_free(job->data);
+  }
+
+  g_slice_free(LinePoolJob, job);
+}
+
+static LogviewLinePool *line_pool_ref(LogviewLinePool *pool) {
+  g_atomic_int_inc(&pool->ref_count);
+
+  return pool;
+}
+
+/* only ever dropped in the main thread, the last chunk can't be
+ * waiting for itself */
+static void line_pool_unref(LogviewLinePool *pool) {
+  if (!g_atomic_int_dec_and_test(&pool->ref_count)) {
+    return;
+  }
+
+  g_thread_pool_free(pool->threads, TRUE, TRUE);
+  g_hash_table_destroy(pool->pending);
+
+  g_slice_free(LogviewLinePool, pool);
+}
+
+static void line_pool_chunk_free(LinePoolChunk *chunk) {
+  if (chunk->data != NULL) {
+    chunk->pool->funcs->chunk_free(chunk->data);
+  }
+
+  line_pool_job_unref(chunk->job);
+  line_pool_unref(chunk->pool);
+
+  g_slice_free(LinePoolChunk, chunk);
+}
+
+static gboolean line_pool_chunk_is_stale(LinePoolChunk *chunk) {
+  return chunk->generation != g_atomic_int_get(&chunk->pool->generation);
+}
+
+/* runs in the main thread */
+static gboolean line_pool_chunk_done(gpointer data) {
+  LinePoolChunk *chunk = data;
+  LogviewLinePool *pool = chunk->pool;
+  guint first_line;
+
+  if (line_pool_chunk_is_stale(chunk)) {
+    line_pool_chunk_free(chunk);
+    return FALSE;
+  }
+
+  g_hash_table_insert(pool->pending, GUINT_TO_POINTER(chunk->first_line),
+                      chunk);
+
+  first_line = pool->n_done;
+
+  while ((chunk = g_hash_table_lookup(
+              pool->pending, GUINT_TO_POINTER(pool->n_done))) != NULL) {
+    g_hash_table_steal(pool->pending, GUINT_TO_POINTER(pool->n_done));
+
+    pool->funcs->chunk_done(chunk->data, pool->user_data);
+    pool->n_done += chunk->n_lines;
+
+    line_pool_chunk_free(chunk);
+  }
+
+  if (pool->n_done > first_line) {
+    pool->funcs->lines_done(first_line, pool->n_done - first_line,
+                            pool->user_data);
+  }
+
+  return FALSE;
+}
+
+/* runs in one of the threads */
+static void line_pool_chunk_func(gpointer data, gpointer user_data) {
+  LinePoolChunk *chunk = data;
+  LogviewLinePool *pool = user_data;
+  LogviewLog *log = chunk->job->log;
+  const char *text;
+  char *converted;
+  gsize len;
+  guint line, last_line, batch_end;
+
+  if (line_pool_chunk_is_stale(chunk)) {
+    goto out;
+  }
+
+  chunk->data = pool->funcs->chunk_new(chunk->job->data, chunk->first_line,
+                                       chunk->n_lines);
+  last_line = chunk->first_line + chunk->n_lines;
+
+  for (line = chunk->first_line; line < last_line; line = batch_end) {
+    /* give up early on a job that has been replaced */
+    if (line_pool_chunk_is_stale(chunk)) {
+      break;
+    }
+
+    batch_end = MIN(line + BATCH_LINES, last_line);
+
+    logview_log_lock_lines(log);
+
+    for (; line < batch_end; line++) {
+      /* the jobs work on what is shown */
+      text = logview_log_get_line_utf8(log, line, &len, &converted);
+
+      if (text == NULL) {
+        continue;
+      }
+
+      pool->funcs->chunk_line(chunk->data, chunk->job->data, line, text, len);
+      g_free(converted);
+    }
+
+    logview_log_unlock_lines(log);
+  }
+
+out:
+  /* even dropped chunks go back to the main thread, which owns the
+   * pool */
+  g_idle_add(line_pool_chunk_done, chunk);
+}
+
+LogviewLinePool *logview_line_pool_new(const LogviewLinePoolFuncs *funcs,
+                                       guint chunk_lines, gpointer user_data) {
+  LogviewLinePool *pool;
+
+  pool = g_slice_new0(LogviewLinePool);
+  pool->ref_count = 1;
+  pool->funcs = funcs;
+  pool->user_data = user_data;
+  pool->chunk_lines = chunk_lines;
+  pool->threads = g_thread_pool_new(line_pool_chunk_func, pool,
+                                    (gint)g_get_num_processors(), FALSE, NULL);
+  pool->pending = g_hash_table_new_full(NULL, NULL, NULL,
+                                        (GDestroyNotify)line_pool_chunk_free);
+
+  return pool;
+}
+
+/* stops the pool, which goes away once the chunks still running are
+ * back; user_data isn't used anymore */
+void logview_line_pool_free(LogviewLinePool *pool) {
+  if (pool == NULL) {
+    return;
+  }
+
+  logview_line_pool_stop(pool);
+  line_pool_unref(pool);
+}
+
+/* drops the job so far and runs one with job_data on the first n_lines
+ * of log; job_data is shared by the threads and freed with
+ * job_data_free once the last chunk is done with it */
+void logview_line_pool_start(LogviewLinePool *pool, LogviewLog *log,
+                             gpointer job_data, GDestroyNotify job_data_free,
+                             guint n_lines) {
+  LinePoolJob *job;
+
+  logview_line_pool_stop(pool);
+
+  job = g_slice_new0(LinePoolJob);
+  job->ref_count = 1;
+  job->log = g_object_ref(log);
+  job->data = job_data;
+  job->data_free = job_data_free;
+
+  pool->job = job;
+
+  logview_line_pool_add_lines(pool, n_lines);
+}
+
+/* the log now has n_lines, run the job on the new ones */
+void logview_line_pool_add_lines(LogviewLinePool *pool, guint n_lines) {
+  LinePoolChunk *chunk;
+
+  if (pool->job == NULL) {
+    return;
+  }
+
+  while (pool->n_lines < n_lines) {
+    chunk = g_slice_new0(LinePoolChunk);
+    chunk->pool = line_pool_ref(pool);
+    chunk->job = line_pool_job_ref(pool->job);
+    chunk->generation = pool->generation;
+    chunk->first_line = pool->n_lines;
+    chunk->n_lines = MIN(pool->chunk_lines, n_lines - pool->n_lines);
+
+    pool->n_lines += chunk->n_lines;
+
+    g_thread_pool_push(pool->threads, chunk, NULL);
+  }
+}
+
+void logview_line_pool_stop(LogviewLinePool *pool) {
+  /* the chunks still queued or running will notice and give up */
+  g_atomic_int_inc(&pool->generation);
+  g_hash_table_remove_all(pool->pending);
+
+  g_clear_pointer(&pool->job, line_pool_job_unref);
+
+  pool->n_lines = 0;
+  pool->n_done = 0;
+}
+
+/* the data of the job running, or NULL if the pool is stopped */
+gpointer logview_line_pool_get_job_data(LogviewLinePool *pool) {
+  return (pool->job != NULL) ? pool->job->data : NULL;
+}
+
+guint logview_line_pool_get_n_lines(LogviewLinePool *pool) {
+  return pool->n_lines;
+}
+
+guint logview_line_pool_get_n_done(LogviewLinePool *pool) {
+  return pool->n_done;
+}
@@ -0,0 +1,63 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* logview-line-pool.h */
+
+#ifndef __LOGVIEW_LINE_POOL_H__
+#define __LOGVIEW_LINE_POOL_H__
+
+#include <glib.h>
+
+#include "logview-log.h"
+
+G_BEGIN_DECLS
+
+typedef struct _LogviewLinePool LogviewLinePool;
+
+typedef struct {
+  /* in a pool thread, the state of the chunk of n_lines from first_line */
+  gpointer (*chunk_new)(gpointer job_data, guint first_line, guint n_lines);
+  /* in a pool thread, for each line of the chunk as it's shown */
+  void (*chunk_line)(gpointer chunk, gpointer job_data, guint line,
+                     const char *text, gsize len);
+  /* in the main thread, for each chunk in line order */
+  void (*chunk_done)(gpointer chunk, gpointer user_data);
+  void (*chunk_free)(gpointer chunk);
+
+  /* in the main thread, once some chunks are done */
+  void (*lines_done)(guint first_line, guint n_lines, gpointer user_data);
+} LogviewLinePoolFuncs;
+
+LogviewLinePool *logview_line_pool_new(const LogviewLinePoolFuncs *funcs,
+                                       guint chunk_lines, gpointer user_data);
+void logview_line_pool_free(LogviewLinePool *pool);
+
+void logview_line_pool_start(LogviewLinePool *pool, LogviewLog *log,
+                             gpointer job_data, GDestroyNotify job_data_free,
+                             guint n_lines);
+void logview_line_pool_add_lines(LogviewLinePool *pool, guint n_lines);
+void logview_line_pool_stop(LogviewLinePool *pool);
+
+gpointer logview_line_pool_get_job_data(LogviewLinePool *pool);
+guint logview_line_pool_get_n_lines(LogviewLinePool *pool);
+guint logview_line_pool_get_n_done(LogviewLinePool *pool);
+
+G_END_DECLS
+
+#endif /* __LOGVIEW_LINE_POOL_H__ */
@@ -0,0 +1,234 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "logview-line-store.h"
+
+/* The store keeps the text of the lines of a log read from a stream,
+ * compressed or remote, and of the last lines of the files of a plain
+ * log; their other lines are read back from the file instead, see
+ * logview-line-cache.c.
+ *
+ * The text of the lines is copied one line after the other into chunks
+ * of CHUNK_SIZE bytes, which are only ever appended to, and each line
+ * has an entry with its chunk and offset: a line costs twelve bytes
+ * more than its text, instead of a pointer and a malloc'd string, and
+ * the store is freed with a free per chunk. A line longer than a chunk
+ * gets a chunk of its own.
+ */
+
+#define CHUNK_SIZE (1024 * 1024)
+
+typedef struct {
+  gsize size;
+  gsize used;
+  char data[];
+} StoreChunk;
+
+typedef struct {
+  /* counted from the first chunk ever added to the store */
+  guint32 chunk;
+  guint32 offset;
+  guint32 len;
+} StoreLine;
+
+struct _LogviewLineStore {
+  GPtrArray *chunks;
+  GArray *lines;
+
+  /* the number of the chunk at the start of chunks, the ones before
+   * it have been dropped */
+  guint first_chunk;
+
+  /* the length of the lines, counting a newline for each */
+  gsize bytes;
+};
+
+LogviewLineStore *logview_line_store_new(void) {
+  LogviewLineStore *store;
+
+  store = g_slice_new0(LogviewLineStore);
+  store->chunks = g_ptr_array_new_with_free_func(g_free);
+  store->lines = g_array_new(FALSE, FALSE, sizeof(StoreLine));
+
+  return store;
+}
+
+void logview_line_store_free(LogviewLineStore *store) {
+  if (store == NULL) {
+    return;
+  }
+
+  g_ptr_array_free(store->chunks, TRUE);
+  g_array_free(store->lines, TRUE);
+  g_slice_free(LogviewLineStore, store);
+}
+
+guint logview_line_store_get_n_lines(LogviewLineStore *store) {
+  return store->lines->len;
+}
+
+gsize logview_line_store_get_bytes(LogviewLineStore *store) {
+  return store->bytes;
+}
+
+/* the text isn't NUL-terminated */
+const char *logview_line_store_get_line(LogviewLineStore *store, guint line,
+                                        gsize *len) {
+  StoreLine *entry;
+  StoreChunk *chunk;
+
+  g_assert(line < store->lines->len);
+
+  entry = &g_array_index(store->lines, StoreLine, line);
+  chunk = g_ptr_array_index(store->chunks, entry->chunk - store->first_chunk);
+
+  *len = entry->len;
+  return chunk->data + entry->offset;
+}
+
+void logview_line_store_append(LogviewLineStore *store, const char *text,
+                               gsize len) {
+  StoreChunk *chunk = NULL;
+  StoreLine entry;
+
+  if (store->chunks->len > 0) {
+    chunk = g_ptr_array_index(store->chunks, store->chunks->len - 1);
+
+    if (chunk->size - chunk->used < len) {
+      chunk = NULL;
+    }
+  }
+
+  if (chunk == NULL) {
+    chunk = g_malloc(sizeof(StoreChunk) + MAX(len, CHUNK_SIZE));
+    chunk->size = MAX(len, CHUNK_SIZE);
+    chunk->used = 0;
+    g_ptr_array_add(store->chunks, chunk);
+  }
+
+  entry.chunk = store->first_chunk + store->chunks->len - 1;
+  entry.offset = (guint32)chunk->used;
+  entry.len = (guint32)len;
+
+  memcpy(chunk->data + chunk->used, text, len);
+  chunk->used += len;
+
+  g_array_append_val(store->lines, entry);
+  store->bytes += len + 1;
+}
+
+/**
+ * logview_line_store_move:
+ *
+ * @store: a #LogviewLineStore.
+ * @other: the store to take the lines of, which is left empty.
+ *
+ * Appends the lines of @other to @store. Unless there are only a few,
+ * the chunks of @other are handed over as they are and the text is
+ * not copied.
+ */
+void logview_line_store_move(LogviewLineStore *store,
+                             LogviewLineStore *other) {
+  StoreChunk *chunk;
+  StoreLine *entry;
+  const char *text;
+  gsize len;
+  guint first, i;
+
+  if (other->lines->len == 0) {
+    return;
+  }
+
+  if (other->bytes < CHUNK_SIZE / 16) {
+    /* a few lines, as when following a log, are cheaper to copy than
+     * to keep in a chunk of their own */
+    for (i = 0; i < other->lines->len; i++) {
+      text = logview_line_store_get_line(other, i, &len);
+      logview_line_store_append(store, text, len);
+    }
+
+    g_ptr_array_set_size(other->chunks, 0);
+    g_array_set_size(other->lines, 0);
+    other->first_chunk = 0;
+    other->bytes = 0;
+    return;
+  }
+
+  if (store->chunks->len > 0) {
+    /* nothing goes in the space left in the last chunk anymore */
+    chunk = g_ptr_array_index(store->chunks, store->chunks->len - 1);
+    chunk->size = chunk->used;
+    g_ptr_array_index(store->chunks, store->chunks->len - 1) =
+        g_realloc(chunk, sizeof(StoreChunk) + chunk->size);
+  }
+
+  first = store->first_chunk + store->chunks->len;
+
+  for (i = 0; i < other->chunks->len; i++) {
+    g_ptr_array_add(store->chunks, g_ptr_array_index(other->chunks, i));
+  }
+
+  for (i = 0; i < other->lines->len; i++) {
+    entry = &g_array_index(other->lines, StoreLine, i);
+    entry->chunk = entry->chunk - other->first_chunk + first;
+  }
+
+  g_array_append_vals(store->lines, other->lines->data, other->lines->len);
+  store->bytes += other->bytes;
+
+  /* the chunks now belong to store */
+  g_ptr_array_set_free_func(other->chunks, NULL);
+  g_ptr_array_set_size(other->chunks, 0);
+  g_ptr_array_set_free_func(other->chunks, g_free);
+  g_array_set_size(other->lines, 0);
+  other->first_chunk = 0;
+  other->bytes = 0;
+}
+
+/* forgets the first n_lines lines, and frees the chunks left without
+ * lines */
+void logview_line_store_drop_first(LogviewLineStore *store, guint n_lines) {
+  StoreLine *entry;
+  guint i, n_chunks;
+
+  g_assert(n_lines <= store->lines->len);
+
+  for (i = 0; i < n_lines; i++) {
+    entry = &g_array_index(store->lines, StoreLine, i);
+    store->bytes -= entry->len + 1;
+  }
+
+  g_array_remove_range(store->lines, 0, n_lines);
+
+  if (store->lines->len == 0) {
+    n_chunks = store->chunks->len;
+  } else {
+    entry = &g_array_index(store->lines, StoreLine, 0);
+    n_chunks = entry->chunk - store->first_chunk;
+  }
+
+  g_ptr_array_remove_range(store->chunks, 0, n_chunks);
+  store->first_chunk += n_chunks;
+}
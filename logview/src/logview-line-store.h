@@ -0,0 +1,46 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* logview-line-store.h */
+
+#ifndef __LOGVIEW_LINE_STORE_H__
+#define __LOGVIEW_LINE_STORE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _LogviewLineStore LogviewLineStore;
+
+LogviewLineStore *logview_line_store_new(void);
+void logview_line_store_free(LogviewLineStore *store);
+
+guint logview_line_store_get_n_lines(LogviewLineStore *store);
+gsize logview_line_store_get_bytes(LogviewLineStore *store);
+const char *logview_line_store_get_line(LogviewLineStore *store, guint line,
+                                        gsize *len);
+
+void logview_line_store_append(LogviewLineStore *store, const char *text,
+                               gsize len);
+void logview_line_store_move(LogviewLineStore *store, LogviewLineStore *other);
+void logview_line_store_drop_first(LogviewLineStore *store, guint n_lines);
+
+G_END_DECLS
+
+#endif /* __LOGVIEW_LINE_STORE_H__ */
@@ -26,18 +26,47 @@
 #include <gio/gio.h>
 #include <glib.h>
 #include <glib/gi18n.h>
-
-#ifdef HAVE_ZLIB
-#include <zlib.h>
-#endif
-
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "logview-decompressor.h"
+#include "logview-index-cache.h"
+#include "logview-journal.h"
+#include "logview-line-cache.h"
+#include "logview-line-index.h"
+#include "logview-line-store.h"
 #include "logview-log.h"
+#include "logview-merge.h"
 #include "logview-utils.h"
 
 enum { LOG_CHANGED, LAST_SIGNAL };
 
 static guint signals[LAST_SIGNAL] = {0};
 
+/* a file of a plain log, which is read with pread() rather than mapped:
+ * it can be truncated, e.g. by copytruncate, and the pages of a mapping
+ * past its new end would fault. Only the index of the lines is kept,
+ * with the text of the last ones up to the tail limits; the others are
+ * read through the cache. A file that has been rotated is still read
+ * from its descriptor, one that has been truncated has no cache
+ * anymore and only its tail is left */
+typedef struct {
+  int fd;
+  LogviewLineIndex *index;
+  LogviewLineCache *cache;
+
+  /* the text of the lines of index from tail_first on */
+  LogviewLineStore *tail;
+  guint tail_first;
+
+  /* the line of the log the file starts at */
+  guint first_line;
+} LogFile;
+
 struct _LogviewLogPrivate {
   /* file and monitor */
   GFile *file;
@@ -49,54 +78,249 @@ struct _LogviewLogPrivate {
   char *display_name;
   gboolean has_days;
 
+  /* detected on the first timestamp, then used for all the lines */
+  LogviewTimestampFormat timestamp_format;
+
   /* lines and relative days */
   GSList *days;
-  GPtrArray *lines;
+  LogviewLineStore *lines;
   guint lines_no;
 
-  /* stream poiting to the log */
+  /* the lines that are not valid UTF-8, found once as they are read */
+  GArray *invalid_lines;
+
+  /* held by the main thread while it adds lines, and by other threads
+   * while they read them */
+  GRWLock lines_lock;
+
+  /* plain local logs are indexed, the text of their lines is read back
+   * from the file when it's needed, but for the tail of the file; the
+   * file followed is kept open to go on reading it after it has been
+   * rotated */
+  char *path;
+  LogFile *followed;
+
+  /* the files the one followed replaced, the oldest first */
+  GPtrArray *old_files;
+
+  /* the entries of a systemd journal are kept, and formatted, by the
+   * journal itself */
+  LogviewJournal *journal;
+
+  /* the lines in the index cache, as it was last written */
+  guint saved_lines;
+
+  /* the oldest lines of a stream are moved out of lines, to an unlinked
+   * temporary file that is mapped to read them back; those of a plain
+   * log are dropped from the tail of its file */
+  guint tail_lines;
+  gsize tail_bytes;
+  guint spilled_lines;
+  int spill_fd;
+  GMappedFile *spill_map;
+  LogviewLineIndex *spill_index;
+
+  /* a job is writing lines to the file, only one at a time */
+  gboolean spilling;
+
+  /* stream poiting to the log, read by one job at a time */
   GDataInputStream *stream;
+  GConverter *converter;
+  LogviewCompression compression;
+  GMutex stream_lock;
   gboolean has_new_lines;
+
+  /* whether a read went through the whole log yet */
+  gboolean loaded;
+
+  /* a log created lazily only has its stats until it's first read, the
+   * reads asked meanwhile wait for it to be opened */
+  gboolean opened;
+  GError *open_error;
+  gpointer open_job;
+  GSList *pending_reads;
+
+  /* a merged log has the lines of its sources, in the order of their
+   * timestamps, and reads them from the sources */
+  GPtrArray *sources;
+  LogviewMergeSource *merge_sources;
+  LogviewMerge *merge;
 };
 
 typedef struct {
   LogviewLog *log;
   GError *err;
+
+  /* whether to open the log, or only to get its stats */
+  gboolean open;
+
+  /* the stats of the file, applied in the main thread, where the name,
+   * size and time of the log are read */
+  GFileInfo *info;
+
+  /* NULL when the log is opened for its first read */
   LogviewCreateCallback callback;
   gpointer user_data;
 } LoadJob;
 
+/* a read waiting for the log to be opened */
+typedef struct {
+  GCancellable *cancellable;
+  LogviewNewLinesCallback callback;
+  GDestroyNotify done;
+  gpointer user_data;
+} PendingRead;
+
+/* logs are loaded by a few threads at most, so that opening many of
+ * them doesn't hold back the one shown */
+#define LOAD_THREADS 4
+
+static GThreadPool *load_pool = NULL;
+
 typedef struct {
   LogviewLog *log;
   GError *err;
-  const char **lines;
+
+  /* where the job starts reading, taken when it's scheduled; streams
+   * are read in batches, the first line then moves with each batch */
+  guint first_line;
+  guint64 start_offset;
+
+  /* the new lines, copied from a stream, or their index in the file
+   * and the text of the last ones; they are added to the log in the
+   * main thread */
+  LogviewLineStore *lines;
+  LogviewLineIndex *index;
+
+  /* a copy of the descriptor of the file followed, and the number of
+   * files it replaced when the job was scheduled */
+  int fd;
+  guint n_old_files;
+
+  /* the lines of the file that replaced it, or of the file itself read
+   * again from its start if it was truncated */
+  int new_fd;
+  LogviewLineStore *new_lines;
+  LogviewLineIndex *new_index;
+
+  /* the text of the lines of a file is only copied for its last
+   * tail_bytes, the others are read back to date them */
+  gsize tail_bytes;
+  LogviewLineCache *cache;
+  LogviewLineCache *new_cache;
+
+  /* the new lines that are not valid UTF-8, or NULL */
+  GArray *invalid;
+
+  /* the times of the new entries of a journal, the lines are dated on
+   * them alone */
+  GArray *times;
+  char time_text[64];
+
+  /* for a merged log, the sources still being read, then what's left
+   * of their lines merged */
+  guint pending_sources;
+  LogviewMergeSource *merge_sources;
+  LogviewMerge *merge;
+
   GSList *new_days;
+  LogviewTimestampFormat timestamp_format;
   GCancellable *cancellable;
   LogviewNewLinesCallback callback;
+  GDestroyNotify done;
   gpointer user_data;
 } NewLinesJob;
 
+/* the oldest lines of a stream, written to the spill file in a thread;
+ * the main thread then only drops them from the cache */
 typedef struct {
-  GInputStream *parent_str;
-  guchar *buffer;
-  GFile *file;
+  LogviewLog *log;
+
+  /* the spill file, opened by the job if the log had none yet */
+  int fd;
+  guint64 end;
 
-  gboolean last_str_result;
-  int last_z_result;
-  z_stream zstream;
-} GZHandle;
+  /* the number of lines written, from the first one of the cache, their
+   * index in the file and its new mapping */
+  guint n_lines;
+  LogviewLineIndex *index;
+  GMappedFile *map;
+} SpillJob;
 
 G_DEFINE_TYPE_WITH_PRIVATE(LogviewLog, logview_log, G_TYPE_OBJECT);
 
+static LogFile *log_file_new(int fd, LogviewLineIndex *index) {
+  LogFile *file;
+
+  file = g_slice_new0(LogFile);
+  file->fd = fd;
+  file->index = index;
+  file->cache = logview_line_cache_new(fd);
+  file->tail = logview_line_store_new();
+  file->tail_first = logview_line_index_get_n_lines(index);
+
+  return file;
+}
+
+static void log_file_free(LogFile *file) {
+  logview_line_index_free(file->index);
+  logview_line_cache_free(file->cache);
+  logview_line_store_free(file->tail);
+
+  if (file->fd >= 0) {
+    g_close(file->fd, NULL);
+  }
+
+  g_slice_free(LogFile, file);
+}
+
+/* the lines that can't be read back, e.g. those of a file that has
+ * been truncated, are shown empty */
+static const char *log_file_get_line(LogFile *file, guint line, gsize *len) {
+  const char *text = NULL;
+
+  line -= file->first_line;
+
+  if (line >= file->tail_first) {
+    return logview_line_store_get_line(file->tail, line - file->tail_first,
+                                       len);
+  }
+
+  if (file->cache != NULL) {
+    text = logview_line_cache_get_line(file->cache, file->index, line, len);
+  }
+
+  if (text == NULL) {
+    *len = 0;
+    text = "";
+  }
+
+  return text;
+}
+
+static void merge_sources_free(LogviewMergeSource *sources, guint n_sources) {
+  guint i;
+
+  for (i = 0; i < n_sources; i++) {
+    g_slist_free_full(sources[i].days, (GDestroyNotify)logview_utils_day_free);
+  }
+
+  g_free(sources);
+}
+
 static void do_finalize(GObject *obj) {
   LogviewLog *log = LOGVIEW_LOG(obj);
-  char **lines;
+  guint i;
 
   if (log->priv->stream) {
     g_object_unref(log->priv->stream);
     log->priv->stream = NULL;
   }
 
+  g_clear_object(&log->priv->converter);
+  g_mutex_clear(&log->priv->stream_lock);
+  g_rw_lock_clear(&log->priv->lines_lock);
+
   if (log->priv->file) {
     g_object_unref(log->priv->file);
     log->priv->file = NULL;
@@ -112,10 +336,30 @@ static void do_finalize(GObject *obj) {
     log->priv->days = NULL;
   }
 
-  if (log->priv->lines) {
-    lines = (char **)g_ptr_array_free(log->priv->lines, FALSE);
-    g_strfreev(lines);
-    log->priv->lines = NULL;
+  g_clear_pointer(&log->priv->lines, logview_line_store_free);
+  g_clear_pointer(&log->priv->followed, log_file_free);
+  g_clear_error(&log->priv->open_error);
+  g_array_unref(log->priv->invalid_lines);
+  g_ptr_array_free(log->priv->old_files, TRUE);
+  g_free(log->priv->path);
+  logview_journal_free(log->priv->journal);
+
+  g_clear_pointer(&log->priv->spill_map, g_mapped_file_unref);
+  g_clear_pointer(&log->priv->spill_index, logview_line_index_free);
+
+  if (log->priv->spill_fd >= 0) {
+    g_close(log->priv->spill_fd, NULL);
+  }
+
+  if (log->priv->sources != NULL) {
+    for (i = 0; i < log->priv->sources->len; i++) {
+      g_signal_handlers_disconnect_by_data(
+          g_ptr_array_index(log->priv->sources, i), log);
+    }
+
+    merge_sources_free(log->priv->merge_sources, log->priv->sources->len);
+    g_ptr_array_free(log->priv->sources, TRUE);
+    logview_merge_free(log->priv->merge);
   }
 
   G_OBJECT_CLASS(logview_log_parent_class)->finalize(obj);
@@ -137,10 +381,21 @@ static void logview_log_init(LogviewLog *self) {
 
   self->priv->lines = NULL;
   self->priv->lines_no = 0;
+  self->priv->invalid_lines = g_array_new(FALSE, FALSE, sizeof(LineRange));
+  self->priv->path = NULL;
+  self->priv->followed = NULL;
+  self->priv->old_files =
+      g_ptr_array_new_with_free_func((GDestroyNotify)log_file_free);
+  self->priv->spill_fd = -1;
+  self->priv->converter = NULL;
+  self->priv->compression = LOGVIEW_COMPRESSION_NONE;
+  g_mutex_init(&self->priv->stream_lock);
+  g_rw_lock_init(&self->priv->lines_lock);
   self->priv->days = NULL;
   self->priv->file = NULL;
   self->priv->mon = NULL;
   self->priv->has_new_lines = FALSE;
+  self->priv->loaded = FALSE;
   self->priv->has_days = FALSE;
 }
 
@@ -149,16 +404,33 @@ static void monitor_changed_cb(GFileMonitor *monitor, GFile *file,
                                gpointer user_data) {
   LogviewLog *log = user_data;
 
-  if (event == G_FILE_MONITOR_EVENT_CHANGED) {
+  /* a log that is rotated is deleted, or moved away, and created again;
+   * the next read goes through what is left of the old file and then
+   * follows the new one */
+  if (event == G_FILE_MONITOR_EVENT_CHANGED ||
+      event == G_FILE_MONITOR_EVENT_CREATED ||
+      event == G_FILE_MONITOR_EVENT_DELETED) {
     log->priv->has_new_lines = TRUE;
     g_signal_emit(log, signals[LOG_CHANGED], 0, NULL);
   }
-  /* TODO: handle the case where the log is deleted? */
+}
+
+static void journal_changed_cb(gpointer user_data) {
+  LogviewLog *log = user_data;
+
+  log->priv->has_new_lines = TRUE;
+  g_signal_emit(log, signals[LOG_CHANGED], 0, NULL);
 }
 
 static void setup_file_monitor(LogviewLog *log) {
   GError *err = NULL;
 
+  /* the journal tells about its new entries itself */
+  if (log->priv->journal != NULL) {
+    logview_journal_watch(log->priv->journal, journal_changed_cb, log);
+    return;
+  }
+
   log->priv->mon = g_file_monitor(log->priv->file, 0, NULL, &err);
   if (err) {
     /* it'd be strange to get this error at this point but whatever */
@@ -176,14 +448,12 @@ static void setup_file_monitor(LogviewLog *log) {
                    log);
 }
 
-static GSList *add_new_days_to_cache(LogviewLog *log, const char **new_lines,
-                                     guint lines_offset) {
-  GSList *new_days, *l, *last_cached;
-  int res;
+static void add_new_days_to_cache(LogviewLog *log, GSList *new_days,
+                                  guint lines_offset) {
+  GSList *l, *last_cached;
+  int res, hour;
   Day *day, *last;
 
-  new_days = log_read_dates(new_lines, log->priv->file_time);
-
   /* the days are stored in chronological order, so we compare the last cached
    * one with the new we got.
    */
@@ -192,7 +462,7 @@ static GSList *add_new_days_to_cache(LogviewLog *log, const char **new_lines,
   if (!last_cached) {
     /* this means the day list is empty (i.e. we're on the first read */
     log->priv->days = logview_utils_day_list_copy(new_days);
-    return new_days;
+    return;
   }
 
   for (l = new_days; l; l = l->next) {
@@ -203,489 +473,1307 @@ static GSList *add_new_days_to_cache(LogviewLog *log, const char **new_lines,
       /* this day in the list is newer than the last one, append to
        * the cache.
        */
+      day = logview_utils_day_copy(day);
       day->first_line += lines_offset;
       day->last_line += lines_offset;
-      log->priv->days =
-          g_slist_append(log->priv->days, logview_utils_day_copy(day));
+      log->priv->days = g_slist_append(log->priv->days, day);
     } else if (res == 0) {
       last = last_cached->data;
 
       /* update the lines number */
-      last->last_line += day->last_line;
+      last->last_line = lines_offset + day->last_line;
+
+      for (hour = 0; hour < 24; hour++) {
+        if (last->hour_lines[hour] < 0 && day->hour_lines[hour] >= 0) {
+          last->hour_lines[hour] = lines_offset + day->hour_lines[hour];
+        }
+      }
     }
   }
-
-  return new_days;
 }
 
-static gboolean new_lines_job_done(gpointer data) {
-  NewLinesJob *job = data;
+/* the lines of a plain log can always be read back from its file, the
+ * memory taken by their text is bounded even without a limit */
+#define FILE_TAIL_BYTES (8 * 1024 * 1024)
 
-  if (job->err) {
-    job->callback(job->log, NULL, NULL, job->err, job->user_data);
-    g_error_free(job->err);
-  } else {
-    job->callback(job->log, job->lines, job->new_days, job->err,
-                  job->user_data);
+static gsize log_get_tail_bytes(LogviewLog *log) {
+  if (log->priv->followed != NULL && log->priv->tail_bytes == 0) {
+    return FILE_TAIL_BYTES;
   }
 
-  g_clear_object(&job->cancellable);
+  return log->priv->tail_bytes;
+}
 
-  g_slist_free_full(job->new_days, (GDestroyNotify)logview_utils_day_free);
+static gboolean log_over_tail(LogviewLog *log, guint n_lines, gsize bytes,
+                              gboolean slack) {
+  LogviewLogPrivate *priv = log->priv;
+  guint max_lines = priv->tail_lines;
+  gsize max_bytes = log_get_tail_bytes(log);
+
+  /* once over the limits, go down to 3/4 of them so that this doesn't
+   * happen for every new line */
+  if (slack) {
+    max_lines -= max_lines / 4;
+    max_bytes -= max_bytes / 4;
+  }
 
-  /* drop the reference we acquired before */
-  g_object_unref(job->log);
+  return (max_lines > 0 && n_lines > max_lines) ||
+         (max_bytes > 0 && bytes > max_bytes);
+}
 
-  g_slice_free(NewLinesJob, job);
+static gboolean write_all(int fd, const char *data, gsize len) {
+  gssize res;
 
-  return FALSE;
+  while (len > 0) {
+    res = write(fd, data, len);
+
+    if (res < 0) {
+      return FALSE;
+    }
+
+    data += res;
+    len -= res;
+  }
+
+  return TRUE;
 }
 
-static gboolean do_read_new_lines(GIOSchedulerJob *io_job,
-                                  GCancellable *cancellable,
-                                  gpointer user_data) {
+static gboolean spill_job_done(gpointer data);
+
+static gboolean do_spill_lines(GIOSchedulerJob *io_job,
+                               GCancellable *cancellable, gpointer user_data) {
   /* this runs in a separate thread */
-  NewLinesJob *job = user_data;
+  SpillJob *job = user_data;
   LogviewLog *log = job->log;
-  char *line;
-  GError *err = NULL;
-  GPtrArray *lines;
+  LogviewLogPrivate *priv = log->priv;
+  GString *buffer;
+  const char *line;
+  char *path;
+  gsize bytes, len;
+  guint n_lines, n_spill;
 
-  g_assert(LOGVIEW_IS_LOG(log));
-  g_assert(log->priv->stream != NULL);
+  if (job->fd < 0) {
+    job->fd = g_file_open_tmp("mate-system-log-XXXXXX", &path, NULL);
+
+    if (job->fd < 0) {
+      goto out;
+    }
 
-  if (!log->priv->lines) {
-    log->priv->lines = g_ptr_array_new();
-    g_ptr_array_add(log->priv->lines, NULL);
+    /* the file goes away with the log, even after a crash */
+    g_unlink(path);
+    g_free(path);
   }
 
-  lines = log->priv->lines;
+  buffer = g_string_new(NULL);
 
-  /* remove the NULL-terminator */
-  g_ptr_array_remove_index(lines, lines->len - 1);
+  /* the lock is only held to copy the lines, the main thread can add
+   * new ones while they are written */
+  g_rw_lock_reader_lock(&priv->lines_lock);
 
-  while ((line = g_data_input_stream_read_line(
-              log->priv->stream, NULL, job->cancellable, &err)) != NULL) {
-    g_ptr_array_add(lines, (gpointer)line);
-  }
+  n_lines = logview_line_store_get_n_lines(priv->lines);
+  bytes = logview_line_store_get_bytes(priv->lines);
 
-  /* NULL-terminate the array again */
-  g_ptr_array_add(lines, NULL);
+  for (n_spill = 0;
+       n_spill < n_lines && log_over_tail(log, n_lines - n_spill, bytes, TRUE);
+       n_spill++) {
+    line = logview_line_store_get_line(priv->lines, n_spill, &len);
 
-  if (err) {
-    job->err = err;
-    goto out;
+    g_string_append_len(buffer, line, len);
+    g_string_append_c(buffer, '\n');
+    bytes -= len + 1;
   }
 
-  log->priv->has_new_lines = FALSE;
+  g_rw_lock_reader_unlock(&priv->lines_lock);
+
+  if (!write_all(job->fd, buffer->str, buffer->len) ||
+      (job->map = g_mapped_file_new_from_fd(job->fd, FALSE, NULL)) == NULL) {
+    /* drop what might have been written */
+    if (ftruncate(job->fd, job->end) == 0) {
+      lseek(job->fd, job->end, SEEK_SET);
+    }
 
-  /* we'll return only the new lines in the callback */
-  job->lines = (const char **)lines->pdata + log->priv->lines_no;
+    g_string_free(buffer, TRUE);
+    goto out;
+  }
 
-  /* save the new number of days and lines */
-  job->new_days = add_new_days_to_cache(log, job->lines, log->priv->lines_no);
-  log->priv->lines_no = (lines->len - 1);
+  job->n_lines = n_spill;
+  job->index = logview_line_index_new();
+  logview_line_index_scan(job->index, buffer->str, job->end, buffer->len,
+                          FALSE);
+  g_string_free(buffer, TRUE);
 
 out:
-  g_io_scheduler_job_send_to_mainloop_async(io_job, new_lines_job_done, job,
+  g_io_scheduler_job_send_to_mainloop_async(io_job, spill_job_done, job,
                                             NULL);
   return FALSE;
 }
 
-static gboolean log_load_done(gpointer user_data) {
-  LoadJob *job = user_data;
+/* moves the oldest lines of a stream out of memory when there are more
+ * than the tail limits allow; they are written by a job, the lines
+ * lock is only taken to drop them */
+static void log_spill_lines(LogviewLog *log) {
+  LogviewLogPrivate *priv = log->priv;
+  SpillJob *job;
 
-  if (job->err) {
-    /* the callback will have NULL as log, and the error set */
-    g_object_unref(job->log);
-    job->callback(NULL, job->err, job->user_data);
-    g_error_free(job->err);
-  } else {
-    job->callback(job->log, NULL, job->user_data);
-    setup_file_monitor(job->log);
+  if (priv->spilling || priv->lines == NULL ||
+      !log_over_tail(log, logview_line_store_get_n_lines(priv->lines),
+                     logview_line_store_get_bytes(priv->lines), FALSE)) {
+    return;
   }
 
-  g_slice_free(LoadJob, job);
+  job = g_slice_new0(SpillJob);
+  job->log = g_object_ref(log);
+  job->fd = priv->spill_fd;
 
-  return FALSE;
+  if (priv->spill_index != NULL) {
+    job->end = logview_line_index_get_end(priv->spill_index);
+  }
+
+  priv->spilling = TRUE;
+
+  g_io_scheduler_push_job(do_spill_lines, job, NULL, 0, NULL);
 }
 
-#ifdef HAVE_ZLIB
+/* runs in the main thread, which is the only one changing the lines */
+static gboolean spill_job_done(gpointer data) {
+  SpillJob *job = data;
+  LogviewLogPrivate *priv = job->log->priv;
 
-/* GZip functions adapted for GIO from mate-vfs/gzip-method.c */
+  priv->spilling = FALSE;
 
-#define Z_BUFSIZE 16384
+  if (job->fd < 0) {
+    /* keep everything in memory then */
+    priv->tail_lines = 0;
+    priv->tail_bytes = 0;
+  } else {
+    priv->spill_fd = job->fd;
+  }
 
-#define GZIP_HEADER_SIZE 10
-#define GZIP_MAGIC_1 0x1f
-#define GZIP_MAGIC_2 0x8b
-#define GZIP_FLAG_ASCII 0x01       /* bit 0 set: file probably ascii text */
-#define GZIP_FLAG_HEAD_CRC 0x02    /* bit 1 set: header CRC present */
-#define GZIP_FLAG_EXTRA_FIELD 0x04 /* bit 2 set: extra field present */
-#define GZIP_FLAG_ORIG_NAME 0x08   /* bit 3 set: original file name present */
-#define GZIP_FLAG_COMMENT 0x10     /* bit 4 set: file comment present */
-#define GZIP_FLAG_RESERVED 0xE0    /* bits 5..7: reserved */
+  if (job->map != NULL) {
+    g_rw_lock_writer_lock(&priv->lines_lock);
 
-static gboolean skip_string(GInputStream *is) {
-  guchar c;
-  gssize bytes_read;
+    if (priv->spill_index == NULL) {
+      priv->spill_index = logview_line_index_new();
+    }
 
-  do {
-    bytes_read = g_input_stream_read(is, &c, 1, NULL, NULL);
+    logview_line_index_append_index(priv->spill_index, job->index);
 
-    if (bytes_read != 1) {
-      return FALSE;
+    if (priv->spill_map != NULL) {
+      g_mapped_file_unref(priv->spill_map);
     }
-  } while (c != 0);
+    priv->spill_map = job->map;
 
-  return TRUE;
-}
+    logview_line_store_drop_first(priv->lines, job->n_lines);
+    priv->spilled_lines += job->n_lines;
 
-static gboolean read_gzip_header(GInputStream *is, time_t *modification_time) {
-  guchar buffer[GZIP_HEADER_SIZE];
-  gssize bytes, to_skip;
-  guint mode;
-  guint flags;
+    g_rw_lock_writer_unlock(&priv->lines_lock);
 
-  bytes = g_input_stream_read(is, buffer, GZIP_HEADER_SIZE, NULL, NULL);
-  if (bytes == -1) {
-    return FALSE;
+    /* lines might have been added meanwhile */
+    log_spill_lines(job->log);
   }
 
-  if (bytes != GZIP_HEADER_SIZE) return FALSE;
-
-  if (buffer[0] != GZIP_MAGIC_1 || buffer[1] != GZIP_MAGIC_2) return FALSE;
+  logview_line_index_free(job->index);
+  g_object_unref(job->log);
+  g_slice_free(SpillJob, job);
 
-  mode = buffer[2];
-  if (mode != 8) /* Mode: deflate */
-    return FALSE;
+  return FALSE;
+}
 
-  flags = buffer[3];
+/* drops the oldest lines of the tail of a file over the tail limits,
+ * they are read back from the file when they are needed */
+static void log_file_trim_tail(LogviewLog *log, LogFile *file) {
+  guint n_lines, n_drop;
+  gsize bytes, len;
 
-  if (flags & GZIP_FLAG_RESERVED) return FALSE;
+  n_lines = logview_line_store_get_n_lines(file->tail);
+  bytes = logview_line_store_get_bytes(file->tail);
 
-  if (flags & GZIP_FLAG_EXTRA_FIELD) {
-    guchar tmp[2];
+  if (!log_over_tail(log, n_lines, bytes, FALSE)) {
+    return;
+  }
 
-    bytes = g_input_stream_read(is, tmp, 2, NULL, NULL);
+  for (n_drop = 0;
+       n_drop < n_lines && log_over_tail(log, n_lines - n_drop, bytes, TRUE);
+       n_drop++) {
+    logview_line_store_get_line(file->tail, n_drop, &len);
+    bytes -= len + 1;
+  }
 
-    if (bytes != 2) {
-      return FALSE;
-    }
+  logview_line_store_drop_first(file->tail, n_drop);
+  file->tail_first += n_drop;
+}
 
-    to_skip = tmp[0] | (tmp[0] << 8);
-    bytes = g_input_stream_skip(is, to_skip, NULL, NULL);
-    if (bytes != to_skip) {
-      return FALSE;
-    }
+/* appends the lines a job indexed to a file, with the text it copied of
+ * the last ones; the tail starts over if they don't follow it */
+static void log_file_add_lines(LogviewLog *log, LogFile *file,
+                               LogviewLineIndex *index,
+                               LogviewLineStore *lines) {
+  guint n_lines, n_copied;
+
+  n_lines = logview_line_index_get_n_lines(index);
+  n_copied = logview_line_store_get_n_lines(lines);
+
+  if (n_copied < n_lines) {
+    logview_line_store_drop_first(file->tail,
+                                  logview_line_store_get_n_lines(file->tail));
+    file->tail_first =
+        logview_line_index_get_n_lines(file->index) + n_lines - n_copied;
   }
 
-  if (flags & GZIP_FLAG_ORIG_NAME) {
-    if (!skip_string(is)) {
-      return FALSE;
-    }
-  }
+  logview_line_index_append_index(file->index, index);
+  logview_line_store_move(file->tail, lines);
+  log_file_trim_tail(log, file);
+}
 
-  if (flags & GZIP_FLAG_COMMENT) {
-    if (!skip_string(is)) {
-      return FALSE;
-    }
+/* the file followed has been rotated or truncated: its lines are kept,
+ * and the new lines of the job come from the file in its place, with
+ * the lines lock held */
+static void log_switch_file(LogviewLog *log, NewLinesJob *job,
+                            guint n_lines) {
+  LogviewLogPrivate *priv = log->priv;
+  LogFile *file = priv->followed;
+  int fd;
+
+  if (job->new_fd >= 0) {
+    /* a rotated file is still there, under another name or unlinked,
+     * its lines are all read back from it */
+    fd = job->new_fd;
+    job->new_fd = -1;
+
+    logview_line_store_drop_first(file->tail,
+                                  logview_line_store_get_n_lines(file->tail));
+    file->tail_first = logview_line_index_get_n_lines(file->index);
+  } else {
+    /* the text of a truncated file is gone, but for its tail */
+    fd = file->fd;
+    file->fd = -1;
+    g_clear_pointer(&file->cache, logview_line_cache_free);
   }
 
-  if (flags & GZIP_FLAG_HEAD_CRC) {
-    bytes = g_input_stream_skip(is, 2, NULL, NULL);
-    if (bytes != 2) {
-      return FALSE;
-    }
-  }
+  g_ptr_array_add(priv->old_files, file);
 
-  *modification_time =
-      (buffer[4] | (buffer[5] << 8) | (buffer[6] << 16) | (buffer[7] << 24));
+  priv->followed = log_file_new(fd, logview_line_index_new());
+  priv->followed->first_line = priv->lines_no + n_lines;
 
-  return TRUE;
+  log_file_add_lines(log, priv->followed, job->new_index, job->new_lines);
 }
 
-static GZHandle *gz_handle_new(GFile *file, GInputStream *parent_stream) {
-  GZHandle *ret;
+/* a merged log is as recent as the latest of its sources */
+static void log_update_merged_stats(LogviewLog *log) {
+  LogviewLogPrivate *priv = log->priv;
+  LogviewLog *source;
+  guint i;
 
-  ret = g_new(GZHandle, 1);
-  ret->parent_str = g_object_ref(parent_stream);
-  ret->file = g_object_ref(file);
-  ret->buffer = NULL;
+  priv->file_time = 0;
+  priv->file_size = 0;
 
-  return ret;
+  for (i = 0; i < priv->sources->len; i++) {
+    source = g_ptr_array_index(priv->sources, i);
+
+    priv->file_time = MAX(priv->file_time, source->priv->file_time);
+    priv->file_size += source->priv->file_size;
+    priv->has_days |= source->priv->has_days;
+  }
 }
 
-static gboolean gz_handle_init(GZHandle *gz) {
-  gz->zstream.zalloc = NULL;
-  gz->zstream.zfree = NULL;
-  gz->zstream.opaque = NULL;
+/* runs in the main thread, which is the only one changing the lines */
+static guint commit_new_lines(NewLinesJob *job) {
+  LogviewLogPrivate *priv = job->log->priv;
+  guint n_lines, i;
 
-  g_free(gz->buffer);
-  gz->buffer = g_malloc(Z_BUFSIZE);
-  gz->zstream.next_in = gz->buffer;
-  gz->zstream.avail_in = 0;
+  if (job->merge != NULL) {
+    if (job->first_line != priv->lines_no) {
+      return 0;
+    }
 
-  if (inflateInit2(&gz->zstream, -MAX_WBITS) != Z_OK) {
-    return FALSE;
-  }
+    n_lines = logview_merge_get_n_lines(job->merge);
 
-  gz->last_z_result = Z_OK;
-  gz->last_str_result = TRUE;
+    g_rw_lock_writer_lock(&priv->lines_lock);
 
-  return TRUE;
-}
+    logview_merge_append_merge(priv->merge, job->merge);
 
-static void gz_handle_free(GZHandle *gz) {
-  g_object_unref(gz->parent_str);
-  g_object_unref(gz->file);
-  g_free(gz->buffer);
-  g_free(gz);
-}
+    /* the next merge starts after these lines */
+    for (i = 0; i < priv->sources->len; i++) {
+      priv->merge_sources[i].first_line = job->merge_sources[i].first_line;
+      priv->merge_sources[i].time = job->merge_sources[i].time;
+    }
+
+    log_update_merged_stats(job->log);
+  } else if (job->times != NULL) {
+    /* the entries are already in the journal, only their number
+     * changes */
+    n_lines = job->times->len;
+
+    g_rw_lock_writer_lock(&priv->lines_lock);
+  } else if (job->index != NULL) {
+    if (job->first_line != priv->lines_no ||
+        job->n_old_files != priv->old_files->len) {
+      /* another read got there first, these lines are already indexed */
+      return 0;
+    }
 
-static gboolean fill_buffer(GZHandle *gz, gsize num_bytes) {
-  gsize count;
+    n_lines = logview_line_index_get_n_lines(job->index);
 
-  z_stream *zstream = &gz->zstream;
+    g_rw_lock_writer_lock(&priv->lines_lock);
 
-  if (zstream->avail_in > 0) {
-    return TRUE;
-  }
+    log_file_add_lines(job->log, priv->followed, job->index, job->lines);
 
-  count =
-      g_input_stream_read(gz->parent_str, gz->buffer, Z_BUFSIZE, NULL, NULL);
-  if (count == -1) {
-    if (zstream->avail_out == num_bytes) {
-      return FALSE;
+    if (job->new_index != NULL) {
+      log_switch_file(job->log, job, n_lines);
+      n_lines += logview_line_index_get_n_lines(priv->followed->index);
     }
-    gz->last_str_result = FALSE;
   } else {
-    zstream->next_in = gz->buffer;
-    zstream->avail_in = count;
-  }
+    /* streams are read by one job at a time, the lines always follow
+     * the cached ones */
+    job->first_line = priv->lines_no;
+    n_lines = logview_line_store_get_n_lines(job->lines);
 
-  return TRUE;
-}
+    g_rw_lock_writer_lock(&priv->lines_lock);
 
-static gboolean result_from_z_result(int z_result) {
-  switch (z_result) {
-    case Z_OK:
-    case Z_STREAM_END:
-      return TRUE;
-    case Z_DATA_ERROR:
-      return FALSE;
-    default:
-      return FALSE;
-  }
-}
+    if (priv->lines == NULL) {
+      priv->lines = logview_line_store_new();
+    }
 
-static gboolean gz_handle_read(GZHandle *gz, guchar *buffer, gsize num_bytes,
-                               gsize *bytes_read) {
-  z_stream *zstream;
-  gboolean res;
-  int z_result;
+    /* the chunks of text now belong to the cache */
+    logview_line_store_move(priv->lines, job->lines);
+  }
 
-  *bytes_read = 0;
-  zstream = &gz->zstream;
+  if (job->invalid != NULL) {
+    for (i = 0; i < job->invalid->len; i++) {
+      LineRange *range = &g_array_index(job->invalid, LineRange, i);
 
-  if (gz->last_z_result != Z_OK) {
-    if (gz->last_z_result == Z_STREAM_END) {
-      *bytes_read = 0;
-      return TRUE;
-    } else {
-      return result_from_z_result(gz->last_z_result);
+      logview_utils_line_ranges_add(priv->invalid_lines,
+                                    job->first_line + range->first,
+                                    job->first_line + range->last);
     }
-  } else if (gz->last_str_result == FALSE) {
-    return FALSE;
   }
 
-  zstream->next_out = buffer;
-  zstream->avail_out = num_bytes;
+  priv->lines_no += n_lines;
 
-  while (zstream->avail_out != 0) {
-    res = fill_buffer(gz, num_bytes);
-
-    if (!res) {
-      return res;
-    }
+  g_rw_lock_writer_unlock(&priv->lines_lock);
 
-    z_result = inflate(zstream, Z_NO_FLUSH);
-    if (z_result == Z_STREAM_END) {
-      gz->last_z_result = z_result;
-      break;
-    } else if (z_result != Z_OK) {
-      gz->last_z_result = z_result;
-    }
+  /* the lines of streams are spilled to a file, those of plain logs
+   * have been dropped from the tail of their file already */
+  if (priv->followed == NULL && job->lines != NULL) {
+    log_spill_lines(job->log);
+  }
 
-    if (gz->last_z_result != Z_OK && zstream->avail_out == num_bytes) {
-      return result_from_z_result(gz->last_z_result);
-    }
+  if (priv->timestamp_format == LOGVIEW_TIMESTAMP_UNKNOWN) {
+    priv->timestamp_format = job->timestamp_format;
   }
 
-  *bytes_read = num_bytes - zstream->avail_out;
+  add_new_days_to_cache(job->log, job->new_days, job->first_line);
 
-  return TRUE;
+  return n_lines;
 }
 
-static GError *create_zlib_error(void) {
-  GError *err;
+/* the cache is written once the log has been read, then again each
+ * time it has grown by a quarter */
+static void log_save_index_cache(LogviewLog *log) {
+  LogviewLogPrivate *priv = log->priv;
 
-  err = g_error_new_literal(
-      LOGVIEW_ERROR_QUARK, LOGVIEW_ERROR_ZLIB,
-      _("Error while uncompressing the GZipped log. The file "
-        "might be corrupt."));
-  return err;
+  /* the cache only knows about a single file */
+  if (priv->followed == NULL || priv->old_files->len > 0 ||
+      priv->lines_no == priv->saved_lines ||
+      (priv->loaded &&
+       priv->lines_no - priv->saved_lines < priv->saved_lines / 4)) {
+    return;
+  }
+
+  logview_index_cache_save(priv->path, priv->followed->fd,
+                           priv->followed->index, priv->days,
+                           priv->invalid_lines, priv->timestamp_format);
+  priv->saved_lines = priv->lines_no;
 }
 
-#endif /* HAVE_ZLIB */
+/* a batch of a stream being read, the job goes on after it */
+static gboolean new_lines_batch_done(gpointer data) {
+  NewLinesJob *job = data;
+  guint n_lines;
 
-static gboolean log_load(GIOSchedulerJob *io_job, GCancellable *cancellable,
-                         gpointer user_data) {
-  /* this runs in a separate i/o thread */
-  LoadJob *job = user_data;
-  LogviewLog *log = job->log;
-  GFile *f = log->priv->file;
-  GFileInfo *info;
-  GInputStream *is;
-  const char *peeked_buffer;
-  const char *parse_data[2];
-  GSList *days;
-  const char *content_type;
-  GFileType type;
-  GError *err = NULL;
-  gboolean is_archive, can_read;
-
-  info = g_file_query_info(f,
-                           G_FILE_ATTRIBUTE_ACCESS_CAN_READ
-                           "," G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE
-                           "," G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME
-                           "," G_FILE_ATTRIBUTE_STANDARD_TYPE
-                           "," G_FILE_ATTRIBUTE_STANDARD_SIZE
-                           "," G_FILE_ATTRIBUTE_TIME_MODIFIED ",",
-                           0, NULL, &err);
-  if (err) {
-    if (err->code == G_IO_ERROR_PERMISSION_DENIED) {
-      /* TODO: PolicyKit integration */
-    }
-    goto out;
+  n_lines = commit_new_lines(job);
+
+  /* the lines are cached anyway, but the view might have moved on */
+  if (n_lines > 0 && !g_cancellable_is_cancelled(job->cancellable)) {
+    job->callback(job->log, job->first_line, n_lines, job->new_days, NULL,
+                  job->user_data);
   }
 
-  can_read =
-      g_file_info_get_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ);
-  if (!can_read) {
-    /* TODO: PolicyKit integration */
-    err = g_error_new_literal(
-        LOGVIEW_ERROR_QUARK, LOGVIEW_ERROR_PERMISSION_DENIED,
-        _("You don't have enough permissions to read the file."));
-    g_object_unref(info);
+  g_slist_free_full(job->new_days, (GDestroyNotify)logview_utils_day_free);
+  job->new_days = NULL;
+  g_clear_pointer(&job->invalid, g_array_unref);
 
-    goto out;
-  }
+  return FALSE;
+}
 
-  type = g_file_info_get_file_type(info);
-  content_type = g_file_info_get_content_type(info);
+static gboolean new_lines_job_done(gpointer data) {
+  NewLinesJob *job = data;
+  guint n_lines;
 
-  is_archive = g_content_type_equals(content_type, "application/x-gzip");
+  if (job->err) {
+    /* whatever is left will be read next time */
+    job->log->priv->has_new_lines = TRUE;
 
-  if (((type != G_FILE_TYPE_REGULAR) && (type != G_FILE_TYPE_SYMBOLIC_LINK)) ||
-      (!g_content_type_is_a(content_type, "text/plain") && !is_archive)) {
-    err = g_error_new_literal(
-        LOGVIEW_ERROR_QUARK, LOGVIEW_ERROR_NOT_A_LOG,
-        _("The file is not a regular file or is not a text file."));
-    g_object_unref(info);
+    job->callback(job->log, 0, 0, NULL, job->err, job->user_data);
+    g_error_free(job->err);
+  } else {
+    n_lines = commit_new_lines(job);
+    job->log->priv->has_new_lines = FALSE;
 
-    goto out;
+    log_save_index_cache(job->log);
+
+    job->callback(job->log, job->first_line, n_lines,
+                  n_lines > 0 ? job->new_days : NULL, NULL, job->user_data);
+    job->log->priv->loaded = TRUE;
   }
 
-  log->priv->file_size = g_file_info_get_size(info);
+  g_clear_object(&job->cancellable);
+  g_clear_pointer(&job->lines, logview_line_store_free);
+  g_clear_pointer(&job->index, logview_line_index_free);
+  g_clear_pointer(&job->new_lines, logview_line_store_free);
+  g_clear_pointer(&job->new_index, logview_line_index_free);
+  g_clear_pointer(&job->cache, logview_line_cache_free);
+  g_clear_pointer(&job->new_cache, logview_line_cache_free);
+  g_clear_pointer(&job->merge, logview_merge_free);
+  g_clear_pointer(&job->times, g_array_unref);
+  g_clear_pointer(&job->invalid, g_array_unref);
+
+  if (job->merge_sources != NULL) {
+    merge_sources_free(job->merge_sources, job->log->priv->sources->len);
+  }
 
-  GDateTime *file_dt;
-  gint64 t;
-  file_dt = g_file_info_get_modification_date_time(info);
-  t = g_date_time_to_unix(file_dt);
-  g_date_time_unref(file_dt);
-  log->priv->file_time = t;
+  if (job->fd >= 0) {
+    g_close(job->fd, NULL);
+  }
 
-  log->priv->display_name = g_strdup(g_file_info_get_display_name(info));
+  if (job->new_fd >= 0) {
+    g_close(job->new_fd, NULL);
+  }
 
-  g_object_unref(info);
+  g_slist_free_full(job->new_days, (GDestroyNotify)logview_utils_day_free);
 
-  /* initialize the stream */
-  is = G_INPUT_STREAM(g_file_read(f, NULL, &err));
+  if (job->done != NULL) {
+    job->done(job->user_data);
+  }
 
-  if (err) {
-    if (err->code == G_IO_ERROR_PERMISSION_DENIED) {
-      /* TODO: PolicyKit integration */
+  /* drop the reference we acquired before */
+  g_object_unref(job->log);
+
+  g_slice_free(NewLinesJob, job);
+
+  return FALSE;
+}
+
+static GError *create_decompress_error(LogviewCompression compression) {
+  GError *err;
+
+  err = g_error_new(LOGVIEW_ERROR_QUARK, LOGVIEW_ERROR_DECOMPRESS,
+                    _("Error while uncompressing the %s compressed log. "
+                      "The file might be corrupt."),
+                    logview_compression_get_name(compression));
+  return err;
+}
+
+/* streams are handed to the main thread in batches of lines */
+#define FIRST_BATCH_LINES 1000
+#define BATCH_LINES 65536
+#define STREAM_BUFFER_SIZE (64 * 1024)
+
+/* plain files are read a block at a time, the block grows for a line
+ * that doesn't fit */
+#define FILE_BUFFER_SIZE (1024 * 1024)
+
+/* the text of a line of a file, copied or read back */
+static const char *job_get_file_line(LogviewLineCache *cache,
+                                     LogviewLineIndex *index,
+                                     LogviewLineStore *lines, guint line,
+                                     gsize *len) {
+  guint first_copied;
+
+  first_copied = logview_line_index_get_n_lines(index) -
+                 logview_line_store_get_n_lines(lines);
+
+  if (line >= first_copied) {
+    return logview_line_store_get_line(lines, line - first_copied, len);
+  }
+
+  return logview_line_cache_get_line(cache, index, line, len);
+}
+
+static const char *job_get_line(gpointer user_data, int line, gsize *len) {
+  NewLinesJob *job = user_data;
+  const char *text;
+  guint n_lines;
+
+  if (job->times != NULL) {
+    *len = logview_journal_format_time(g_array_index(job->times, gint64, line),
+                                       job->time_text, sizeof(job->time_text));
+    return job->time_text;
+  }
+
+  if (job->index == NULL) {
+    return logview_line_store_get_line(job->lines, (guint)line, len);
+  }
+
+  n_lines = logview_line_index_get_n_lines(job->index);
+
+  if ((guint)line < n_lines) {
+    text = job_get_file_line(job->cache, job->index, job->lines, (guint)line,
+                             len);
+  } else {
+    text = job_get_file_line(job->new_cache, job->new_index, job->new_lines,
+                             (guint)line - n_lines, len);
+  }
+
+  /* truncated meanwhile */
+  if (text == NULL) {
+    *len = 0;
+    text = "";
+  }
+
+  return text;
+}
+
+/* the ranges are created for the first line that isn't valid UTF-8 */
+static void add_invalid_line(GArray **ranges, guint line) {
+  if (*ranges == NULL) {
+    *ranges = g_array_new(FALSE, FALSE, sizeof(LineRange));
+  }
+
+  logview_utils_line_ranges_add(*ranges, line, line);
+}
+
+static void set_error_from_errno(GError **err) {
+  int errsv = errno;
+
+  g_set_error_literal(err, G_IO_ERROR, g_io_error_from_errno(errsv),
+                      g_strerror(errsv));
+}
+
+/**
+ * read_file_lines:
+ *
+ * @fd: the file.
+ * @offset: where to start reading.
+ * @size: where to stop reading.
+ * @index: an empty index, for the lines read.
+ * @copy_from: the offset of the first line to copy.
+ * @lines: the store to copy the lines to.
+ * @invalid: return location for the lines that aren't valid UTF-8.
+ * @first_line: the number the first line gets in @invalid.
+ * @err: return location for a #GError.
+ *
+ * Indexes the lines of the file from @offset up to @size; only the text
+ * of the lines from @copy_from on is copied to @lines, the others are
+ * read again when they are needed. The file is read with pread()
+ * instead of being mapped, a file truncated meanwhile only ends the
+ * read early.
+ */
+static void read_file_lines(int fd, guint64 offset, guint64 size,
+                            LogviewLineIndex *index, guint64 copy_from,
+                            LogviewLineStore *lines, GArray **invalid,
+                            guint first_line, GError **err) {
+  guint64 data_offset, start;
+  gsize buffer_size, kept, avail, consumed, len;
+  gboolean at_eof, valid;
+  gssize n_read;
+  char *buffer;
+  guint line;
+
+  buffer_size = FILE_BUFFER_SIZE;
+  buffer = g_malloc(buffer_size);
+  data_offset = offset;
+  kept = 0;
+  line = 0;
+
+  for (;;) {
+    n_read = 0;
+
+    if (offset < size) {
+      if (kept == buffer_size) {
+        buffer_size *= 2;
+        buffer = g_realloc(buffer, buffer_size);
+      }
+
+      n_read = pread(fd, buffer + kept, MIN(buffer_size - kept, size - offset),
+                     (off_t)offset);
+
+      if (n_read < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+
+        set_error_from_errno(err);
+        break;
+      }
+
+      offset += n_read;
+    }
+
+    at_eof = (n_read == 0 || offset == size);
+    avail = kept + n_read;
+
+    logview_line_index_scan(index, buffer, data_offset, avail, at_eof);
+
+    /* the start of a line cut by the end of the buffer is kept */
+    consumed = (gsize)(logview_line_index_get_end(index) - data_offset);
+
+    /* the lines found are validated at once, and one by one only when
+     * some of them aren't valid UTF-8 */
+    valid = g_utf8_validate(buffer, (gssize)consumed, NULL);
+
+    for (; logview_line_index_get_line(index, line, &start, &len); line++) {
+      if (!valid && !g_utf8_validate(buffer + (start - data_offset),
+                                     (gssize)len, NULL)) {
+        add_invalid_line(invalid, first_line + line);
+      }
+
+      if (start >= copy_from) {
+        logview_line_store_append(lines, buffer + (start - data_offset), len);
+      }
+    }
+
+    kept = avail - consumed;
+    memmove(buffer, buffer + consumed, kept);
+    data_offset += consumed;
+
+    if (at_eof) {
+      break;
+    }
+  }
+
+  g_free(buffer);
+}
+
+/* where to start copying the lines read up to size */
+static guint64 job_get_copy_from(NewLinesJob *job, guint64 size) {
+  return (size > job->tail_bytes) ? size - job->tail_bytes : 0;
+}
+
+/* reads the whole file, for the one in place of a rotated log */
+static void read_new_file(NewLinesJob *job, int fd, goffset size) {
+  job->new_index = logview_line_index_new();
+  job->new_lines = logview_line_store_new();
+  job->new_cache = logview_line_cache_new(fd);
+
+  read_file_lines(fd, 0, (guint64)size, job->new_index,
+                  job_get_copy_from(job, size), job->new_lines, &job->invalid,
+                  logview_line_index_get_n_lines(job->index), &job->err);
+}
+
+static void read_new_lines_from_file(NewLinesJob *job) {
+  LogviewLog *log = job->log;
+  struct stat fd_st, path_st;
+
+  if (fstat(job->fd, &fd_st) != 0) {
+    set_error_from_errno(&job->err);
+    return;
+  }
+
+  job->index = logview_line_index_new();
+  job->lines = logview_line_store_new();
+  job->cache = logview_line_cache_new(job->fd);
+
+  if ((guint64)fd_st.st_size < job->start_offset) {
+    /* truncated in place, e.g. by copytruncate: what's there now is a
+     * new log, written after the lines already read */
+    read_new_file(job, job->fd, fd_st.st_size);
+    return;
+  }
+
+  /* first what was appended to the file followed, which is still there
+   * even if it has been renamed or deleted */
+  if ((guint64)fd_st.st_size > job->start_offset) {
+    read_file_lines(job->fd, job->start_offset, fd_st.st_size, job->index,
+                    job_get_copy_from(job, fd_st.st_size), job->lines,
+                    &job->invalid, 0, &job->err);
+
+    if (job->err != NULL) {
+      return;
     }
+  }
+
+  /* then the file that took its place */
+  if (g_stat(log->priv->path, &path_st) != 0 ||
+      (path_st.st_dev == fd_st.st_dev && path_st.st_ino == fd_st.st_ino)) {
+    return;
+  }
+
+  job->new_fd = g_open(log->priv->path, O_RDONLY, 0);
+  if (job->new_fd < 0 || fstat(job->new_fd, &path_st) != 0) {
+    /* it might not be there yet, try again on the next change */
+    return;
+  }
+
+  read_new_file(job, job->new_fd, path_st.st_size);
+}
+
+/* checks the line just added to the lines of a stream */
+static void job_check_last_line(NewLinesJob *job, const char *text,
+                                gsize len) {
+  if (!g_utf8_validate(text, (gssize)len, NULL)) {
+    add_invalid_line(&job->invalid,
+                     logview_line_store_get_n_lines(job->lines) - 1);
+  }
+}
+
+static void read_new_lines_from_stream(GIOSchedulerJob *io_job,
+                                       NewLinesJob *job) {
+  LogviewLog *log = job->log;
+  guint batch_lines = FIRST_BATCH_LINES;
+  GString *partial;
+  const char *p, *end, *newline;
+  gboolean valid;
+  char *buffer;
+  gssize n_read;
+  guint n_lines;
+
+  g_assert(log->priv->stream != NULL);
+
+  job->lines = logview_line_store_new();
+  buffer = g_malloc(STREAM_BUFFER_SIZE);
+  partial = g_string_new(NULL);
+
+  g_mutex_lock(&log->priv->stream_lock);
+
+  /* the lines are split here and copied to the store, rather than
+   * allocated one by one */
+  while ((n_read = g_input_stream_read(G_INPUT_STREAM(log->priv->stream),
+                                       buffer, STREAM_BUFFER_SIZE,
+                                       job->cancellable, &job->err)) >= 0) {
+    p = buffer;
+    end = buffer + n_read;
+
+    /* the buffer is validated at once, its lines are checked one by one
+     * only when it isn't valid UTF-8; those that started in the previous
+     * buffer always are */
+    valid = g_utf8_validate(buffer, n_read, NULL);
+
+    while ((newline = memchr(p, '\n', end - p)) != NULL || n_read == 0) {
+      if (newline == NULL) {
+        /* the last line of the stream, without a newline */
+        if (partial->len > 0) {
+          logview_line_store_append(job->lines, partial->str, partial->len);
+          job_check_last_line(job, partial->str, partial->len);
+          g_string_truncate(partial, 0);
+        }
+      } else if (partial->len > 0) {
+        g_string_append_len(partial, p, newline - p);
+        logview_line_store_append(job->lines, partial->str, partial->len);
+        job_check_last_line(job, partial->str, partial->len);
+        g_string_truncate(partial, 0);
+        p = newline + 1;
+      } else {
+        logview_line_store_append(job->lines, p, newline - p);
+
+        if (!valid) {
+          job_check_last_line(job, p, newline - p);
+        }
+
+        p = newline + 1;
+      }
+
+      n_lines = logview_line_store_get_n_lines(job->lines);
+
+      if (n_lines == batch_lines) {
+        /* hand over what we have, so that the first lines of a long
+         * (e.g. compressed) log show up right away */
+        job->new_days = log_read_dates(job_get_line, job, n_lines,
+                                       log->priv->file_time,
+                                       &job->timestamp_format);
+        g_io_scheduler_job_send_to_mainloop(io_job, new_lines_batch_done, job,
+                                            NULL);
+        batch_lines = BATCH_LINES;
+      }
+
+      if (newline == NULL) {
+        break;
+      }
+    }
+
+    if (n_read == 0) {
+      break;
+    }
+
+    g_string_append_len(partial, p, end - p);
+  }
+
+  g_mutex_unlock(&log->priv->stream_lock);
+
+  g_string_free(partial, TRUE);
+  g_free(buffer);
+
+  if (job->err != NULL &&
+      log->priv->compression != LOGVIEW_COMPRESSION_NONE &&
+      !g_error_matches(job->err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+    g_clear_error(&job->err);
+    job->err = create_decompress_error(log->priv->compression);
+  }
+}
+
+static const char *source_get_line(gpointer user_data, int line, gsize *len) {
+  return logview_log_get_line(user_data, (guint)line, len);
+}
+
+/* merges the new lines of the sources of a merged log, which stay
+ * locked meanwhile */
+static void read_new_lines_from_sources(NewLinesJob *job) {
+  GPtrArray *sources = job->log->priv->sources;
+  guint i;
+
+  for (i = 0; i < sources->len; i++) {
+    logview_log_lock_lines(g_ptr_array_index(sources, i));
+  }
+
+  job->merge = logview_merge_new();
+  job->new_days =
+      logview_merge_run(job->merge, job->merge_sources, sources->len);
+
+  for (i = 0; i < sources->len; i++) {
+    logview_log_unlock_lines(g_ptr_array_index(sources, i));
+  }
+}
+
+static void read_new_lines_from_journal(NewLinesJob *job) {
+  job->times = g_array_new(FALSE, FALSE, sizeof(gint64));
+
+  logview_journal_read_entries(job->log->priv->journal, &job->first_line,
+                               job->times, &job->err);
+}
+
+static gboolean do_read_new_lines(GIOSchedulerJob *io_job,
+                                  GCancellable *cancellable,
+                                  gpointer user_data) {
+  /* this runs in a separate thread */
+  NewLinesJob *job = user_data;
+  LogviewLog *log = job->log;
+  guint n_lines;
 
+  g_assert(LOGVIEW_IS_LOG(log));
+
+  /* the new lines are only read here, the log is updated once back in
+   * the main thread */
+  if (log->priv->sources != NULL) {
+    read_new_lines_from_sources(job);
     goto out;
   }
 
-  if (is_archive) {
-#ifdef HAVE_ZLIB
-    GZHandle *gz;
-    gboolean res;
-    guchar *buffer;
-    gsize bytes_read;
-    GInputStream *real_is;
-    time_t mtime; /* seconds */
+  if (log->priv->journal != NULL) {
+    read_new_lines_from_journal(job);
+  } else if (log->priv->path != NULL) {
+    read_new_lines_from_file(job);
+  } else {
+    read_new_lines_from_stream(io_job, job);
+  }
 
-    /* this also skips the header from |is| */
-    res = read_gzip_header(is, &mtime);
+  if (job->err) {
+    goto out;
+  }
 
-    if (!res) {
-      g_object_unref(is);
+  if (job->times != NULL) {
+    n_lines = job->times->len;
+  } else if (job->index != NULL) {
+    n_lines = logview_line_index_get_n_lines(job->index);
 
-      err = create_zlib_error();
-      goto out;
+    if (job->new_index != NULL) {
+      n_lines += logview_line_index_get_n_lines(job->new_index);
     }
+  } else {
+    n_lines = logview_line_store_get_n_lines(job->lines);
+  }
 
-    log->priv->file_time = mtime;
+  /* the lines that aren't valid UTF-8 have been found as they were
+   * read, the entries of a journal are always formatted to UTF-8 */
+  job->new_days = log_read_dates(job_get_line, job, n_lines,
+                                 log->priv->file_time, &job->timestamp_format);
 
-    gz = gz_handle_new(f, is);
-    res = gz_handle_init(gz);
+out:
+  g_io_scheduler_job_send_to_mainloop_async(io_job, new_lines_job_done, job,
+                                            NULL);
+  return FALSE;
+}
 
-    if (!res) {
-      g_object_unref(is);
-      gz_handle_free(gz);
+static void log_read_new_lines(LogviewLog *log, GCancellable *cancellable,
+                               LogviewNewLinesCallback callback,
+                               GDestroyNotify done, gpointer user_data);
 
-      err = create_zlib_error();
-      goto out;
+static void log_set_stats(LogviewLog *log, GFileInfo *info) {
+  LogviewLogPrivate *priv = log->priv;
+  GDateTime *file_dt;
+
+  g_free(priv->display_name);
+  priv->display_name = g_strdup(g_file_info_get_display_name(info));
+  priv->file_size = g_file_info_get_size(info);
+
+  file_dt = g_file_info_get_modification_date_time(info);
+  priv->file_time = g_date_time_to_unix(file_dt);
+  g_date_time_unref(file_dt);
+}
+
+/* the log has been opened for its first read, the reads that waited
+ * for it go on */
+static void log_open_done(LoadJob *job) {
+  LogviewLog *log = job->log;
+  PendingRead *read;
+  GSList *reads, *l;
+
+  log->priv->opened = TRUE;
+  log->priv->open_job = NULL;
+  log->priv->open_error = job->err;
+
+  reads = g_slist_reverse(log->priv->pending_reads);
+  log->priv->pending_reads = NULL;
+
+  if (job->err == NULL) {
+    setup_file_monitor(log);
+  }
+
+  for (l = reads; l != NULL; l = l->next) {
+    read = l->data;
+
+    if (g_cancellable_is_cancelled(read->cancellable)) {
+      /* replaced by a later read */
+      if (read->done != NULL) {
+        read->done(read->user_data);
+      }
+    } else {
+      log_read_new_lines(log, read->cancellable, read->callback, read->done,
+                         read->user_data);
     }
 
-    real_is = g_memory_input_stream_new();
+    g_clear_object(&read->cancellable);
+    g_slice_free(PendingRead, read);
+  }
 
-    do {
-      buffer = g_malloc(1024);
-      res = gz_handle_read(gz, buffer, 1024, &bytes_read);
-      g_memory_input_stream_add_data(G_MEMORY_INPUT_STREAM(real_is), buffer,
-                                     bytes_read, g_free);
-    } while (res == TRUE && bytes_read > 0);
+  g_slist_free(reads);
+  g_object_unref(log);
+  g_slice_free(LoadJob, job);
+}
 
-    if (!res) {
-      gz_handle_free(gz);
-      g_object_unref(real_is);
-      g_object_unref(is);
+static gboolean log_load_done(gpointer user_data) {
+  LoadJob *job = user_data;
 
-      err = create_zlib_error();
-      goto out;
+  if (job->info != NULL) {
+    if (job->err == NULL) {
+      log_set_stats(job->log, job->info);
+    }
+
+    g_clear_object(&job->info);
+  }
+
+  if (job->callback == NULL) {
+    log_open_done(job);
+    return FALSE;
+  }
+
+  if (job->err) {
+    /* the callback will have NULL as log, and the error set */
+    g_object_unref(job->log);
+    job->callback(NULL, job->err, job->user_data);
+    g_error_free(job->err);
+  } else {
+    job->log->priv->opened = job->open;
+    job->callback(job->log, NULL, job->user_data);
+
+    if (job->open) {
+      setup_file_monitor(job->log);
     }
+  }
+
+  g_slice_free(LoadJob, job);
+
+  return FALSE;
+}
+
+
+/* the beginning of a log, seen as a single line */
+typedef struct {
+  const char *data;
+  gsize len;
+} SniffData;
+
+#define SNIFF_LENGTH 4096
 
-    g_object_unref(is);
-    is = real_is;
+static const char *sniff_get_line(gpointer user_data, int line, gsize *len) {
+  SniffData *sniff = user_data;
 
-    gz_handle_free(gz);
-#else  /* HAVE_ZLIB */
-    g_object_unref(is);
+  *len = sniff->len;
+  return sniff->data;
+}
+
+static void log_sniff_days(LogviewLog *log, SniffData *sniff) {
+  GSList *days;
+
+  log->priv->timestamp_format = LOGVIEW_TIMESTAMP_UNKNOWN;
 
+  if ((days = log_read_dates(sniff_get_line, sniff, 1, time(NULL),
+                             &log->priv->timestamp_format)) != NULL) {
+    log->priv->has_days = TRUE;
+    g_slist_free_full(days, (GDestroyNotify)logview_utils_day_free);
+  } else {
+    log->priv->has_days = FALSE;
+  }
+}
+
+/* picks up the lines, the days and the invalid lines of the last time
+ * the log was opened; the file isn't read here, the next read only
+ * goes through what was appended since and the text of the cached
+ * lines is read back when it's needed */
+static void log_load_index_cache(LogviewLog *log) {
+  LogviewLogPrivate *priv = log->priv;
+  LogviewLineIndex *index;
+  LogviewTimestampFormat format;
+  GArray *invalid;
+  GSList *days;
+
+  if (!logview_index_cache_load(priv->path, priv->followed->fd, &index,
+                                &days, &invalid, &format)) {
+    return;
+  }
+
+  g_array_unref(priv->invalid_lines);
+  priv->invalid_lines = invalid;
+
+  logview_line_index_free(priv->followed->index);
+  priv->followed->index = index;
+  priv->followed->tail_first = logview_line_index_get_n_lines(index);
+  priv->days = days;
+  priv->timestamp_format = format;
+  priv->lines_no = logview_line_index_get_n_lines(index);
+  priv->saved_lines = priv->lines_no;
+  priv->has_days |= (priv->days != NULL);
+  priv->has_new_lines = TRUE;
+}
+
+static GError *create_not_a_log_error(void) {
+  return g_error_new_literal(
+      LOGVIEW_ERROR_QUARK, LOGVIEW_ERROR_NOT_A_LOG,
+      _("The file is not a regular file or is not a text file."));
+}
+
+static void log_load_journal(LogviewLog *log, GFileInfo *info,
+                             const char *path, GError **error) {
+  LogviewLogPrivate *priv = log->priv;
+
+  priv->journal = logview_journal_open(
+      path, g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY, error);
+
+  if (priv->journal == NULL) {
+    return;
+  }
+
+  /* the size of a journal is that of all its files */
+  g_file_info_set_size(info, (goffset)logview_journal_get_usage(priv->journal));
+
+  /* every entry is dated, see logview_journal_format_time() */
+  priv->timestamp_format = LOGVIEW_TIMESTAMP_ISO8601;
+  priv->has_days = TRUE;
+}
+
+/* the content type is sniffed from the file, it waits for the log to
+ * be opened */
+#define STAT_ATTRIBUTES                                      \
+  G_FILE_ATTRIBUTE_ACCESS_CAN_READ                           \
+  "," G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME                 \
+  "," G_FILE_ATTRIBUTE_STANDARD_TYPE                         \
+  "," G_FILE_ATTRIBUTE_STANDARD_SIZE                         \
+  "," G_FILE_ATTRIBUTE_TIME_MODIFIED
+#define OPEN_ATTRIBUTES \
+  STAT_ATTRIBUTES "," G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE
+
+static void log_load(gpointer data, gpointer user_data) {
+  /* this runs in one of the threads of the load pool */
+  LoadJob *job = data;
+  LogviewLog *log = job->log;
+  GFile *f = log->priv->file;
+  GFileInfo *info;
+  GInputStream *is, *real_is;
+  GMappedFile *map = NULL;
+  SniffData sniff;
+  const char *content_type;
+  GFileType type;
+  GError *err = NULL;
+  gboolean is_text, can_read, is_journal;
+  gssize n_head = -1;
+  char *path, *head;
+  int fd;
+
+  info = g_file_query_info(f, job->open ? OPEN_ATTRIBUTES : STAT_ATTRIBUTES,
+                           0, NULL, &err);
+  if (err) {
+    if (err->code == G_IO_ERROR_PERMISSION_DENIED) {
+      /* TODO: PolicyKit integration */
+    }
+    goto out;
+  }
+
+  can_read =
+      g_file_info_get_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ);
+  if (!can_read) {
+    /* TODO: PolicyKit integration */
     err = g_error_new_literal(
-        LOGVIEW_ERROR_QUARK, LOGVIEW_ERROR_NOT_SUPPORTED,
-        _("This version of System Log does not support GZipped logs."));
+        LOGVIEW_ERROR_QUARK, LOGVIEW_ERROR_PERMISSION_DENIED,
+        _("You don't have enough permissions to read the file."));
+    g_object_unref(info);
+
+    goto out;
+  }
+
+  type = g_file_info_get_file_type(info);
+  is_journal = FALSE;
+
+  if (g_file_is_native(f)) {
+    path = g_file_get_path(f);
+    is_journal =
+        logview_journal_is_journal(path, type == G_FILE_TYPE_DIRECTORY);
+
+    if (is_journal && job->open) {
+      log_load_journal(log, info, path, &err);
+    }
+
+    g_free(path);
+  }
+
+  if (!is_journal && (type != G_FILE_TYPE_REGULAR) &&
+      (type != G_FILE_TYPE_SYMBOLIC_LINK)) {
+    err = create_not_a_log_error();
+    g_object_unref(info);
+
+    goto out;
+  }
+
+  job->info = info;
+
+  if (!job->open || is_journal) {
+    /* the rest of a log waits for its first read */
     goto out;
-#endif /* HAVE_ZLIB */
   }
 
+  content_type = g_file_info_get_content_type(info);
+
+  /* compressed logs are told apart by their magic bytes, the content
+   * type is only checked for the others */
+  is_text = g_content_type_is_a(content_type, "text/plain");
+
+  is = NULL;
+
+  if (g_file_is_native(f)) {
+    /* plain local logs are read from their descriptor, falling back to
+     * the stream when the file can't be read that way */
+    log->priv->path = g_file_get_path(f);
+    fd = g_open(log->priv->path, O_RDONLY, 0);
+    head = g_malloc(SNIFF_LENGTH);
+
+    if (fd >= 0) {
+      n_head = pread(fd, head, SNIFF_LENGTH, 0);
+    }
+
+    if (n_head >= 0) {
+      sniff.data = head;
+      sniff.len = (gsize)n_head;
+      log->priv->compression =
+          logview_compression_detect(sniff.data, sniff.len);
+
+      if (log->priv->compression == LOGVIEW_COMPRESSION_NONE) {
+        log->priv->followed = log_file_new(fd, logview_line_index_new());
+
+        if (is_text) {
+          /* sniff into the file for a timestamped line */
+          log_sniff_days(log, &sniff);
+          log_load_index_cache(log);
+        } else {
+          err = create_not_a_log_error();
+        }
+
+        /* the descriptor stays open to follow the file across a
+         * rotation */
+        g_free(head);
+        goto out;
+      }
+
+      /* the frames of a zstd log can be decoded in parallel; compressed
+       * logs aren't written to anymore, they can be mapped */
+      if (log->priv->compression == LOGVIEW_COMPRESSION_ZSTD) {
+        map = g_mapped_file_new_from_fd(fd, FALSE, NULL);
+
+        if (map != NULL) {
+          is = logview_decompressor_open_frames(map);
+        }
+      }
+    }
+
+    g_free(head);
+
+    g_clear_pointer(&log->priv->path, g_free);
+
+    if (fd >= 0) {
+      g_close(fd, NULL);
+    }
+  }
+
+  if (is == NULL) {
+    /* initialize the stream */
+    is = G_INPUT_STREAM(g_file_read(f, NULL, &err));
+
+    if (err) {
+      if (err->code == G_IO_ERROR_PERMISSION_DENIED) {
+        /* TODO: PolicyKit integration */
+      }
+
+      goto out;
+    }
+
+    if (n_head < 0) {
+      /* look for the magic bytes of a compressed log */
+      real_is = g_buffered_input_stream_new(is);
+      g_object_unref(is);
+      is = real_is;
+
+      if (g_buffered_input_stream_fill(G_BUFFERED_INPUT_STREAM(is),
+                                       LOGVIEW_MAGIC_LENGTH, NULL,
+                                       NULL) > 0) {
+        sniff.data = g_buffered_input_stream_peek_buffer(
+            G_BUFFERED_INPUT_STREAM(is), &sniff.len);
+        log->priv->compression =
+            logview_compression_detect(sniff.data, sniff.len);
+      }
+
+      if (log->priv->compression == LOGVIEW_COMPRESSION_NONE && !is_text) {
+        g_object_unref(is);
+
+        err = create_not_a_log_error();
+        goto out;
+      }
+    }
+
+    if (log->priv->compression != LOGVIEW_COMPRESSION_NONE) {
+      /* uncompress while reading, the log is never uncompressed as a
+       * whole */
+      log->priv->converter =
+          logview_decompressor_new(log->priv->compression);
+
+      if (log->priv->converter == NULL) {
+        g_object_unref(is);
+
+        err = g_error_new(
+            LOGVIEW_ERROR_QUARK, LOGVIEW_ERROR_NOT_SUPPORTED,
+            _("This version of System Log does not support %s compressed "
+              "logs."),
+            logview_compression_get_name(log->priv->compression));
+        goto out;
+      }
+
+      real_is = g_converter_input_stream_new(is, log->priv->converter);
+      g_object_unref(is);
+      is = real_is;
+    }
+  }
+
+  g_clear_pointer(&map, g_mapped_file_unref);
+
   log->priv->stream = g_data_input_stream_new(is);
+  g_buffered_input_stream_set_buffer_size(
+      G_BUFFERED_INPUT_STREAM(log->priv->stream), STREAM_BUFFER_SIZE);
 
   /* sniff into the stream for a timestamped line */
   g_buffered_input_stream_fill(G_BUFFERED_INPUT_STREAM(log->priv->stream),
@@ -693,34 +1781,47 @@ static gboolean log_load(GIOSchedulerJob *io_job, GCancellable *cancellable,
                                    G_BUFFERED_INPUT_STREAM(log->priv->stream)),
                                NULL, &err);
   if (err == NULL) {
-    peeked_buffer = g_buffered_input_stream_peek_buffer(
-        G_BUFFERED_INPUT_STREAM(log->priv->stream), NULL);
-    parse_data[0] = peeked_buffer;
-    parse_data[1] = NULL;
-
-    if ((days = log_read_dates(parse_data, time(NULL))) != NULL) {
-      log->priv->has_days = TRUE;
-      g_slist_free_full(days, (GDestroyNotify)logview_utils_day_free);
-    } else {
-      log->priv->has_days = FALSE;
-    }
+    sniff.data = g_buffered_input_stream_peek_buffer(
+        G_BUFFERED_INPUT_STREAM(log->priv->stream), &sniff.len);
+    sniff.len = MIN(sniff.len, SNIFF_LENGTH);
+    log_sniff_days(log, &sniff);
   } else {
     log->priv->has_days = FALSE;
     g_clear_error(&err);
   }
 
+#ifdef HAVE_ZLIB
+  if (log->priv->compression == LOGVIEW_COMPRESSION_GZIP) {
+    /* the gzip header has been read by now, use its time stamp */
+    info = g_zlib_decompressor_get_file_info(
+        G_ZLIB_DECOMPRESSOR(log->priv->converter));
+
+    if (info != NULL &&
+        g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_TIME_MODIFIED)) {
+      g_file_info_set_attribute_uint64(
+          job->info, G_FILE_ATTRIBUTE_TIME_MODIFIED,
+          g_file_info_get_attribute_uint64(info,
+                                           G_FILE_ATTRIBUTE_TIME_MODIFIED));
+      g_file_info_remove_attribute(job->info,
+                                   G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+    }
+  }
+#endif /* HAVE_ZLIB */
+
   g_object_unref(is);
 
 out:
+  g_clear_pointer(&map, g_mapped_file_unref);
+
   if (err) {
     job->err = err;
   }
 
-  g_io_scheduler_job_send_to_mainloop_async(io_job, log_load_done, job, NULL);
-  return FALSE;
+  g_idle_add(log_load_done, job);
 }
 
-static void log_setup_load(LogviewLog *log, LogviewCreateCallback callback,
+static void log_setup_load(LogviewLog *log, gboolean open,
+                           LogviewCreateCallback callback,
                            gpointer user_data) {
   LoadJob *job;
 
@@ -729,39 +1830,185 @@ static void log_setup_load(LogviewLog *log, LogviewCreateCallback callback,
   job->user_data = user_data;
   job->log = log;
   job->err = NULL;
+  job->open = open;
+
+  if (load_pool == NULL) {
+    load_pool = g_thread_pool_new(log_load, NULL, LOAD_THREADS, FALSE, NULL);
+  }
 
   /* push the loading job into another thread */
-  g_io_scheduler_push_job(log_load, job, NULL, 0, NULL);
+  g_thread_pool_push(load_pool, job, NULL);
+
+  if (callback == NULL) {
+    log->priv->open_job = job;
+  }
 }
 
-/* public methods */
+static void log_read_sources(NewLinesJob *job);
 
-void logview_log_read_new_lines(LogviewLog *log, GCancellable *cancellable,
-                                LogviewNewLinesCallback callback,
-                                gpointer user_data) {
+/* done is called once the read is over, callback might be called
+ * before that for each batch of lines of a stream */
+static void log_read_new_lines(LogviewLog *log, GCancellable *cancellable,
+                               LogviewNewLinesCallback callback,
+                               GDestroyNotify done, gpointer user_data) {
   NewLinesJob *job;
+  PendingRead *read;
+
+  if (!log->priv->opened) {
+    read = g_slice_new0(PendingRead);
+    read->cancellable =
+        (cancellable != NULL) ? g_object_ref(cancellable) : NULL;
+    read->callback = callback;
+    read->done = done;
+    read->user_data = user_data;
+
+    log->priv->pending_reads = g_slist_prepend(log->priv->pending_reads, read);
+
+    if (log->priv->open_job == NULL) {
+      log_setup_load(g_object_ref(log), TRUE, NULL, NULL);
+    }
+
+    /* the log being read is the one shown, it goes before the others
+     * still waiting to be loaded */
+    g_thread_pool_move_to_front(load_pool, log->priv->open_job);
+    return;
+  }
+
+  if (log->priv->open_error != NULL) {
+    callback(log, 0, 0, NULL, log->priv->open_error, user_data);
+
+    if (done != NULL) {
+      done(user_data);
+    }
+
+    return;
+  }
 
   /* initialize the job struct with sensible values */
   job = g_slice_new0(NewLinesJob);
   job->callback = callback;
+  job->done = done;
   job->user_data = user_data;
   job->cancellable = (cancellable != NULL) ? g_object_ref(cancellable) : NULL;
   job->log = g_object_ref(log);
   job->err = NULL;
+  job->first_line = log->priv->lines_no;
+  job->start_offset = 0;
   job->lines = NULL;
+  job->index = NULL;
+  job->fd = -1;
+  job->n_old_files = log->priv->old_files->len;
+  job->new_fd = -1;
   job->new_days = NULL;
+  job->timestamp_format = log->priv->timestamp_format;
+
+  if (log->priv->followed != NULL) {
+    job->start_offset = logview_line_index_get_end(log->priv->followed->index);
+    job->fd = dup(log->priv->followed->fd);
+    job->tail_bytes = log_get_tail_bytes(log);
+  }
+
+  if (log->priv->sources != NULL) {
+    log_read_sources(job);
+    return;
+  }
 
   /* push the fetching job into another thread */
   g_io_scheduler_push_job(do_read_new_lines, job, NULL, 0, job->cancellable);
 }
 
+/* the sources are all read, their new lines can be merged */
+static void log_merge_sources(NewLinesJob *job) {
+  LogviewLogPrivate *priv = job->log->priv;
+  LogviewMergeSource *merge_source;
+  LogviewLog *source;
+  guint i;
+
+  job->merge_sources = g_new(LogviewMergeSource, priv->sources->len);
+
+  for (i = 0; i < priv->sources->len; i++) {
+    source = g_ptr_array_index(priv->sources, i);
+    merge_source = &job->merge_sources[i];
+
+    *merge_source = priv->merge_sources[i];
+    merge_source->format = source->priv->timestamp_format;
+    merge_source->days = logview_utils_day_list_copy(source->priv->days);
+    merge_source->n_lines = source->priv->lines_no - merge_source->first_line;
+  }
+
+  g_io_scheduler_push_job(do_read_new_lines, job, NULL, 0, job->cancellable);
+}
+
+static void source_lines_read_cb(LogviewLog *source, guint first_line,
+                                 guint n_lines, GSList *new_days,
+                                 GError *error, gpointer user_data) {
+  /* the lines are merged once all the sources are read, a source that
+   * can't be read is merged with what it had */
+}
+
+static void source_read_done(gpointer user_data) {
+  NewLinesJob *job = user_data;
+
+  if (--job->pending_sources == 0) {
+    log_merge_sources(job);
+  }
+}
+
+static void log_read_sources(NewLinesJob *job) {
+  LogviewLog *source;
+  guint i;
+
+  /* held until all the reads have been started */
+  job->pending_sources = 1;
+
+  for (i = 0; i < job->log->priv->sources->len; i++) {
+    source = g_ptr_array_index(job->log->priv->sources, i);
+
+    if (!source->priv->loaded || source->priv->has_new_lines) {
+      job->pending_sources++;
+      log_read_new_lines(source, job->cancellable, source_lines_read_cb,
+                         source_read_done, job);
+    }
+  }
+
+  source_read_done(job);
+}
+
+static void source_changed_cb(LogviewLog *source, gpointer user_data) {
+  LogviewLog *log = user_data;
+
+  log->priv->has_new_lines = TRUE;
+  g_signal_emit(log, signals[LOG_CHANGED], 0, NULL);
+}
+
+/* public methods */
+
+void logview_log_read_new_lines(LogviewLog *log, GCancellable *cancellable,
+                                LogviewNewLinesCallback callback,
+                                gpointer user_data) {
+  g_assert(LOGVIEW_IS_LOG(log));
+
+  log_read_new_lines(log, cancellable, callback, NULL, user_data);
+}
+
+/* like logview_log_read_new_lines(), with done called once the read is
+ * over, after the last call to callback */
+void logview_log_read_new_lines_full(LogviewLog *log,
+                                     GCancellable *cancellable,
+                                     LogviewNewLinesCallback callback,
+                                     GDestroyNotify done, gpointer user_data) {
+  g_assert(LOGVIEW_IS_LOG(log));
+
+  log_read_new_lines(log, cancellable, callback, done, user_data);
+}
+
 void logview_log_create(const char *filename, LogviewCreateCallback callback,
                         gpointer user_data) {
   LogviewLog *log = g_object_new(LOGVIEW_TYPE_LOG, NULL);
 
   log->priv->file = g_file_new_for_path(filename);
 
-  log_setup_load(log, callback, user_data);
+  log_setup_load(log, TRUE, callback, user_data);
 }
 
 void logview_log_create_from_gfile(GFile *file, LogviewCreateCallback callback,
@@ -770,7 +2017,74 @@ void logview_log_create_from_gfile(GFile *file, LogviewCreateCallback callback,
 
   log->priv->file = g_object_ref(file);
 
-  log_setup_load(log, callback, user_data);
+  log_setup_load(log, TRUE, callback, user_data);
+}
+
+/**
+ * logview_log_create_lazy:
+ *
+ * @file: the #GFile of the log.
+ * @callback: called once the log has been created.
+ * @user_data: the data passed to @callback.
+ *
+ * Like logview_log_create_from_gfile(), but only the stats of the file
+ * are read: the log is opened by its first read, which is what takes
+ * time for a large or compressed log.
+ */
+void logview_log_create_lazy(GFile *file, LogviewCreateCallback callback,
+                             gpointer user_data) {
+  LogviewLog *log = g_object_new(LOGVIEW_TYPE_LOG, NULL);
+
+  log->priv->file = g_object_ref(file);
+
+  log_setup_load(log, FALSE, callback, user_data);
+}
+
+/**
+ * logview_log_new_merged:
+ *
+ * @logs: a #GList of #LogviewLog.
+ *
+ * Returns: a new log with the lines of @logs, in the order of their
+ * timestamps. The lines are not copied, they are read from @logs,
+ * whose new lines are read and merged by logview_log_read_new_lines().
+ */
+LogviewLog *logview_log_new_merged(GList *logs) {
+  LogviewLog *log = g_object_new(LOGVIEW_TYPE_LOG, NULL);
+  LogviewLogPrivate *priv = log->priv;
+  LogviewLog *source;
+  GString *name;
+  GList *l;
+  guint i;
+
+  priv->opened = TRUE;
+  priv->sources = g_ptr_array_new_with_free_func(g_object_unref);
+  priv->merge_sources = g_new0(LogviewMergeSource, g_list_length(logs));
+  priv->merge = logview_merge_new();
+  name = g_string_new(NULL);
+
+  for (l = logs, i = 0; l != NULL; l = l->next, i++) {
+    source = l->data;
+
+    g_ptr_array_add(priv->sources, g_object_ref(source));
+    g_signal_connect(source, "log-changed", G_CALLBACK(source_changed_cb),
+                     log);
+
+    priv->merge_sources[i].get_line = source_get_line;
+    priv->merge_sources[i].user_data = source;
+
+    if (name->len > 0) {
+      g_string_append(name, ", ");
+    }
+    g_string_append(name, source->priv->display_name);
+  }
+
+  priv->file = g_file_new_for_uri(LOGVIEW_MERGED_LOG_URI);
+  priv->display_name = g_string_free(name, FALSE);
+  priv->has_new_lines = TRUE;
+  log_update_merged_stats(log);
+
+  return log;
 }
 
 const char *logview_log_get_display_name(LogviewLog *log) {
@@ -791,22 +2105,197 @@ goffset logview_log_get_file_size(LogviewLog *log) {
   return log->priv->file_size;
 }
 
+/* the main thread can read the lines anytime, other threads have to
+ * do it between these two */
+void logview_log_lock_lines(LogviewLog *log) {
+  guint i;
+
+  g_assert(LOGVIEW_IS_LOG(log));
+
+  g_rw_lock_reader_lock(&log->priv->lines_lock);
+
+  /* the lines of a merged log are those of its sources */
+  for (i = 0; log->priv->sources != NULL && i < log->priv->sources->len;
+       i++) {
+    logview_log_lock_lines(g_ptr_array_index(log->priv->sources, i));
+  }
+}
+
+void logview_log_unlock_lines(LogviewLog *log) {
+  guint i;
+
+  g_assert(LOGVIEW_IS_LOG(log));
+
+  for (i = 0; log->priv->sources != NULL && i < log->priv->sources->len;
+       i++) {
+    logview_log_unlock_lines(g_ptr_array_index(log->priv->sources, i));
+  }
+
+  g_rw_lock_reader_unlock(&log->priv->lines_lock);
+}
+
 guint logview_log_get_cached_lines_number(LogviewLog *log) {
   g_assert(LOGVIEW_IS_LOG(log));
 
   return log->priv->lines_no;
 }
 
-const char **logview_log_get_cached_lines(LogviewLog *log) {
-  const char **lines = NULL;
+/* the lines of the files the log had before a rotation */
+static const char *log_get_old_line(LogviewLog *log, guint line,
+                                    gsize *len) {
+  GPtrArray *old_files = log->priv->old_files;
+  LogFile *file;
+  guint low, high, mid;
+
+  low = 0;
+  high = old_files->len;
+
+  while (high - low > 1) {
+    mid = low + (high - low) / 2;
+    file = g_ptr_array_index(old_files, mid);
+
+    if (file->first_line > line) {
+      high = mid;
+    } else {
+      low = mid;
+    }
+  }
+
+  return log_file_get_line(g_ptr_array_index(old_files, low), line, len);
+}
+
+/**
+ * logview_log_get_line:
+ *
+ * @log: a #LogviewLog.
+ * @line: the number of a cached line.
+ * @len: return location for the length of the line.
+ *
+ * Returns: the text of the line, which is not NUL-terminated and is only
+ * valid until the calling thread gets another line, of any log, or the
+ * log reads new lines; %NULL if @line is out of range.
+ */
+const char *logview_log_get_line(LogviewLog *log, guint line, gsize *len) {
+  guint64 start;
+  guint source, source_line;
 
   g_assert(LOGVIEW_IS_LOG(log));
 
-  if (log->priv->lines) {
-    lines = (const char **)log->priv->lines->pdata;
+  if (line >= log->priv->lines_no) {
+    return NULL;
+  }
+
+  if (log->priv->journal != NULL) {
+    return logview_journal_get_line(log->priv->journal, line, len);
   }
 
-  return lines;
+  if (log->priv->merge != NULL) {
+    logview_merge_get_line(log->priv->merge, line, &source, &source_line);
+    return logview_log_get_line(g_ptr_array_index(log->priv->sources, source),
+                                source_line, len);
+  }
+
+  if (log->priv->followed != NULL) {
+    if (line < log->priv->followed->first_line) {
+      return log_get_old_line(log, line, len);
+    }
+
+    return log_file_get_line(log->priv->followed, line, len);
+  }
+
+  if (line < log->priv->spilled_lines) {
+    logview_line_index_get_line(log->priv->spill_index, line, &start, len);
+    return g_mapped_file_get_contents(log->priv->spill_map) + start;
+  }
+
+  return logview_line_store_get_line(log->priv->lines,
+                                     line - log->priv->spilled_lines, len);
+}
+
+/* whether text, that of line, is valid UTF-8; the lines of journals
+ * are checked on the text, the others were when they were read */
+static gboolean log_line_is_utf8(LogviewLog *log, guint line,
+                                 const char *text, gsize len) {
+  guint source, source_line;
+
+  if (log->priv->journal != NULL) {
+    return g_utf8_validate(text, (gssize)len, NULL);
+  }
+
+  if (log->priv->merge != NULL) {
+    logview_merge_get_line(log->priv->merge, line, &source, &source_line);
+    return log_line_is_utf8(g_ptr_array_index(log->priv->sources, source),
+                            source_line, text, len);
+  }
+
+  return !logview_utils_line_ranges_contain(log->priv->invalid_lines, line);
+}
+
+/* whether line is valid UTF-8, as checked when it was read */
+gboolean logview_log_get_line_is_utf8(LogviewLog *log, guint line) {
+  const char *text;
+  gsize len;
+
+  g_assert(LOGVIEW_IS_LOG(log));
+
+  text = logview_log_get_line(log, line, &len);
+
+  return text == NULL || log_line_is_utf8(log, line, text, len);
+}
+
+/**
+ * logview_log_get_line_utf8:
+ *
+ * @log: a #LogviewLog.
+ * @line: the line to get.
+ * @len: return location for the length of the line.
+ * @converted: return location for the converted text to free, or %NULL
+ *   if the line was valid UTF-8 already.
+ *
+ * Like logview_log_get_line(), but the text is always UTF-8: the lines
+ * that aren't are converted from the locale charset, with what can't be
+ * converted replaced.
+ *
+ * Returns: the text of the line, not NUL-terminated, or %NULL if @line
+ * is out of range.
+ */
+const char *logview_log_get_line_utf8(LogviewLog *log, guint line, gsize *len,
+                                      char **converted) {
+  const char *text;
+
+  *converted = NULL;
+  text = logview_log_get_line(log, line, len);
+
+  /* the line isn't asked for again, the text of a journal line could
+   * go away meanwhile */
+  if (text == NULL || log_line_is_utf8(log, line, text, *len)) {
+    return text;
+  }
+
+  *converted = logview_utils_line_to_utf8(text, *len, len);
+  return *converted;
+}
+
+/**
+ * logview_log_set_tail:
+ *
+ * @log: a #LogviewLog.
+ * @max_lines: the most lines to keep in memory, or 0.
+ * @max_bytes: the most bytes of lines to keep in memory, or 0.
+ *
+ * Bounds the memory taken by the text of the lines of a log. The older
+ * lines of a log read from a stream, i.e. a compressed or remote one,
+ * are moved to a temporary file, from which they are paged back when
+ * they are needed. Those of a plain local log are dropped and read back
+ * from the file, even after it has been rotated; only the lines kept
+ * are left of a file that has been truncated. Plain logs keep a few
+ * megabytes of lines at most if @max_bytes is 0.
+ */
+void logview_log_set_tail(LogviewLog *log, guint max_lines, gsize max_bytes) {
+  g_assert(LOGVIEW_IS_LOG(log));
+
+  log->priv->tail_lines = max_lines;
+  log->priv->tail_bytes = max_bytes;
 }
 
 GSList *logview_log_get_days_for_cached_lines(LogviewLog *log) {
@@ -821,6 +2310,13 @@ gboolean logview_log_has_new_lines(LogviewLog *log) {
   return log->priv->has_new_lines;
 }
 
+/* returns FALSE while the first read of the log is still going on */
+gboolean logview_log_is_loaded(LogviewLog *log) {
+  g_assert(LOGVIEW_IS_LOG(log));
+
+  return log->priv->loaded;
+}
+
 char *logview_log_get_uri(LogviewLog *log) {
   g_assert(LOGVIEW_IS_LOG(log));
 
@@ -838,3 +2334,39 @@ gboolean logview_log_get_has_days(LogviewLog *log) {
 
   return log->priv->has_days;
 }
+
+gboolean logview_log_is_merged(LogviewLog *log) {
+  g_assert(LOGVIEW_IS_LOG(log));
+
+  return log->priv->sources != NULL;
+}
+
+/* the logs of a merged log, the list has to be freed */
+GList *logview_log_get_sources(LogviewLog *log) {
+  GList *sources = NULL;
+  guint i;
+
+  g_assert(LOGVIEW_IS_LOG(log));
+
+  for (i = 0; log->priv->sources != NULL && i < log->priv->sources->len;
+       i++) {
+    sources = g_list_prepend(sources, g_ptr_array_index(log->priv->sources, i));
+  }
+
+  return g_list_reverse(sources);
+}
+
+/* the log a line of a merged log comes from, NULL for other logs */
+LogviewLog *logview_log_get_line_source(LogviewLog *log, guint line) {
+  guint source, source_line;
+
+  g_assert(LOGVIEW_IS_LOG(log));
+
+  if (log->priv->merge == NULL || line >= log->priv->lines_no) {
+    return NULL;
+  }
+
+  logview_merge_get_line(log->priv->merge, line, &source, &source_line);
+
+  return g_ptr_array_index(log->priv->sources, source);
+}
@@ -48,16 +48,19 @@ typedef struct _LogviewLogPrivate LogviewLogPrivate;
 
 typedef void (*LogviewCreateCallback)(LogviewLog *log, GError *error,
                                       gpointer user_data);
-typedef void (*LogviewNewLinesCallback)(LogviewLog *log, const char **lines,
-                                        GSList *new_days, GError *error,
-                                        gpointer user_data);
+typedef void (*LogviewNewLinesCallback)(LogviewLog *log, guint first_line,
+                                        guint n_lines, GSList *new_days,
+                                        GError *error, gpointer user_data);
 
 #define LOGVIEW_ERROR_QUARK g_quark_from_static_string("logview-error")
 
+/* a merged log has no file of its own */
+#define LOGVIEW_MERGED_LOG_URI "logview-merged:///"
+
 typedef enum {
   LOGVIEW_ERROR_FAILED,
   LOGVIEW_ERROR_PERMISSION_DENIED,
-  LOGVIEW_ERROR_ZLIB,
+  LOGVIEW_ERROR_DECOMPRESS,
   LOGVIEW_ERROR_NOT_SUPPORTED,
   LOGVIEW_ERROR_NOT_A_LOG
 } LogviewErrorEnum;
@@ -83,20 +86,37 @@ void logview_log_create(const char *filename, LogviewCreateCallback callback,
                         gpointer user_data);
 void logview_log_create_from_gfile(GFile *file, LogviewCreateCallback callback,
                                    gpointer user_data);
+void logview_log_create_lazy(GFile *file, LogviewCreateCallback callback,
+                             gpointer user_data);
+LogviewLog *logview_log_new_merged(GList *logs);
 void logview_log_read_new_lines(LogviewLog *log, GCancellable *cancellable,
                                 LogviewNewLinesCallback callback,
                                 gpointer user_data);
+void logview_log_read_new_lines_full(LogviewLog *log,
+                                     GCancellable *cancellable,
+                                     LogviewNewLinesCallback callback,
+                                     GDestroyNotify done, gpointer user_data);
 
 const char *logview_log_get_display_name(LogviewLog *log);
 time_t logview_log_get_timestamp(LogviewLog *log);
 goffset logview_log_get_file_size(LogviewLog *log);
-const char **logview_log_get_cached_lines(LogviewLog *log);
+const char *logview_log_get_line(LogviewLog *log, guint line, gsize *len);
+gboolean logview_log_get_line_is_utf8(LogviewLog *log, guint line);
+const char *logview_log_get_line_utf8(LogviewLog *log, guint line, gsize *len,
+                                      char **converted);
+void logview_log_lock_lines(LogviewLog *log);
+void logview_log_unlock_lines(LogviewLog *log);
 guint logview_log_get_cached_lines_number(LogviewLog *log);
+void logview_log_set_tail(LogviewLog *log, guint max_lines, gsize max_bytes);
 GSList *logview_log_get_days_for_cached_lines(LogviewLog *log);
 gboolean logview_log_has_new_lines(LogviewLog *log);
+gboolean logview_log_is_loaded(LogviewLog *log);
 char *logview_log_get_uri(LogviewLog *log);
 GFile *logview_log_get_gfile(LogviewLog *log);
 gboolean logview_log_get_has_days(LogviewLog *log);
+gboolean logview_log_is_merged(LogviewLog *log);
+GList *logview_log_get_sources(LogviewLog *log);
+LogviewLog *logview_log_get_line_source(LogviewLog *log, guint line);
 
 G_END_DECLS
 
@@ -29,10 +29,21 @@
 #include <stdlib.h>
 
 #include "logview-app.h"
+#include "logview-batch.h"
+#include "logview-journal.h"
 
 /* log files specified on the command line */
 static char **log_files = NULL;
 
+/* the entries of the journals to show */
+static char **journal_matches = NULL;
+
+/* print the lines instead of showing them, see logview_batch_run() */
+static gboolean batch = FALSE;
+static char **batch_filters = NULL;
+static char *batch_day = NULL;
+static gboolean batch_timing = FALSE;
+
 static void app_quit_cb(LogviewApp *app, gpointer user_data) {
   gtk_main_quit();
 }
@@ -54,6 +65,21 @@ static GOptionContext *create_option_context(void) {
       {"version", 'V', G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK,
        logview_show_version_and_quit, N_("Show the application's version"),
        NULL},
+      {"match", 'm', 0, G_OPTION_ARG_STRING_ARRAY, &journal_matches,
+       N_("Only show the journal entries with this field, e.g. "
+          "_SYSTEMD_UNIT=cron.service, PRIORITY=3 or _PID=1"),
+       N_("FIELD=VALUE")},
+      {"batch", 'b', 0, G_OPTION_ARG_NONE, &batch,
+       N_("Print the lines of the logs instead of showing them"), NULL},
+      {"filter", 'f', 0, G_OPTION_ARG_STRING_ARRAY, &batch_filters,
+       N_("With --batch, only print the lines matching this saved filter"),
+       N_("NAME")},
+      {"day", 'd', 0, G_OPTION_ARG_STRING, &batch_day,
+       N_("With --batch, only print the lines of this day"),
+       N_("YYYY-MM-DD")},
+      {"timing", 't', 0, G_OPTION_ARG_NONE, &batch_timing,
+       N_("With --batch, report how long reading and filtering took"),
+       NULL},
       {G_OPTION_REMAINING, '\0', 0, G_OPTION_ARG_FILENAME_ARRAY, &log_files,
        NULL, N_("[LOGFILE...]")},
       {NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL},
@@ -65,7 +91,8 @@ static GOptionContext *create_option_context(void) {
 #endif /* ENABLE_NLS */
   g_option_context_add_main_entries(context, entries, GETTEXT_PACKAGE);
   g_option_context_set_ignore_unknown_options(context, TRUE);
-  g_option_context_add_group(context, gtk_get_option_group(TRUE));
+  /* the display is only opened out of batch mode */
+  g_option_context_add_group(context, gtk_get_option_group(FALSE));
 
   return context;
 }
@@ -96,6 +123,15 @@ int main(int argc, char *argv[]) {
   g_option_context_free(context);
   g_set_application_name(_("Log Viewer"));
 
+  logview_journal_set_matches(journal_matches);
+
+  if (batch) {
+    return logview_batch_run(log_files, batch_filters, batch_day,
+                             batch_timing);
+  }
+
+  gtk_init(&argc, &argv);
+
   app = logview_app_get();
 
   if (!app) {
@@ -134,6 +134,10 @@ static void create_log_cb(LogviewLog *log, GError *error, gpointer user_data) {
     file = logview_log_get_gfile(log);
     logview_prefs_store_log(prefs, file);
 
+    logview_log_set_tail(
+        log, MAX(logview_prefs_get_tail_lines(prefs), 0),
+        (gsize)MAX(logview_prefs_get_tail_size(prefs), 0) * 1024 * 1024);
+
     g_object_unref(file);
 
     g_signal_emit(data->manager, signals[LOG_ADDED], 0, log, NULL);
@@ -202,7 +206,13 @@ static void add_log_from_gfile_internal(LogviewManager *manager, GFile *file,
     data->is_multiple = is_multiple;
     data->file = g_object_ref(file);
 
-    logview_log_create_from_gfile(file, create_log_cb, data);
+    /* of the many logs opened at once, only the ones that are looked at
+     * are read */
+    if (is_multiple) {
+      logview_log_create_lazy(file, create_log_cb, data);
+    } else {
+      logview_log_create_from_gfile(file, create_log_cb, data);
+    }
   }
 
   g_free(file_uri);
@@ -244,11 +254,14 @@ void logview_manager_set_active_log(LogviewManager *manager, LogviewLog *log) {
 
   manager->priv->active_log = g_object_ref(log);
 
-  file = logview_log_get_gfile(log);
-  path = g_file_get_path(file);
-  logview_prefs_store_active_logfile(logview_prefs_get(), path);
-  g_free(path);
-  g_object_unref(file);
+  /* a merged log isn't stored, it's made again from the logs */
+  if (!logview_log_is_merged(log)) {
+    file = logview_log_get_gfile(log);
+    path = g_file_get_path(file);
+    logview_prefs_store_active_logfile(logview_prefs_get(), path);
+    g_free(path);
+    g_object_unref(file);
+  }
 
   g_signal_emit(manager, signals[ACTIVE_CHANGED], 0, log, old_log, NULL);
 
@@ -341,7 +354,9 @@ void logview_manager_close_active_log(LogviewManager *manager) {
 
   g_signal_emit(manager, signals[LOG_CLOSED], 0, active_log, NULL);
 
-  logview_prefs_remove_stored_log(logview_prefs_get(), file);
+  if (!logview_log_is_merged(active_log)) {
+    logview_prefs_remove_stored_log(logview_prefs_get(), file);
+  }
 
   g_object_unref(file);
 
@@ -353,6 +368,50 @@ void logview_manager_close_active_log(LogviewManager *manager) {
   /* someone else will take care of setting the next active log to us */
 }
 
+static gint compare_display_names(gconstpointer a, gconstpointer b) {
+  return g_utf8_collate(logview_log_get_display_name((LogviewLog *)a),
+                        logview_log_get_display_name((LogviewLog *)b));
+}
+
+/* shows the lines of all the open logs in a single log, merged by time,
+ * in place of the one merged before */
+void logview_manager_add_merged_log(LogviewManager *manager) {
+  GHashTableIter iter;
+  LogviewLog *log, *merged;
+  GList *logs = NULL;
+
+  g_assert(LOGVIEW_IS_MANAGER(manager));
+
+  g_hash_table_iter_init(&iter, manager->priv->logs);
+
+  while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&log)) {
+    if (!logview_log_is_merged(log)) {
+      logs = g_list_insert_sorted(logs, log, compare_display_names);
+    }
+  }
+
+  if (logs == NULL || logs->next == NULL) {
+    g_list_free(logs);
+    return;
+  }
+
+  merged = g_hash_table_lookup(manager->priv->logs, LOGVIEW_MERGED_LOG_URI);
+
+  if (merged != NULL) {
+    g_signal_emit(manager, signals[LOG_CLOSED], 0, merged, NULL);
+    g_hash_table_remove(manager->priv->logs, LOGVIEW_MERGED_LOG_URI);
+  }
+
+  merged = logview_log_new_merged(logs);
+  g_list_free(logs);
+
+  g_hash_table_insert(manager->priv->logs, g_strdup(LOGVIEW_MERGED_LOG_URI),
+                      merged);
+
+  g_signal_emit(manager, signals[LOG_ADDED], 0, merged, NULL);
+  logview_manager_set_active_log(manager, merged);
+}
+
 gboolean logview_manager_log_is_active(LogviewManager *manager,
                                        LogviewLog *log) {
   g_assert(LOGVIEW_IS_MANAGER(manager));
@@ -76,6 +76,7 @@ LogviewLog *logview_manager_get_if_loaded(LogviewManager *manager,
 gboolean logview_manager_log_is_active(LogviewManager *manager,
                                        LogviewLog *log);
 void logview_manager_close_active_log(LogviewManager *manager);
+void logview_manager_add_merged_log(LogviewManager *manager);
 
 G_END_DECLS
 
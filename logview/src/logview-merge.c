@@ -0,0 +1,349 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "logview-merge.h"
+
+/* The merge puts the lines of several logs in the order of their
+ * timestamps, without copying them: for every run of consecutive lines
+ * of the same log, it only keeps where the run starts in the merge and
+ * in that log. The logs are merged k-way, taking the earliest of their
+ * next lines from a heap, and a log gives its lines until one of them
+ * is later than the next line of another.
+ */
+
+#define SECONDS_PER_DAY 86400
+
+typedef struct {
+  guint first_line;
+  guint source;
+  guint source_line;
+} MergeRun;
+
+struct _LogviewMerge {
+  GArray *runs;
+  guint n_lines;
+};
+
+/* the next line of a log to be merged */
+typedef struct {
+  LogviewMergeSource *source;
+  guint index;
+  GSList *day;
+  guint line;
+  guint end;
+} MergeCursor;
+
+LogviewMerge *logview_merge_new(void) {
+  LogviewMerge *merge;
+
+  merge = g_slice_new0(LogviewMerge);
+  merge->runs = g_array_new(FALSE, FALSE, sizeof(MergeRun));
+
+  return merge;
+}
+
+void logview_merge_free(LogviewMerge *merge) {
+  if (merge == NULL) {
+    return;
+  }
+
+  g_array_free(merge->runs, TRUE);
+  g_slice_free(LogviewMerge, merge);
+}
+
+guint logview_merge_get_n_lines(LogviewMerge *merge) {
+  return merge->n_lines;
+}
+
+/* which log a line of the merge comes from, and its number there */
+void logview_merge_get_line(LogviewMerge *merge, guint line, guint *source,
+                            guint *source_line) {
+  MergeRun *run;
+  guint low, high, mid;
+
+  g_assert(line < merge->n_lines);
+
+  low = 0;
+  high = merge->runs->len;
+
+  while (high - low > 1) {
+    mid = low + (high - low) / 2;
+
+    if (g_array_index(merge->runs, MergeRun, mid).first_line > line) {
+      high = mid;
+    } else {
+      low = mid;
+    }
+  }
+
+  run = &g_array_index(merge->runs, MergeRun, low);
+
+  *source = run->source;
+  *source_line = run->source_line + (line - run->first_line);
+}
+
+static void merge_add_run(LogviewMerge *merge, guint source,
+                          guint source_line, guint n_lines) {
+  MergeRun *run;
+
+  if (merge->runs->len > 0) {
+    run = &g_array_index(merge->runs, MergeRun, merge->runs->len - 1);
+
+    /* the run goes on */
+    if (run->source == source &&
+        run->source_line + (merge->n_lines - run->first_line) ==
+            source_line) {
+      merge->n_lines += n_lines;
+      return;
+    }
+  }
+
+  g_array_set_size(merge->runs, merge->runs->len + 1);
+  run = &g_array_index(merge->runs, MergeRun, merge->runs->len - 1);
+  run->first_line = merge->n_lines;
+  run->source = source;
+  run->source_line = source_line;
+
+  merge->n_lines += n_lines;
+}
+
+void logview_merge_append_merge(LogviewMerge *merge, LogviewMerge *other) {
+  MergeRun *run;
+  guint i, n_lines;
+
+  for (i = 0; i < other->runs->len; i++) {
+    run = &g_array_index(other->runs, MergeRun, i);
+    n_lines = ((i + 1 < other->runs->len)
+                   ? g_array_index(other->runs, MergeRun, i + 1).first_line
+                   : other->n_lines) -
+              run->first_line;
+
+    merge_add_run(merge, run->source, run->source_line, n_lines);
+  }
+}
+
+/* the time of the line under the cursor, in seconds since the start of
+ * the julian calendar; the day comes from the days of the log, which
+ * know about the years */
+static void cursor_update_time(MergeCursor *cursor) {
+  LogviewMergeSource *source = cursor->source;
+  LogviewTimestamp timestamp;
+  const char *text;
+  gsize len;
+  gint64 julian;
+  Day *day;
+
+  text = source->get_line(source->user_data, (int)cursor->line, &len);
+
+  if (text == NULL || source->format == LOGVIEW_TIMESTAMP_UNKNOWN ||
+      !logview_timestamp_parse(source->format, text, len, &timestamp)) {
+    /* it goes on the line before */
+    return;
+  }
+
+  while (cursor->day != NULL &&
+         (int)cursor->line > ((Day *)cursor->day->data)->last_line) {
+    cursor->day = cursor->day->next;
+  }
+
+  day = (cursor->day != NULL) ? cursor->day->data : NULL;
+
+  if (day != NULL && (int)cursor->line >= day->first_line) {
+    julian = g_date_get_julian(day->date);
+  } else {
+    julian = source->time / SECONDS_PER_DAY;
+  }
+
+  source->time = julian * SECONDS_PER_DAY;
+
+  if (timestamp.hour >= 0) {
+    source->time +=
+        timestamp.hour * 3600 + timestamp.minute * 60 + timestamp.second;
+  }
+}
+
+static gboolean cursor_before(MergeCursor *a, MergeCursor *b) {
+  return a->source->time < b->source->time ||
+         (a->source->time == b->source->time && a->index < b->index);
+}
+
+static void heap_push(MergeCursor **heap, guint *n_heap, MergeCursor *cursor) {
+  guint i, parent;
+
+  for (i = (*n_heap)++; i > 0; i = parent) {
+    parent = (i - 1) / 2;
+
+    if (!cursor_before(cursor, heap[parent])) {
+      break;
+    }
+
+    heap[i] = heap[parent];
+  }
+
+  heap[i] = cursor;
+}
+
+static MergeCursor *heap_pop(MergeCursor **heap, guint *n_heap) {
+  MergeCursor *top = heap[0], *last;
+  guint i, child;
+
+  last = heap[--(*n_heap)];
+
+  for (i = 0; (child = 2 * i + 1) < *n_heap; i = child) {
+    if (child + 1 < *n_heap && cursor_before(heap[child + 1], heap[child])) {
+      child++;
+    }
+
+    if (!cursor_before(heap[child], last)) {
+      break;
+    }
+
+    heap[i] = heap[child];
+  }
+
+  heap[i] = last;
+
+  return top;
+}
+
+static Day *merge_day_new(gint64 julian, int line) {
+  Day *day;
+  int hour;
+
+  day = g_slice_new0(Day);
+  day->date = g_date_new_julian((guint32)julian);
+  day->first_line = line;
+  day->last_line = -1;
+
+  for (hour = 0; hour < 24; hour++) {
+    day->hour_lines[hour] = -1;
+  }
+
+  return day;
+}
+
+/* the days of the merge are those of the times of its lines, lines
+ * without a time or earlier than the day before them belong to it */
+static GSList *merge_add_day(GSList *days, gint64 time, int line) {
+  gint64 julian = time / SECONDS_PER_DAY;
+  Day *day = (days != NULL) ? days->data : NULL;
+  int hour;
+
+  if (julian <= 0) {
+    return days;
+  }
+
+  if (day == NULL || julian > g_date_get_julian(day->date)) {
+    if (day != NULL) {
+      day->last_line = line - 1;
+    }
+
+    day = merge_day_new(julian, line);
+    days = g_slist_prepend(days, day);
+  } else if (julian < g_date_get_julian(day->date)) {
+    return days;
+  }
+
+  hour = (int)(time % SECONDS_PER_DAY / 3600);
+
+  if (day->hour_lines[hour] < 0) {
+    day->hour_lines[hour] = line;
+  }
+
+  return days;
+}
+
+/**
+ * logview_merge_run:
+ *
+ * @merge: a #LogviewMerge.
+ * @sources: the logs to merge.
+ * @n_sources: the number of @sources.
+ *
+ * Merges the lines of @sources and appends them to @merge. Each source
+ * is updated to start after the lines merged, so that its new lines
+ * can be merged the same way later on.
+ *
+ * Returns: a #GSList of #Day structures for the lines appended, which
+ * are numbered from the first of them.
+ */
+GSList *logview_merge_run(LogviewMerge *merge, LogviewMergeSource *sources,
+                          guint n_sources) {
+  MergeCursor *cursors, **heap, *cursor;
+  GSList *days = NULL;
+  guint first_line, n_heap = 0, i;
+
+  first_line = merge->n_lines;
+  cursors = g_new0(MergeCursor, n_sources);
+  heap = g_new(MergeCursor *, MAX(n_sources, 1));
+
+  for (i = 0; i < n_sources; i++) {
+    cursor = &cursors[i];
+    cursor->source = &sources[i];
+    cursor->index = i;
+    cursor->day = sources[i].days;
+    cursor->line = sources[i].first_line;
+    cursor->end = sources[i].first_line + sources[i].n_lines;
+
+    if (cursor->line < cursor->end) {
+      cursor_update_time(cursor);
+      heap_push(heap, &n_heap, cursor);
+    }
+  }
+
+  while (n_heap > 0) {
+    cursor = heap_pop(heap, &n_heap);
+
+    /* the lines of a log stay together as long as they are not later
+     * than the next line of another */
+    do {
+      merge_add_run(merge, cursor->index, cursor->line, 1);
+      days = merge_add_day(days, cursor->source->time,
+                           (int)(merge->n_lines - 1 - first_line));
+
+      if (++cursor->line == cursor->end) {
+        break;
+      }
+
+      cursor_update_time(cursor);
+    } while (n_heap == 0 || cursor->source->time <= heap[0]->source->time);
+
+    if (cursor->line < cursor->end) {
+      heap_push(heap, &n_heap, cursor);
+    }
+  }
+
+  for (i = 0; i < n_sources; i++) {
+    sources[i].first_line = cursors[i].end;
+    sources[i].n_lines = 0;
+  }
+
+  if (days != NULL) {
+    ((Day *)days->data)->last_line = (int)(merge->n_lines - 1 - first_line);
+  }
+
+  g_free(cursors);
+  g_free(heap);
+
+  return g_slist_reverse(days);
+}
@@ -0,0 +1,65 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* logview-merge.h */
+
+#ifndef __LOGVIEW_MERGE_H__
+#define __LOGVIEW_MERGE_H__
+
+#include <glib.h>
+
+#include "logview-timestamp.h"
+#include "logview-utils.h"
+
+G_BEGIN_DECLS
+
+typedef struct _LogviewMerge LogviewMerge;
+
+/* the lines of one of the logs being merged */
+typedef struct {
+  LogviewGetLineFunc get_line;
+  gpointer user_data;
+  LogviewTimestampFormat format;
+
+  /* the days of the log, which date its lines */
+  GSList *days;
+
+  /* the lines to merge */
+  guint first_line;
+  guint n_lines;
+
+  /* the time of the last line merged, given to the lines after it
+   * that have no timestamp */
+  gint64 time;
+} LogviewMergeSource;
+
+LogviewMerge *logview_merge_new(void);
+void logview_merge_free(LogviewMerge *merge);
+
+guint logview_merge_get_n_lines(LogviewMerge *merge);
+void logview_merge_get_line(LogviewMerge *merge, guint line, guint *source,
+                            guint *source_line);
+
+GSList *logview_merge_run(LogviewMerge *merge, LogviewMergeSource *sources,
+                          guint n_sources);
+void logview_merge_append_merge(LogviewMerge *merge, LogviewMerge *other);
+
+G_END_DECLS
+
+#endif /* __LOGVIEW_MERGE_H__ */
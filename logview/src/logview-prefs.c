@@ -42,6 +42,8 @@
 #define PREF_LOGFILES "logfiles"
 #define PREF_FONTSIZE "fontsize"
 #define PREF_FILTERS "filters"
+#define PREF_TAIL_LINES "tail-lines"
+#define PREF_TAIL_SIZE "tail-size"
 
 /* desktop-wide settings */
 #define MATE_MONOSPACE_FONT_NAME "monospace-font-name"
@@ -403,6 +405,19 @@ int logview_prefs_get_stored_fontsize(LogviewPrefs *prefs) {
   return g_settings_get_int(prefs->priv->logview_prefs, PREF_FONTSIZE);
 }
 
+int logview_prefs_get_tail_lines(LogviewPrefs *prefs) {
+  g_assert(LOGVIEW_IS_PREFS(prefs));
+
+  return g_settings_get_int(prefs->priv->logview_prefs, PREF_TAIL_LINES);
+}
+
+/* in megabytes */
+int logview_prefs_get_tail_size(LogviewPrefs *prefs) {
+  g_assert(LOGVIEW_IS_PREFS(prefs));
+
+  return g_settings_get_int(prefs->priv->logview_prefs, PREF_TAIL_SIZE);
+}
+
 void logview_prefs_store_active_logfile(LogviewPrefs *prefs,
                                         const char *filename) {
   g_assert(LOGVIEW_IS_PREFS(prefs));
@@ -69,6 +69,8 @@ void logview_prefs_remove_stored_log(LogviewPrefs *prefs, GFile *target);
 gchar **logview_prefs_get_stored_logfiles(LogviewPrefs *prefs);
 void logview_prefs_store_fontsize(LogviewPrefs *prefs, int fontsize);
 int logview_prefs_get_stored_fontsize(LogviewPrefs *prefs);
+int logview_prefs_get_tail_lines(LogviewPrefs *prefs);
+int logview_prefs_get_tail_size(LogviewPrefs *prefs);
 void logview_prefs_store_active_logfile(LogviewPrefs *prefs,
                                         const char *filename);
 char *logview_prefs_get_active_logfile(LogviewPrefs *prefs);
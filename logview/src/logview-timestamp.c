@@ -0,0 +1,345 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "logview-timestamp.h"
+
+/* The timestamps are parsed by hand rather than with strptime(): a
+ * log is scanned line by line, with the format that has been detected
+ * on its first timestamp, so this has to be cheap. The names of months
+ * and days are the English ones, whatever the locale.
+ */
+
+static const char month_names[] = "janfebmaraprmayjunjulaugsepoctnovdec";
+static const char day_names[] = "sunmontuewedthufrisat";
+
+static gboolean parse_char(const char **p, const char *end, char c) {
+  if (*p == end || **p != c) {
+    return FALSE;
+  }
+
+  (*p)++;
+
+  return TRUE;
+}
+
+/* exactly n digits */
+static gboolean parse_number(const char **p, const char *end, int n,
+                             int *value) {
+  int i;
+
+  if (end - *p < n) {
+    return FALSE;
+  }
+
+  *value = 0;
+
+  for (i = 0; i < n; i++) {
+    if (!g_ascii_isdigit((*p)[i])) {
+      return FALSE;
+    }
+
+    *value = *value * 10 + ((*p)[i] - '0');
+  }
+
+  *p += n;
+
+  return TRUE;
+}
+
+/* a day of the month, one or two digits */
+static gboolean parse_day(const char **p, const char *end, int *day) {
+  if (!parse_number(p, end, 2, day) && !parse_number(p, end, 1, day)) {
+    return FALSE;
+  }
+
+  return *day >= 1 && *day <= 31;
+}
+
+/* one of names, by its first three letters; returns the position */
+static int parse_name(const char **p, const char *end, const char *names) {
+  const char *name;
+  int i;
+
+  if (end - *p < 3) {
+    return -1;
+  }
+
+  for (name = names, i = 0; *name != '\0'; name += 3, i++) {
+    if (g_ascii_tolower((*p)[0]) == name[0] &&
+        g_ascii_tolower((*p)[1]) == name[1] &&
+        g_ascii_tolower((*p)[2]) == name[2]) {
+      *p += 3;
+
+      /* the rest of a full name */
+      while (*p < end && g_ascii_isalpha(**p)) {
+        (*p)++;
+      }
+
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+/* HH:MM[:SS] */
+static gboolean parse_time(const char **p, const char *end,
+                           LogviewTimestamp *timestamp) {
+  const char *start = *p;
+
+  if (!parse_number(p, end, 2, &timestamp->hour) || !parse_char(p, end, ':') ||
+      !parse_number(p, end, 2, &timestamp->minute)) {
+    goto fail;
+  }
+
+  if (*p < end && **p == ':' &&
+      !(parse_char(p, end, ':') &&
+        parse_number(p, end, 2, &timestamp->second))) {
+    goto fail;
+  }
+
+  if (timestamp->hour < 24 && timestamp->minute < 60 &&
+      timestamp->second <= 60) {
+    return TRUE;
+  }
+
+fail:
+  *p = start;
+  timestamp->hour = -1;
+  timestamp->minute = timestamp->second = 0;
+
+  return FALSE;
+}
+
+/* .123 or ,123 */
+static void skip_fraction(const char **p, const char *end) {
+  if (end - *p < 2 || (**p != '.' && **p != ',') || !g_ascii_isdigit((*p)[1])) {
+    return;
+  }
+
+  for ((*p)++; *p < end && g_ascii_isdigit(**p); (*p)++)
+    ;
+}
+
+/* Z, +HH, +HHMM or +HH:MM */
+static void skip_timezone(const char **p, const char *end) {
+  const char *start = *p;
+  int value;
+
+  if (parse_char(p, end, 'Z')) {
+    return;
+  }
+
+  if (!parse_char(p, end, '+') && !parse_char(p, end, '-')) {
+    return;
+  }
+
+  if (!parse_number(p, end, 2, &value)) {
+    *p = start;
+    return;
+  }
+
+  if (!parse_number(p, end, 2, &value)) {
+    start = *p;
+
+    if (!parse_char(p, end, ':') || !parse_number(p, end, 2, &value)) {
+      *p = start;
+    }
+  }
+}
+
+/* Oct  5 12:34:56 */
+static gboolean parse_syslog(const char **p, const char *end,
+                             LogviewTimestamp *timestamp) {
+  const char *time_start;
+
+  timestamp->month = parse_name(p, end, month_names) + 1;
+
+  if (timestamp->month == 0 || !parse_char(p, end, ' ')) {
+    return FALSE;
+  }
+
+  /* the day is padded with a space */
+  parse_char(p, end, ' ');
+
+  if (!parse_day(p, end, &timestamp->day)) {
+    return FALSE;
+  }
+
+  time_start = *p;
+
+  if (!parse_char(p, end, ' ') || !parse_time(p, end, timestamp)) {
+    *p = time_start;
+  }
+
+  return TRUE;
+}
+
+/* 2021-10-05T12:34:56.789+02:00 */
+static gboolean parse_iso8601(const char **p, const char *end,
+                              LogviewTimestamp *timestamp) {
+  const char *time_start;
+
+  if (!parse_number(p, end, 4, &timestamp->year) || !parse_char(p, end, '-') ||
+      !parse_number(p, end, 2, &timestamp->month) ||
+      !parse_char(p, end, '-') || !parse_number(p, end, 2, &timestamp->day)) {
+    return FALSE;
+  }
+
+  time_start = *p;
+
+  if ((parse_char(p, end, 'T') || parse_char(p, end, ' ')) &&
+      parse_time(p, end, timestamp)) {
+    skip_fraction(p, end);
+    skip_timezone(p, end);
+  } else {
+    *p = time_start;
+  }
+
+  return TRUE;
+}
+
+/* 2021/10/05 12:34:56 */
+static gboolean parse_slashed(const char **p, const char *end,
+                              LogviewTimestamp *timestamp) {
+  const char *time_start;
+
+  if (!parse_number(p, end, 4, &timestamp->year) || !parse_char(p, end, '/') ||
+      !parse_number(p, end, 2, &timestamp->month) ||
+      !parse_char(p, end, '/') || !parse_number(p, end, 2, &timestamp->day)) {
+    return FALSE;
+  }
+
+  time_start = *p;
+
+  if (parse_char(p, end, ' ') && parse_time(p, end, timestamp)) {
+    skip_fraction(p, end);
+  } else {
+    *p = time_start;
+  }
+
+  return TRUE;
+}
+
+/* [Tue Oct 05 12:34:56.789 2021], the brackets are optional */
+static gboolean parse_ctime(const char **p, const char *end,
+                            LogviewTimestamp *timestamp) {
+  gboolean bracket;
+
+  bracket = parse_char(p, end, '[');
+
+  if (parse_name(p, end, day_names) < 0 || !parse_char(p, end, ' ')) {
+    return FALSE;
+  }
+
+  timestamp->month = parse_name(p, end, month_names) + 1;
+
+  if (timestamp->month == 0 || !parse_char(p, end, ' ')) {
+    return FALSE;
+  }
+
+  parse_char(p, end, ' ');
+
+  if (!parse_day(p, end, &timestamp->day) || !parse_char(p, end, ' ') ||
+      !parse_time(p, end, timestamp)) {
+    return FALSE;
+  }
+
+  skip_fraction(p, end);
+
+  if (!parse_char(p, end, ' ') ||
+      !parse_number(p, end, 4, &timestamp->year)) {
+    return FALSE;
+  }
+
+  if (bracket) {
+    parse_char(p, end, ']');
+  }
+
+  return TRUE;
+}
+
+/**
+ * logview_timestamp_parse:
+ *
+ * @format: the format of the timestamp.
+ * @line: the text of the line, not NUL-terminated.
+ * @len: the length of @line.
+ * @timestamp: return location for the timestamp.
+ *
+ * Parses the timestamp at the start of @line.
+ *
+ * Returns: whether @line starts with a timestamp in @format.
+ */
+gboolean logview_timestamp_parse(LogviewTimestampFormat format,
+                                 const char *line, gsize len,
+                                 LogviewTimestamp *timestamp) {
+  const char *p = line, *end = line + len;
+  gboolean retval;
+
+  timestamp->year = 0;
+  timestamp->hour = -1;
+  timestamp->minute = timestamp->second = 0;
+
+  switch (format) {
+    case LOGVIEW_TIMESTAMP_SYSLOG:
+      retval = parse_syslog(&p, end, timestamp);
+      break;
+    case LOGVIEW_TIMESTAMP_ISO8601:
+      retval = parse_iso8601(&p, end, timestamp);
+      break;
+    case LOGVIEW_TIMESTAMP_SLASHED:
+      retval = parse_slashed(&p, end, timestamp);
+      break;
+    case LOGVIEW_TIMESTAMP_CTIME:
+      retval = parse_ctime(&p, end, timestamp);
+      break;
+    default:
+      retval = FALSE;
+      break;
+  }
+
+  if (!retval || timestamp->month < 1 || timestamp->month > 12 ||
+      timestamp->day < 1 || timestamp->day > 31) {
+    return FALSE;
+  }
+
+  timestamp->len = p - line;
+
+  return TRUE;
+}
+
+/* returns the format of the timestamp at the start of line, if any */
+LogviewTimestampFormat logview_timestamp_detect(const char *line, gsize len,
+                                                LogviewTimestamp *timestamp) {
+  LogviewTimestampFormat format;
+
+  for (format = LOGVIEW_TIMESTAMP_SYSLOG; format <= LOGVIEW_TIMESTAMP_CTIME;
+       format++) {
+    if (logview_timestamp_parse(format, line, len, timestamp)) {
+      return format;
+    }
+  }
+
+  return LOGVIEW_TIMESTAMP_UNKNOWN;
+}
@@ -0,0 +1,65 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* logview-timestamp.h */
+
+#ifndef __LOGVIEW_TIMESTAMP_H__
+#define __LOGVIEW_TIMESTAMP_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* the formats of the timestamps at the start of the lines */
+typedef enum {
+  LOGVIEW_TIMESTAMP_UNKNOWN,
+  /* Oct  5 12:34:56 */
+  LOGVIEW_TIMESTAMP_SYSLOG,
+  /* 2021-10-05T12:34:56.789+02:00, or with a space before the time */
+  LOGVIEW_TIMESTAMP_ISO8601,
+  /* 2021/10/05 12:34:56 */
+  LOGVIEW_TIMESTAMP_SLASHED,
+  /* [Tue Oct 05 12:34:56.789 2021] */
+  LOGVIEW_TIMESTAMP_CTIME
+} LogviewTimestampFormat;
+
+typedef struct {
+  /* 0 if the format has no year */
+  int year;
+  int month;
+  int day;
+
+  /* -1 if there's only a date */
+  int hour;
+  int minute;
+  int second;
+
+  /* the length of the timestamp at the start of the line */
+  gsize len;
+} LogviewTimestamp;
+
+LogviewTimestampFormat logview_timestamp_detect(const char *line, gsize len,
+                                                LogviewTimestamp *timestamp);
+gboolean logview_timestamp_parse(LogviewTimestampFormat format,
+                                 const char *line, gsize len,
+                                 LogviewTimestamp *timestamp);
+
+G_END_DECLS
+
+#endif /* __LOGVIEW_TIMESTAMP_H__ */
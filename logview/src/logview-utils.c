@@ -23,10 +23,7 @@
 #include <config.h>
 #endif
 
-#define _XOPEN_SOURCE
-#define _XOPEN_SOURCE_EXTENDED 1 /* strptime is XPG4v2 */
 #include <glib.h>
-#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -50,6 +47,7 @@ Day *logview_utils_day_copy(Day *day) {
   retval->first_line = day->first_line;
   retval->last_line = day->last_line;
   retval->timestamp_len = day->timestamp_len;
+  memcpy(retval->hour_lines, day->hour_lines, sizeof(day->hour_lines));
 
   return retval;
 }
@@ -64,206 +62,223 @@ GSList *logview_utils_day_list_copy(GSList *days) {
   return g_slist_reverse(retval);
 }
 
-gint days_compare(gconstpointer a, gconstpointer b) {
-  const Day *day1 = a, *day2 = b;
-
-  return g_date_compare(day1->date, day2->date);
+static void converter_free(gpointer converter) {
+  if (converter != (GIConv)-1) {
+    g_iconv_close(converter);
+  }
 }
 
-static GDate *string_get_date(const char *line, char **time_string,
-                              int *timestamp_len) {
-  GDate *date = NULL;
-  struct tm tp;
-  char *cp = NULL, *timestamp = NULL;
+/* from the locale charset, opened once in each thread */
+static GPrivate locale_converter = G_PRIVATE_INIT(converter_free);
 
-  /* it's safe to assume that if strptime returns NULL, it's
-   * because of an error (format unmatched). being a log file, it's very
-   * unlikely that there aren't any more characters after the date.
-   */
+/* returns a UTF-8 copy of a line that isn't valid UTF-8, which is
+ * most likely in the locale charset */
+char *logview_utils_line_to_utf8(const char *line, gsize len, gsize *out_len) {
+  GIConv converter;
+  const char *charset;
+  char *converted = NULL;
 
-  if (line == NULL || line[0] == '\0') {
-    return NULL;
+  /* there's nothing to convert from in a UTF-8 locale */
+  if (!g_get_charset(&charset)) {
+    converter = g_private_get(&locale_converter);
+
+    if (converter == NULL) {
+      converter = g_iconv_open("UTF-8", charset);
+      g_private_set(&locale_converter, converter);
+    }
+
+    if (converter != (GIConv)-1) {
+      converted = g_convert_with_iconv(line, (gssize)len, converter, NULL,
+                                       out_len, NULL);
+    }
   }
 
-  /* this parses the "MonthName DayNo" format */
-  cp = strptime(line, "%b %d", &tp);
-  if (cp) {
-    goto out;
+  if (converted == NULL) {
+    converted = g_utf8_make_valid(line, (gssize)len);
+    *out_len = strlen(converted);
   }
 
-  /* this parses the YYYY-MM-DD format */
-  cp = strptime(line, "%F", &tp);
-  if (cp) {
-    goto out;
+  return converted;
+}
+
+/* ranges are added in order, and merged with the last one */
+void logview_utils_line_ranges_add(GArray *ranges, guint first, guint last) {
+  LineRange *range, new_range = {first, last};
+
+  if (ranges->len > 0) {
+    range = &g_array_index(ranges, LineRange, ranges->len - 1);
+
+    if (range->last + 1 >= first) {
+      range->last = MAX(range->last, last);
+      return;
+    }
   }
 
-out:
-  if (cp) {
-    /* the year doesn't matter to us now */
-    date = g_date_new_dmy(tp.tm_mday, tp.tm_mon + 1, 1);
-    *time_string = g_strndup(line, cp - line);
+  g_array_append_val(ranges, new_range);
+}
+
+gboolean logview_utils_line_ranges_contain(GArray *ranges, guint line) {
+  LineRange *range;
+  guint low, high, mid;
+
+  low = 0;
+  high = ranges->len;
+
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    range = &g_array_index(ranges, LineRange, mid);
 
-    timestamp = strptime(cp, "%X", &tp);
-    if (timestamp) {
-      *timestamp_len = timestamp - line;
+    if (line < range->first) {
+      high = mid;
+    } else if (line > range->last) {
+      low = mid + 1;
+    } else {
+      return TRUE;
     }
   }
 
-  return date;
+  return FALSE;
+}
+
+gint days_compare(gconstpointer a, gconstpointer b) {
+  const Day *day1 = a, *day2 = b;
+
+  return g_date_compare(day1->date, day2->date);
+}
+
+static Day *day_new(const LogviewTimestamp *timestamp, int line) {
+  Day *day;
+  int hour;
+
+  day = g_slice_new0(Day);
+  day->first_line = line;
+  day->last_line = -1;
+  day->timestamp_len = timestamp->len;
+
+  for (hour = 0; hour < 24; hour++) {
+    day->hour_lines[hour] = -1;
+  }
+
+  return day;
 }
 
 /**
  * log_read_dates:
  *
- * @buffer_lines: an array of text lines.
+ * @get_line: returns the text of a line, not NUL-terminated.
+ * @user_data: the data passed to @get_line.
+ * @n: the number of lines.
  * @current: the mtime of the file being parsed.
+ * @format: the format of the timestamps, detected on the first one if
+ *   it's %LOGVIEW_TIMESTAMP_UNKNOWN, or %NULL.
  *
- * Reads all the dates inside the text buffer.
- * All dates are given with respect to the 1/1/1970
- * and are then corrected to the correct year once we
- * reach the end.
+ * Reads all the dates of the lines in a single pass. Lines without a
+ * timestamp, or with one older than the day before them, belong to
+ * that day. The years of timestamps without one are counted from the
+ * last day, which is assumed to be in the year of @current.
  *
- * Returns: a #GSList of #Day structures.
+ * Returns: a #GSList of #Day structures, in chronological order.
  */
 
-GSList *log_read_dates(const char **buffer_lines, time_t current) {
-  int current_year, offsetyear, i, n, rangemin, rangemax, timestamp_len = 0;
-  GSList *days = NULL;
-  GDate *date = NULL;
+GSList *log_read_dates(LogviewGetLineFunc get_line, gpointer user_data, int n,
+                       time_t current, LogviewTimestampFormat *format) {
+  LogviewTimestampFormat found = LOGVIEW_TIMESTAMP_UNKNOWN;
+  LogviewTimestamp timestamp;
+  GSList *days = NULL, *l;
+  GArray *keys;
+  Day *day = NULL;
   struct tm *tmptm;
-  char *date_string = NULL;
-  Day *day;
-  gboolean done = FALSE;
+  const char *line;
+  gsize len;
+  gboolean has_years = FALSE;
+  int i, key, last_key = -1, year = 0, offset = 0, d, m, y;
 
-  g_return_val_if_fail(buffer_lines != NULL, NULL);
+  g_return_val_if_fail(get_line != NULL, NULL);
 
-  n = g_strv_length((char **)buffer_lines);
+  if (format != NULL) {
+    found = *format;
+  }
 
-  tmptm = localtime(&current);
-  current_year = tmptm->tm_year + 1900;
-  offsetyear = 0;
+  /* year, month and day of each day as a number, e.g. 20211005 */
+  keys = g_array_new(FALSE, FALSE, sizeof(int));
 
-  /* find the first line with a date we're able to parse */
-  for (i = 0; buffer_lines[i]; i++) {
-    if ((date = string_get_date(buffer_lines[i], &date_string,
-                                &timestamp_len)) != NULL)
-      break;
-  }
+  for (i = 0; i < n; i++) {
+    line = get_line(user_data, i, &len);
 
-  if (!date) {
-    /* no valid dates in the array, return NULL */
-    return NULL;
-  }
+    if (found == LOGVIEW_TIMESTAMP_UNKNOWN) {
+      found = logview_timestamp_detect(line, len, &timestamp);
 
-  if (!g_date_valid(date)) {
-    g_date_free(date);
-    g_free(date_string);
-    return NULL;
-  }
+      if (found == LOGVIEW_TIMESTAMP_UNKNOWN) {
+        continue;
+      }
+    } else if (!logview_timestamp_parse(found, line, len, &timestamp)) {
+      continue;
+    }
 
-  g_date_set_year(date, current_year);
+    if (timestamp.year > 0) {
+      year = timestamp.year;
+      has_years = TRUE;
+    } else if (day != NULL && timestamp.month + 6 < last_key / 100 % 100) {
+      /* back from December to January */
+      year++;
+    }
 
-  day = g_slice_new0(Day);
-  days = g_slist_append(days, day);
+    key = (year * 100 + timestamp.month) * 100 + timestamp.day;
 
-  /* $i now contains the line number for the first good date */
-  day->date = date;
-  day->first_line = i;
-  day->last_line = -1;
-  day->timestamp_len = timestamp_len;
-
-  /* now scan the logfile to get the last line of the day */
-  rangemin = i;
-  rangemax = n - 1;
-
-  while (!done) {
-    /* find out the last line of the day we're currently building */
-
-    i = n - 1;
-
-    while (day->last_line < 0) {
-      if (strstr(buffer_lines[i], date_string)) {
-        /* if we find the same string on the last line of the log, we're done */
-        if (i == n - 1) {
-          done = TRUE;
-          day->last_line = i;
-          break;
-        }
-
-        /* we're still in a section of lines with the same date;
-         * - if the next one changes, then we're on the last.
-         * - else we keep searching in the following.
-         */
-
-        if (!strstr(buffer_lines[i + 1], date_string)) {
-          day->last_line = i;
-          break;
-        } else {
-          rangemin = i;
-          i = floor(((float)i + (float)rangemax) / 2.);
-        }
-      } else {
-        /* we can't find the same date here; go back to a safer range. */
-        rangemax = i;
-        i = floor(((float)rangemin + (float)i) / 2.);
+    if (key > last_key) {
+      if (day != NULL) {
+        day->last_line = i - 1;
       }
+
+      day = day_new(&timestamp, i);
+      days = g_slist_prepend(days, day);
+      g_array_append_val(keys, key);
+      last_key = key;
+    } else if (key < last_key) {
+      /* out of order, leave it to the current day */
+      continue;
     }
 
-    g_free(date_string);
-    date_string = NULL;
+    if (timestamp.hour >= 0 && day->hour_lines[timestamp.hour] < 0) {
+      day->hour_lines[timestamp.hour] = i;
+    }
+  }
 
-    if (!done) {
-      /* this means we finished the current day but we're not at the end
-       * of the buffer: reset the parameters for the next day.
-       */
-      GDate *newdate = NULL;
+  if (format != NULL) {
+    *format = found;
+  }
 
-      for (i = day->last_line + 1; buffer_lines[i]; i++) {
-        if ((newdate = string_get_date(buffer_lines[i], &date_string,
-                                       &timestamp_len)) != NULL)
-          break;
-      }
+  if (day == NULL) {
+    /* no valid dates in the lines */
+    g_array_free(keys, TRUE);
+    return NULL;
+  }
 
-      /* this will set the last line of the "old" log to either:
-       * - "n - 1" if we can't find another date
-       * - the line before the new date else.
-       */
-      day->last_line = i - 1;
-
-      if (newdate) {
-        /* append a new day to the list */
-
-        g_date_set_year(newdate, current_year + offsetyear);
-
-        if (g_date_compare(newdate, date) < 1) {
-          /* this isn't possible, as we're reading the log forward.
-           * so it means that newdate is the next year.
-           */
-          g_date_add_years(newdate, 1);
-          offsetyear++;
-        }
-
-        date = newdate;
-        day = g_slice_new0(Day);
-        days = g_slist_prepend(days, day);
-
-        day->date = date;
-        day->first_line = i;
-        day->last_line = -1;
-        day->timestamp_len = timestamp_len;
-        rangemin = i;
-        rangemax = n - 1;
-      } else {
-        /* no other date found */
-        done = TRUE;
-      }
+  day->last_line = n - 1;
+  days = g_slist_reverse(days);
+
+  if (!has_years) {
+    tmptm = localtime(&current);
+    offset = tmptm->tm_year + 1900 - year;
+
+    /* a last day after the mtime was in the year before */
+    if (last_key % 10000 > (tmptm->tm_mon + 1) * 100 + tmptm->tm_mday) {
+      offset--;
     }
   }
 
-  g_free(date_string);
+  for (l = days, i = 0; l != NULL; l = l->next, i++) {
+    key = g_array_index(keys, int, i);
+    day = l->data;
+
+    y = key / 10000 + offset;
+    m = key / 100 % 100;
+    d = MIN(key % 100, g_date_get_days_in_month(m, y));
+
+    day->date = g_date_new_dmy(d, m, y);
+  }
 
-  /* sort the days in chronological order */
-  days = g_slist_sort(days, days_compare);
+  g_array_free(keys, TRUE);
 
   return days;
 }
@@ -23,17 +23,36 @@
 
 #include <glib.h>
 
+#include "logview-timestamp.h"
+
 typedef struct {
   GDate *date;
   int first_line;
   int last_line;
   int timestamp_len;
+
+  /* the first line of each hour, -1 for the hours without lines */
+  int hour_lines[24];
 } Day;
 
-GSList *log_read_dates(const char **buffer_lines, time_t current);
+/* lines first to last, both included */
+typedef struct {
+  guint first;
+  guint last;
+} LineRange;
+
+/* returns the text of a line, which is not NUL-terminated */
+typedef const char *(*LogviewGetLineFunc)(gpointer user_data, int line,
+                                          gsize *len);
+
+GSList *log_read_dates(LogviewGetLineFunc get_line, gpointer user_data, int n,
+                       time_t current, LogviewTimestampFormat *format);
 gint days_compare(gconstpointer a, gconstpointer b);
 void logview_utils_day_free(Day *day);
 Day *logview_utils_day_copy(Day *day);
 GSList *logview_utils_day_list_copy(GSList *days);
+char *logview_utils_line_to_utf8(const char *line, gsize len, gsize *out_len);
+void logview_utils_line_ranges_add(GArray *ranges, guint first, guint last);
+gboolean logview_utils_line_ranges_contain(GArray *ranges, guint line);
 
 #endif /* __LOGVIEW_UTILS_H__ */
@@ -0,0 +1,1542 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gdk/gdkkeysyms.h>
+#include <glib/gi18n.h>
+#include <string.h>
+
+#include "logview-filter-engine.h"
+#include "logview-filter.h"
+#include "logview-finder.h"
+#include "logview-utils.h"
+#include "logview-view.h"
+
+/* The view draws the lines of a log straight from the log, only those
+ * in the visible area, so that its cost doesn't depend on the size of
+ * the log. Every line has the same height; when some lines are hidden
+ * (by a day selection or by the filters) the shown ones are listed in
+ * rows, otherwise row and line numbers are the same.
+ */
+
+#define TEXT_MARGIN 2
+
+enum {
+  PROP_0,
+  PROP_HADJUSTMENT,
+  PROP_VADJUSTMENT,
+  PROP_HSCROLL_POLICY,
+  PROP_VSCROLL_POLICY
+};
+
+/* a position in the log, the offset is in bytes of the shown text */
+typedef struct {
+  guint line;
+  gsize offset;
+} ViewPos;
+
+/* an active filter, with the style of its text tag */
+typedef struct {
+  LogviewFilter *filter;
+  GdkRGBA foreground;
+  GdkRGBA background;
+  gboolean foreground_set;
+  gboolean background_set;
+  gboolean invisible;
+} ViewFilter;
+
+typedef struct {
+  GdkRGBA dim;
+  GdkRGBA selected_fg;
+  GdkRGBA selected_bg;
+  GdkRGBA match_bg;
+} ViewColors;
+
+struct _LogviewViewPrivate {
+  GtkAdjustment *hadjustment;
+  GtkAdjustment *vadjustment;
+  guint hscroll_policy : 1;
+  guint vscroll_policy : 1;
+
+  LogviewLog *log;
+  guint n_lines;
+
+  /* the shown lines, NULL when all of them are */
+  GArray *rows;
+  int range_first;
+  int range_last;
+  GArray *filters;
+  gboolean matches_only;
+  gboolean has_invisible_filters;
+
+  /* matches the filters against the lines in other threads */
+  LogviewFilterEngine *engine;
+
+  /* the matches of the search, all highlighted */
+  LogviewFinder *finder;
+
+  /* lines from this one on were appended after the log was loaded */
+  guint bold_line;
+
+  ViewPos anchor;
+  ViewPos cursor;
+  gboolean dragging;
+
+  PangoLayout *layout;
+  int line_height;
+  int char_width;
+  int max_width;
+
+  /* the lines of a merged log start with the name of their log */
+  int tag_width;
+
+  /* the last line converted to UTF-8 */
+  char *scratch;
+};
+
+G_DEFINE_TYPE_WITH_CODE(LogviewView, logview_view, GTK_TYPE_WIDGET,
+                        G_ADD_PRIVATE(LogviewView)
+                            G_IMPLEMENT_INTERFACE(GTK_TYPE_SCROLLABLE, NULL));
+
+static void view_update_adjustments(LogviewView *view);
+
+/* rows */
+
+static gboolean view_filters_hide_lines(LogviewView *view) {
+  return view->priv->matches_only || view->priv->has_invisible_filters;
+}
+
+static gboolean view_hides_lines(LogviewView *view) {
+  return view->priv->range_first >= 0 || view_filters_hide_lines(view);
+}
+
+/* whether line matches the filter at position i, the engine might
+ * not have got there yet */
+static gboolean view_line_matches(LogviewView *view, guint i, guint line,
+                                  const char *text, gsize len) {
+  LogviewViewPrivate *priv = view->priv;
+  ViewFilter *vf;
+
+  if (line < logview_filter_engine_get_n_filtered(priv->engine)) {
+    return logview_filter_engine_get_match(priv->engine, i, line);
+  }
+
+  vf = &g_array_index(priv->filters, ViewFilter, i);
+
+  return logview_filter_filter(vf->filter, text, (gssize)len);
+}
+
+/* only for lines the engine is done with */
+static gboolean view_line_is_shown(LogviewView *view, guint line) {
+  LogviewViewPrivate *priv = view->priv;
+  gboolean matched = FALSE;
+  guint i;
+
+  if (!view_filters_hide_lines(view)) {
+    return TRUE;
+  }
+
+  for (i = 0; i < priv->filters->len; i++) {
+    if (logview_filter_engine_get_match(priv->engine, i, line)) {
+      if (g_array_index(priv->filters, ViewFilter, i).invisible) {
+        return FALSE;
+      }
+
+      matched = TRUE;
+    }
+  }
+
+  return matched || !priv->matches_only;
+}
+
+static void view_append_rows(LogviewView *view, guint first, guint end) {
+  LogviewViewPrivate *priv = view->priv;
+  guint line;
+
+  if (priv->range_first >= 0) {
+    first = MAX(first, (guint)priv->range_first);
+    end = MIN(end, (guint)priv->range_last + 1);
+  }
+
+  /* the rest is added as the engine goes on */
+  if (view_filters_hide_lines(view)) {
+    end = MIN(end, logview_filter_engine_get_n_filtered(priv->engine));
+  }
+
+  for (line = first; line < end; line++) {
+    if (view_line_is_shown(view, line)) {
+      g_array_append_val(priv->rows, line);
+    }
+  }
+}
+
+static void view_rebuild_rows(LogviewView *view) {
+  LogviewViewPrivate *priv = view->priv;
+
+  g_clear_pointer(&priv->rows, g_array_unref);
+
+  if (priv->log != NULL && view_hides_lines(view)) {
+    priv->rows = g_array_new(FALSE, FALSE, sizeof(guint));
+    view_append_rows(view, 0, priv->n_lines);
+  }
+
+  view_update_adjustments(view);
+  gtk_widget_queue_draw(GTK_WIDGET(view));
+}
+
+/* selection */
+
+static int view_pos_compare(const ViewPos *a, const ViewPos *b) {
+  if (a->line != b->line) {
+    return a->line < b->line ? -1 : 1;
+  }
+
+  if (a->offset != b->offset) {
+    return a->offset < b->offset ? -1 : 1;
+  }
+
+  return 0;
+}
+
+static gboolean view_get_selection_bounds(LogviewView *view, ViewPos *first,
+                                          ViewPos *last) {
+  LogviewViewPrivate *priv = view->priv;
+  int res;
+
+  res = view_pos_compare(&priv->anchor, &priv->cursor);
+
+  if (res == 0) {
+    return FALSE;
+  }
+
+  *first = (res < 0) ? priv->anchor : priv->cursor;
+  *last = (res < 0) ? priv->cursor : priv->anchor;
+
+  return TRUE;
+}
+
+/* the selected part of a line of length len; past_end is set if the
+ * selection goes on with the next line */
+static gboolean view_get_line_selection(LogviewView *view, guint line,
+                                        gsize len, gsize *start, gsize *end,
+                                        gboolean *past_end) {
+  ViewPos first, last;
+
+  if (!view_get_selection_bounds(view, &first, &last) || line < first.line ||
+      line > last.line) {
+    return FALSE;
+  }
+
+  *start = (line == first.line) ? MIN(first.offset, len) : 0;
+  *end = (line == last.line) ? MIN(last.offset, len) : len;
+  *past_end = (line < last.line);
+
+  return *start < *end || *past_end;
+}
+
+static char *view_get_selected_text(LogviewView *view) {
+  ViewPos first, last;
+  GString *str;
+  const char *text;
+  gsize len, start, end;
+  gboolean past_end;
+  guint row, n_rows, line;
+
+  if (!view_get_selection_bounds(view, &first, &last)) {
+    return NULL;
+  }
+
+  str = g_string_new(NULL);
+  n_rows = logview_view_get_n_rows(view);
+
+  for (row = logview_view_get_line_row(view, first.line); row < n_rows;
+       row++) {
+    line = logview_view_get_row_line(view, row);
+
+    if (line > last.line) {
+      break;
+    }
+
+    text = logview_view_get_line_text(view, line, &len);
+
+    if (view_get_line_selection(view, line, len, &start, &end, &past_end)) {
+      g_string_append_len(str, text + start, end - start);
+
+      if (past_end) {
+        g_string_append_c(str, '\n');
+      }
+    }
+  }
+
+  return g_string_free(str, FALSE);
+}
+
+static gboolean is_word_char(gunichar c) {
+  return g_unichar_isalnum(c) || c == '_';
+}
+
+static void view_select_word(LogviewView *view, const ViewPos *pos) {
+  LogviewViewPrivate *priv = view->priv;
+  const char *text, *p;
+  gsize len, start, end;
+
+  text = logview_view_get_line_text(view, pos->line, &len);
+  start = end = MIN(pos->offset, len);
+
+  while (start > 0) {
+    p = g_utf8_find_prev_char(text, text + start);
+
+    if (p == NULL || !is_word_char(g_utf8_get_char(p))) {
+      break;
+    }
+
+    start = p - text;
+  }
+
+  while (end < len && is_word_char(g_utf8_get_char(text + end))) {
+    end = g_utf8_next_char(text + end) - text;
+  }
+
+  priv->anchor.line = priv->cursor.line = pos->line;
+  priv->anchor.offset = start;
+  priv->cursor.offset = end;
+}
+
+/* scrolling */
+
+static void view_update_adjustments(LogviewView *view) {
+  LogviewViewPrivate *priv = view->priv;
+  GtkAllocation allocation;
+  gdouble upper;
+
+  gtk_widget_get_allocation(GTK_WIDGET(view), &allocation);
+
+  if (priv->vadjustment != NULL) {
+    upper = MAX((gdouble)logview_view_get_n_rows(view) * priv->line_height,
+                allocation.height);
+    gtk_adjustment_configure(
+        priv->vadjustment,
+        CLAMP(gtk_adjustment_get_value(priv->vadjustment), 0,
+              upper - allocation.height),
+        0, upper, priv->line_height,
+        MAX(allocation.height - priv->line_height, priv->line_height),
+        allocation.height);
+  }
+
+  if (priv->hadjustment != NULL) {
+    upper = MAX(priv->max_width + priv->tag_width + 2 * TEXT_MARGIN,
+                allocation.width);
+    gtk_adjustment_configure(
+        priv->hadjustment,
+        CLAMP(gtk_adjustment_get_value(priv->hadjustment), 0,
+              upper - allocation.width),
+        0, upper, priv->char_width, allocation.width / 2.0, allocation.width);
+  }
+}
+
+static void view_scroll_to_row(LogviewView *view, guint row) {
+  GtkAdjustment *adj = view->priv->vadjustment;
+  gdouble y, value, page;
+
+  if (adj == NULL) {
+    return;
+  }
+
+  y = (gdouble)row * view->priv->line_height;
+  value = gtk_adjustment_get_value(adj);
+  page = gtk_adjustment_get_page_size(adj);
+
+  if (y < value) {
+    gtk_adjustment_set_value(adj, y);
+  } else if (y + view->priv->line_height > value + page) {
+    gtk_adjustment_set_value(adj, y + view->priv->line_height - page);
+  }
+}
+
+static void view_scroll_to_x(LogviewView *view, int x_start, int x_end) {
+  GtkAdjustment *adj = view->priv->hadjustment;
+  gdouble value, page;
+
+  if (adj == NULL) {
+    return;
+  }
+
+  value = gtk_adjustment_get_value(adj);
+  page = gtk_adjustment_get_page_size(adj);
+
+  if (x_end > value + page) {
+    value = x_end - page + TEXT_MARGIN;
+  }
+
+  if (x_start < value) {
+    value = x_start - TEXT_MARGIN;
+  }
+
+  gtk_adjustment_set_value(adj, value);
+}
+
+static void view_scroll_by(GtkAdjustment *adj, gdouble delta) {
+  if (adj != NULL) {
+    gtk_adjustment_set_value(adj, gtk_adjustment_get_value(adj) + delta);
+  }
+}
+
+static void adjustment_value_changed_cb(GtkAdjustment *adjustment,
+                                        gpointer user_data) {
+  gtk_widget_queue_draw(GTK_WIDGET(user_data));
+}
+
+static void view_set_adjustment(LogviewView *view, GtkAdjustment **slot,
+                                GtkAdjustment *adjustment) {
+  if (adjustment != NULL && *slot == adjustment) {
+    return;
+  }
+
+  if (*slot != NULL) {
+    g_signal_handlers_disconnect_by_func(
+        *slot, G_CALLBACK(adjustment_value_changed_cb), view);
+    g_object_unref(*slot);
+  }
+
+  if (adjustment == NULL) {
+    adjustment = gtk_adjustment_new(0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+  }
+
+  *slot = g_object_ref_sink(adjustment);
+  g_signal_connect(adjustment, "value-changed",
+                   G_CALLBACK(adjustment_value_changed_cb), view);
+
+  view_update_adjustments(view);
+}
+
+/* drawing */
+
+static void view_update_tag_width(LogviewView *view) {
+  LogviewViewPrivate *priv = view->priv;
+  GList *sources, *l;
+  int width;
+
+  priv->tag_width = 0;
+
+  if (priv->log == NULL) {
+    return;
+  }
+
+  sources = logview_log_get_sources(priv->log);
+
+  for (l = sources; l != NULL; l = l->next) {
+    pango_layout_set_text(priv->layout, logview_log_get_display_name(l->data),
+                          -1);
+    pango_layout_get_pixel_size(priv->layout, &width, NULL);
+    priv->tag_width = MAX(priv->tag_width, width + 2 * priv->char_width);
+  }
+
+  g_list_free(sources);
+}
+
+static void view_update_metrics(LogviewView *view) {
+  LogviewViewPrivate *priv = view->priv;
+
+  g_clear_object(&priv->layout);
+  priv->layout = gtk_widget_create_pango_layout(GTK_WIDGET(view), "X");
+  pango_layout_get_pixel_size(priv->layout, &priv->char_width,
+                              &priv->line_height);
+  priv->line_height = MAX(priv->line_height, 1);
+
+  /* the widths are measured again as lines are drawn */
+  priv->max_width = 0;
+  view_update_tag_width(view);
+
+  view_update_adjustments(view);
+}
+
+static void view_get_colors(LogviewView *view, ViewColors *colors) {
+  GtkStyleContext *context;
+  GtkStateFlags state;
+  GdkRGBA *background;
+
+  context = gtk_widget_get_style_context(GTK_WIDGET(view));
+  state = gtk_widget_get_state_flags(GTK_WIDGET(view));
+
+  gtk_style_context_save(context);
+  gtk_style_context_add_class(context, "dim-label");
+  gtk_style_context_get_color(context, state, &colors->dim);
+  gtk_style_context_restore(context);
+
+  state |= GTK_STATE_FLAG_SELECTED;
+
+  gtk_style_context_save(context);
+  gtk_style_context_set_state(context, state);
+  gtk_style_context_get_color(context, state, &colors->selected_fg);
+  gtk_style_context_get(context, state, GTK_STYLE_PROPERTY_BACKGROUND_COLOR,
+                        &background, NULL);
+  colors->selected_bg = *background;
+  gdk_rgba_free(background);
+  gtk_style_context_restore(context);
+
+  colors->match_bg = colors->selected_bg;
+  colors->match_bg.alpha *= 0.4;
+}
+
+static void add_color_attr(PangoAttrList *attrs, const GdkRGBA *color,
+                           guint start, guint end) {
+  PangoAttribute *attr;
+
+  attr = pango_attr_foreground_new(color->red * 65535, color->green * 65535,
+                                   color->blue * 65535);
+  attr->start_index = start;
+  attr->end_index = end;
+  pango_attr_list_insert(attrs, attr);
+}
+
+/* the rows are drawn in the order of their lines, as are the days, so
+ * days is moved along instead of being searched from its start for each
+ * row */
+static Day *find_day(GSList **days, guint line) {
+  Day *day;
+
+  while (*days != NULL) {
+    day = (*days)->data;
+
+    if ((int)line <= day->last_line) {
+      return ((int)line >= day->first_line) ? day : NULL;
+    }
+
+    *days = (*days)->next;
+  }
+
+  return NULL;
+}
+
+static void view_draw_ranges(LogviewView *view, cairo_t *cr, int x, int y,
+                             gsize start, gsize end) {
+  LogviewViewPrivate *priv = view->priv;
+  int *ranges, n_ranges, i;
+
+  pango_layout_line_get_x_ranges(
+      pango_layout_get_line_readonly(priv->layout, 0), (int)start, (int)end,
+      &ranges, &n_ranges);
+
+  for (i = 0; i < n_ranges; i++) {
+    cairo_rectangle(cr, x + ranges[2 * i] / PANGO_SCALE, y,
+                    (ranges[2 * i + 1] - ranges[2 * i]) / PANGO_SCALE,
+                    priv->line_height);
+  }
+
+  g_free(ranges);
+}
+
+static void view_draw_tag(LogviewView *view, cairo_t *cr,
+                          const ViewColors *colors, guint line, int x, int y) {
+  LogviewViewPrivate *priv = view->priv;
+  PangoAttrList *attrs;
+  LogviewLog *source;
+
+  source = logview_log_get_line_source(priv->log, line);
+
+  if (source == NULL) {
+    return;
+  }
+
+  attrs = pango_attr_list_new();
+  add_color_attr(attrs, &colors->dim, 0, G_MAXUINT);
+
+  pango_layout_set_text(priv->layout, logview_log_get_display_name(source), -1);
+  pango_layout_set_attributes(priv->layout, attrs);
+  pango_attr_list_unref(attrs);
+
+  gtk_render_layout(gtk_widget_get_style_context(GTK_WIDGET(view)), cr, x, y,
+                    priv->layout);
+  pango_layout_set_attributes(priv->layout, NULL);
+}
+
+static void view_draw_line(LogviewView *view, cairo_t *cr,
+                           const ViewColors *colors, GSList **days,
+                           guint line, int x, int y, int width) {
+  LogviewViewPrivate *priv = view->priv;
+  PangoAttrList *attrs;
+  PangoAttribute *attr;
+  const GdkRGBA *background = NULL;
+  const LogviewMatch *matches;
+  const char *text;
+  gsize len, sel_start, sel_end;
+  gboolean selected, past_end;
+  int line_width;
+  Day *day;
+  guint n_matches, j;
+
+  text = logview_view_get_line_text(view, line, &len);
+  attrs = pango_attr_list_new();
+
+  /* the style of a line: gray timestamp, then the filters colors, bold
+   * if the line is new, and the selection over everything */
+  day = find_day(days, line);
+  if (day != NULL && day->timestamp_len > 0) {
+    add_color_attr(attrs, &colors->dim, 0, MIN((gsize)day->timestamp_len, len));
+  }
+
+  for (j = 0; j < priv->filters->len; j++) {
+    ViewFilter *vf = &g_array_index(priv->filters, ViewFilter, j);
+
+    if (!view_line_matches(view, j, line, text, len)) {
+      continue;
+    }
+
+    if (vf->foreground_set) {
+      add_color_attr(attrs, &vf->foreground, 0, len);
+    }
+
+    if (vf->background_set) {
+      background = &vf->background;
+    }
+  }
+
+  if (line >= priv->bold_line) {
+    attr = pango_attr_weight_new(PANGO_WEIGHT_BOLD);
+    pango_attr_list_insert(attrs, attr);
+  }
+
+  selected = view_get_line_selection(view, line, len, &sel_start, &sel_end,
+                                     &past_end);
+  if (selected) {
+    add_color_attr(attrs, &colors->selected_fg, sel_start, sel_end);
+  }
+
+  pango_layout_set_text(priv->layout, text, (int)len);
+  pango_layout_set_attributes(priv->layout, attrs);
+  pango_attr_list_unref(attrs);
+
+  if (background != NULL) {
+    gdk_cairo_set_source_rgba(cr, background);
+    cairo_rectangle(cr, 0, y, width, priv->line_height);
+    cairo_fill(cr);
+  }
+
+  pango_layout_get_pixel_size(priv->layout, &line_width, NULL);
+
+  /* all the matches of the search, then the selection over them */
+  matches = logview_finder_get_line_matches(priv->finder, line, &n_matches);
+
+  if (n_matches > 0) {
+    gdk_cairo_set_source_rgba(cr, &colors->match_bg);
+
+    for (j = 0; j < n_matches; j++) {
+      view_draw_ranges(view, cr, x, y, MIN(matches[j].start, len),
+                       MIN(matches[j].end, len));
+    }
+
+    cairo_fill(cr);
+  }
+
+  if (selected) {
+    gdk_cairo_set_source_rgba(cr, &colors->selected_bg);
+    view_draw_ranges(view, cr, x, y, sel_start, sel_end);
+
+    if (past_end) {
+      cairo_rectangle(cr, x + line_width, y, MAX(width - x - line_width, 0),
+                      priv->line_height);
+    }
+
+    cairo_fill(cr);
+  }
+
+  gtk_render_layout(gtk_widget_get_style_context(GTK_WIDGET(view)), cr, x, y,
+                    priv->layout);
+  pango_layout_set_attributes(priv->layout, NULL);
+
+  if (priv->tag_width > 0) {
+    view_draw_tag(view, cr, colors, line, x - priv->tag_width, y);
+  }
+
+  if (line_width > priv->max_width) {
+    priv->max_width = line_width;
+
+    if (priv->hadjustment != NULL &&
+        gtk_adjustment_get_upper(priv->hadjustment) <
+            line_width + priv->tag_width + 2 * TEXT_MARGIN) {
+      gtk_adjustment_set_upper(priv->hadjustment,
+                               line_width + priv->tag_width + 2 * TEXT_MARGIN);
+    }
+  }
+}
+
+static gboolean logview_view_draw(GtkWidget *widget, cairo_t *cr) {
+  LogviewView *view = LOGVIEW_VIEW(widget);
+  LogviewViewPrivate *priv = view->priv;
+  ViewColors colors;
+  GSList *days;
+  gdouble x_offset, y_offset;
+  guint row, n_rows;
+  int width, height, y;
+
+  width = gtk_widget_get_allocated_width(widget);
+  height = gtk_widget_get_allocated_height(widget);
+
+  gtk_render_background(gtk_widget_get_style_context(widget), cr, 0, 0, width,
+                        height);
+
+  if (priv->log == NULL) {
+    return FALSE;
+  }
+
+  view_get_colors(view, &colors);
+  days = logview_log_get_days_for_cached_lines(priv->log);
+
+  x_offset = priv->hadjustment ? gtk_adjustment_get_value(priv->hadjustment)
+                               : 0.0;
+  y_offset = priv->vadjustment ? gtk_adjustment_get_value(priv->vadjustment)
+                               : 0.0;
+  n_rows = logview_view_get_n_rows(view);
+
+  /* only the rows in the visible area are drawn */
+  for (row = (guint)(y_offset / priv->line_height); row < n_rows; row++) {
+    y = (int)((gdouble)row * priv->line_height - y_offset);
+
+    if (y >= height) {
+      break;
+    }
+
+    view_draw_line(view, cr, &colors, &days,
+                   logview_view_get_row_line(view, row),
+                   TEXT_MARGIN + priv->tag_width - (int)x_offset, y, width);
+  }
+
+  return FALSE;
+}
+
+/* events */
+
+static gboolean view_get_pos_at_coords(LogviewView *view, gdouble x,
+                                       gdouble y, ViewPos *pos) {
+  LogviewViewPrivate *priv = view->priv;
+  const char *text;
+  gsize len;
+  guint n_rows;
+  gdouble row;
+  int index, trailing;
+
+  n_rows = logview_view_get_n_rows(view);
+
+  if (priv->log == NULL || n_rows == 0) {
+    return FALSE;
+  }
+
+  if (priv->vadjustment != NULL) {
+    y += gtk_adjustment_get_value(priv->vadjustment);
+  }
+
+  if (priv->hadjustment != NULL) {
+    x += gtk_adjustment_get_value(priv->hadjustment);
+  }
+
+  row = CLAMP(y / priv->line_height, 0, n_rows - 1);
+  pos->line = logview_view_get_row_line(view, (guint)row);
+
+  text = logview_view_get_line_text(view, pos->line, &len);
+  pango_layout_set_text(priv->layout, text, (int)len);
+  pango_layout_xy_to_index(
+      priv->layout, (int)((x - TEXT_MARGIN - priv->tag_width) * PANGO_SCALE), 0,
+      &index, &trailing);
+
+  pos->offset = index;
+
+  while (trailing-- > 0 && pos->offset < len) {
+    pos->offset = g_utf8_next_char(text + pos->offset) - text;
+  }
+
+  return TRUE;
+}
+
+static void copy_activate_cb(GtkMenuItem *item, LogviewView *view) {
+  GtkClipboard *clipboard;
+
+  clipboard =
+      gtk_widget_get_clipboard(GTK_WIDGET(view), GDK_SELECTION_CLIPBOARD);
+  logview_view_copy_clipboard(view, clipboard);
+}
+
+static void select_all_activate_cb(GtkMenuItem *item, LogviewView *view) {
+  logview_view_select_all(view);
+}
+
+static void view_popup_menu(LogviewView *view, GdkEvent *event) {
+  GtkWidget *menu, *item;
+  ViewPos first, last;
+
+  menu = gtk_menu_new();
+  gtk_menu_attach_to_widget(GTK_MENU(menu), GTK_WIDGET(view), NULL);
+
+  item = gtk_menu_item_new_with_mnemonic(_("_Copy"));
+  gtk_widget_set_sensitive(item,
+                           view_get_selection_bounds(view, &first, &last));
+  g_signal_connect(item, "activate", G_CALLBACK(copy_activate_cb), view);
+  gtk_menu_shell_append(GTK_MENU_SHELL(menu), item);
+
+  item = gtk_menu_item_new_with_mnemonic(_("Select _All"));
+  g_signal_connect(item, "activate", G_CALLBACK(select_all_activate_cb), view);
+  gtk_menu_shell_append(GTK_MENU_SHELL(menu), item);
+
+  gtk_widget_show_all(menu);
+  g_signal_connect(menu, "deactivate", G_CALLBACK(gtk_widget_destroy), NULL);
+  gtk_menu_popup_at_pointer(GTK_MENU(menu), event);
+}
+
+static gboolean logview_view_button_press(GtkWidget *widget,
+                                          GdkEventButton *event) {
+  LogviewView *view = LOGVIEW_VIEW(widget);
+  LogviewViewPrivate *priv = view->priv;
+  ViewPos pos;
+
+  if (!gtk_widget_has_focus(widget)) {
+    gtk_widget_grab_focus(widget);
+  }
+
+  if (gdk_event_triggers_context_menu((GdkEvent *)event)) {
+    view_popup_menu(view, (GdkEvent *)event);
+    return TRUE;
+  }
+
+  if (event->button != GDK_BUTTON_PRIMARY ||
+      !view_get_pos_at_coords(view, event->x, event->y, &pos)) {
+    return FALSE;
+  }
+
+  if (event->type == GDK_2BUTTON_PRESS) {
+    view_select_word(view, &pos);
+  } else if (event->type == GDK_3BUTTON_PRESS) {
+    logview_view_get_line_text(view, pos.line, &pos.offset);
+    priv->cursor = pos;
+    priv->anchor.line = pos.line;
+    priv->anchor.offset = 0;
+  } else {
+    priv->cursor = pos;
+
+    if (!(event->state & GDK_SHIFT_MASK)) {
+      priv->anchor = pos;
+    }
+
+    priv->dragging = TRUE;
+  }
+
+  gtk_widget_queue_draw(widget);
+
+  return TRUE;
+}
+
+static gboolean logview_view_motion_notify(GtkWidget *widget,
+                                           GdkEventMotion *event) {
+  LogviewView *view = LOGVIEW_VIEW(widget);
+  LogviewViewPrivate *priv = view->priv;
+
+  if (!priv->dragging) {
+    return FALSE;
+  }
+
+  /* scroll while dragging out of the view */
+  if (event->y < 0) {
+    view_scroll_by(priv->vadjustment, -priv->line_height);
+  } else if (event->y > gtk_widget_get_allocated_height(widget)) {
+    view_scroll_by(priv->vadjustment, priv->line_height);
+  }
+
+  if (view_get_pos_at_coords(view, event->x, event->y, &priv->cursor)) {
+    gtk_widget_queue_draw(widget);
+  }
+
+  return TRUE;
+}
+
+static gboolean logview_view_button_release(GtkWidget *widget,
+                                            GdkEventButton *event) {
+  LogviewView *view = LOGVIEW_VIEW(widget);
+  char *text;
+
+  if (event->button != GDK_BUTTON_PRIMARY) {
+    return FALSE;
+  }
+
+  view->priv->dragging = FALSE;
+
+  if ((text = view_get_selected_text(view)) != NULL) {
+    gtk_clipboard_set_text(
+        gtk_widget_get_clipboard(widget, GDK_SELECTION_PRIMARY), text, -1);
+    g_free(text);
+  }
+
+  return TRUE;
+}
+
+static gboolean logview_view_key_press(GtkWidget *widget, GdkEventKey *event) {
+  LogviewViewPrivate *priv = LOGVIEW_VIEW(widget)->priv;
+  GtkAdjustment *vadj = priv->vadjustment, *hadj = priv->hadjustment;
+
+  if (vadj == NULL || hadj == NULL) {
+    return FALSE;
+  }
+
+  switch (event->keyval) {
+    case GDK_KEY_Up:
+    case GDK_KEY_KP_Up:
+      view_scroll_by(vadj, -gtk_adjustment_get_step_increment(vadj));
+      return TRUE;
+    case GDK_KEY_Down:
+    case GDK_KEY_KP_Down:
+      view_scroll_by(vadj, gtk_adjustment_get_step_increment(vadj));
+      return TRUE;
+    case GDK_KEY_Page_Up:
+    case GDK_KEY_KP_Page_Up:
+      view_scroll_by(vadj, -gtk_adjustment_get_page_increment(vadj));
+      return TRUE;
+    case GDK_KEY_Page_Down:
+    case GDK_KEY_KP_Page_Down:
+      view_scroll_by(vadj, gtk_adjustment_get_page_increment(vadj));
+      return TRUE;
+    case GDK_KEY_Home:
+    case GDK_KEY_KP_Home:
+      gtk_adjustment_set_value(vadj, gtk_adjustment_get_lower(vadj));
+      return TRUE;
+    case GDK_KEY_End:
+    case GDK_KEY_KP_End:
+      gtk_adjustment_set_value(vadj, gtk_adjustment_get_upper(vadj));
+      return TRUE;
+    case GDK_KEY_Left:
+    case GDK_KEY_KP_Left:
+      view_scroll_by(hadj, -gtk_adjustment_get_step_increment(hadj));
+      return TRUE;
+    case GDK_KEY_Right:
+    case GDK_KEY_KP_Right:
+      view_scroll_by(hadj, gtk_adjustment_get_step_increment(hadj));
+      return TRUE;
+    default:
+      break;
+  }
+
+  return GTK_WIDGET_CLASS(logview_view_parent_class)
+      ->key_press_event(widget, event);
+}
+
+/* GtkWidget functions */
+
+static void logview_view_realize(GtkWidget *widget) {
+  GdkWindowAttr attributes;
+  gint attributes_mask;
+  GtkAllocation allocation;
+  GdkWindow *window;
+
+  gtk_widget_set_realized(widget, TRUE);
+
+  gtk_widget_get_allocation(widget, &allocation);
+
+  attributes.window_type = GDK_WINDOW_CHILD;
+  attributes.x = allocation.x;
+  attributes.y = allocation.y;
+  attributes.width = allocation.width;
+  attributes.height = allocation.height;
+  attributes.wclass = GDK_INPUT_OUTPUT;
+  attributes.visual = gtk_widget_get_visual(widget);
+  attributes.event_mask =
+      gtk_widget_get_events(widget) | GDK_EXPOSURE_MASK |
+      GDK_BUTTON_PRESS_MASK | GDK_BUTTON_RELEASE_MASK | GDK_BUTTON1_MOTION_MASK;
+  attributes.cursor =
+      gdk_cursor_new_from_name(gtk_widget_get_display(widget), "text");
+
+  attributes_mask = GDK_WA_X | GDK_WA_Y | GDK_WA_VISUAL;
+
+  if (attributes.cursor != NULL) {
+    attributes_mask |= GDK_WA_CURSOR;
+  }
+
+  window = gdk_window_new(gtk_widget_get_parent_window(widget), &attributes,
+                          attributes_mask);
+  gtk_widget_set_window(widget, window);
+  gdk_window_set_user_data(window, widget);
+
+  g_clear_object(&attributes.cursor);
+}
+
+static void logview_view_size_allocate(GtkWidget *widget,
+                                       GtkAllocation *allocation) {
+  gtk_widget_set_allocation(widget, allocation);
+
+  if (gtk_widget_get_realized(widget)) {
+    gdk_window_move_resize(gtk_widget_get_window(widget), allocation->x,
+                           allocation->y, allocation->width,
+                           allocation->height);
+  }
+
+  view_update_adjustments(LOGVIEW_VIEW(widget));
+}
+
+static void logview_view_style_updated(GtkWidget *widget) {
+  GTK_WIDGET_CLASS(logview_view_parent_class)->style_updated(widget);
+
+  /* the font might have changed */
+  view_update_metrics(LOGVIEW_VIEW(widget));
+}
+
+/* GObject functions */
+
+static void logview_view_set_property(GObject *object, guint prop_id,
+                                      const GValue *value,
+                                      GParamSpec *pspec) {
+  LogviewView *view = LOGVIEW_VIEW(object);
+  LogviewViewPrivate *priv = view->priv;
+
+  switch (prop_id) {
+    case PROP_HADJUSTMENT:
+      view_set_adjustment(view, &priv->hadjustment, g_value_get_object(value));
+      break;
+    case PROP_VADJUSTMENT:
+      view_set_adjustment(view, &priv->vadjustment, g_value_get_object(value));
+      break;
+    case PROP_HSCROLL_POLICY:
+      priv->hscroll_policy = g_value_get_enum(value);
+      gtk_widget_queue_resize(GTK_WIDGET(view));
+      break;
+    case PROP_VSCROLL_POLICY:
+      priv->vscroll_policy = g_value_get_enum(value);
+      gtk_widget_queue_resize(GTK_WIDGET(view));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+      break;
+  }
+}
+
+static void logview_view_get_property(GObject *object, guint prop_id,
+                                      GValue *value, GParamSpec *pspec) {
+  LogviewViewPrivate *priv = LOGVIEW_VIEW(object)->priv;
+
+  switch (prop_id) {
+    case PROP_HADJUSTMENT:
+      g_value_set_object(value, priv->hadjustment);
+      break;
+    case PROP_VADJUSTMENT:
+      g_value_set_object(value, priv->vadjustment);
+      break;
+    case PROP_HSCROLL_POLICY:
+      g_value_set_enum(value, priv->hscroll_policy);
+      break;
+    case PROP_VSCROLL_POLICY:
+      g_value_set_enum(value, priv->vscroll_policy);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+      break;
+  }
+}
+
+static void engine_lines_filtered_cb(LogviewFilterEngine *engine,
+                                     guint first_line, guint n_lines,
+                                     gpointer user_data) {
+  LogviewView *view = user_data;
+
+  if (view->priv->rows != NULL && view_filters_hide_lines(view)) {
+    view_append_rows(view, first_line, first_line + n_lines);
+    view_update_adjustments(view);
+  }
+
+  gtk_widget_queue_draw(GTK_WIDGET(view));
+}
+
+static void finder_progress_cb(LogviewFinder *finder, gpointer user_data) {
+  gtk_widget_queue_draw(GTK_WIDGET(user_data));
+}
+
+static void view_restart_filtering(LogviewView *view) {
+  LogviewViewPrivate *priv = view->priv;
+  GList *filters = NULL;
+  guint i;
+
+  if (priv->log == NULL || priv->filters->len == 0) {
+    logview_filter_engine_stop(priv->engine);
+    return;
+  }
+
+  for (i = priv->filters->len; i > 0; i--) {
+    filters = g_list_prepend(
+        filters, g_array_index(priv->filters, ViewFilter, i - 1).filter);
+  }
+
+  logview_filter_engine_start(priv->engine, priv->log, filters, priv->n_lines);
+  g_list_free(filters);
+}
+
+static void view_clear_filters(LogviewView *view) {
+  GArray *filters = view->priv->filters;
+  guint i;
+
+  for (i = 0; i < filters->len; i++) {
+    g_object_unref(g_array_index(filters, ViewFilter, i).filter);
+  }
+
+  g_array_set_size(filters, 0);
+  view->priv->has_invisible_filters = FALSE;
+}
+
+static void logview_view_dispose(GObject *object) {
+  LogviewView *view = LOGVIEW_VIEW(object);
+  LogviewViewPrivate *priv = view->priv;
+
+  if (priv->hadjustment != NULL) {
+    g_signal_handlers_disconnect_by_func(
+        priv->hadjustment, G_CALLBACK(adjustment_value_changed_cb), view);
+    g_clear_object(&priv->hadjustment);
+  }
+
+  if (priv->vadjustment != NULL) {
+    g_signal_handlers_disconnect_by_func(
+        priv->vadjustment, G_CALLBACK(adjustment_value_changed_cb), view);
+    g_clear_object(&priv->vadjustment);
+  }
+
+  if (priv->filters != NULL) {
+    view_clear_filters(view);
+  }
+
+  if (priv->engine != NULL) {
+    g_signal_handlers_disconnect_by_func(
+        priv->engine, G_CALLBACK(engine_lines_filtered_cb), view);
+    logview_filter_engine_stop(priv->engine);
+    g_clear_object(&priv->engine);
+  }
+
+  if (priv->finder != NULL) {
+    g_signal_handlers_disconnect_by_func(
+        priv->finder, G_CALLBACK(finder_progress_cb), view);
+    logview_finder_stop(priv->finder);
+    g_clear_object(&priv->finder);
+  }
+
+  g_clear_object(&priv->log);
+  g_clear_object(&priv->layout);
+  g_clear_pointer(&priv->rows, g_array_unref);
+
+  G_OBJECT_CLASS(logview_view_parent_class)->dispose(object);
+}
+
+static void logview_view_finalize(GObject *object) {
+  LogviewViewPrivate *priv = LOGVIEW_VIEW(object)->priv;
+
+  g_array_free(priv->filters, TRUE);
+  g_free(priv->scratch);
+
+  G_OBJECT_CLASS(logview_view_parent_class)->finalize(object);
+}
+
+static void logview_view_class_init(LogviewViewClass *klass) {
+  GObjectClass *object_class = G_OBJECT_CLASS(klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS(klass);
+
+  object_class->set_property = logview_view_set_property;
+  object_class->get_property = logview_view_get_property;
+  object_class->dispose = logview_view_dispose;
+  object_class->finalize = logview_view_finalize;
+
+  widget_class->realize = logview_view_realize;
+  widget_class->size_allocate = logview_view_size_allocate;
+  widget_class->style_updated = logview_view_style_updated;
+  widget_class->draw = logview_view_draw;
+  widget_class->button_press_event = logview_view_button_press;
+  widget_class->button_release_event = logview_view_button_release;
+  widget_class->motion_notify_event = logview_view_motion_notify;
+  widget_class->key_press_event = logview_view_key_press;
+
+  g_object_class_override_property(object_class, PROP_HADJUSTMENT,
+                                   "hadjustment");
+  g_object_class_override_property(object_class, PROP_VADJUSTMENT,
+                                   "vadjustment");
+  g_object_class_override_property(object_class, PROP_HSCROLL_POLICY,
+                                   "hscroll-policy");
+  g_object_class_override_property(object_class, PROP_VSCROLL_POLICY,
+                                   "vscroll-policy");
+}
+
+static void logview_view_init(LogviewView *view) {
+  LogviewViewPrivate *priv;
+
+  priv = view->priv = logview_view_get_instance_private(view);
+
+  priv->filters = g_array_new(FALSE, FALSE, sizeof(ViewFilter));
+  priv->range_first = priv->range_last = -1;
+  priv->bold_line = G_MAXUINT;
+
+  priv->engine = logview_filter_engine_new();
+  g_signal_connect(priv->engine, "lines-filtered",
+                   G_CALLBACK(engine_lines_filtered_cb), view);
+
+  priv->finder = logview_finder_new();
+  g_signal_connect(priv->finder, "progress", G_CALLBACK(finder_progress_cb),
+                   view);
+
+  gtk_widget_set_can_focus(GTK_WIDGET(view), TRUE);
+  gtk_style_context_add_class(gtk_widget_get_style_context(GTK_WIDGET(view)),
+                              GTK_STYLE_CLASS_VIEW);
+
+  view_update_metrics(view);
+}
+
+/* public methods */
+
+GtkWidget *logview_view_new(void) {
+  return g_object_new(LOGVIEW_TYPE_VIEW, NULL);
+}
+
+/* shows the lines of log, this only costs the lines that are visible;
+ * the filters are matched in the background */
+void logview_view_set_log(LogviewView *view, LogviewLog *log) {
+  LogviewViewPrivate *priv;
+
+  g_return_if_fail(LOGVIEW_IS_VIEW(view));
+
+  priv = view->priv;
+
+  if (priv->log != log) {
+    g_clear_object(&priv->log);
+    priv->log = (log != NULL) ? g_object_ref(log) : NULL;
+  }
+
+  priv->n_lines = (log != NULL) ? logview_log_get_cached_lines_number(log) : 0;
+  priv->range_first = priv->range_last = -1;
+  priv->bold_line = G_MAXUINT;
+  priv->anchor.line = priv->cursor.line = 0;
+  priv->anchor.offset = priv->cursor.offset = 0;
+  priv->dragging = FALSE;
+  priv->max_width = 0;
+  view_update_tag_width(view);
+
+  if (priv->vadjustment != NULL) {
+    gtk_adjustment_set_value(priv->vadjustment, 0);
+  }
+
+  if (priv->hadjustment != NULL) {
+    gtk_adjustment_set_value(priv->hadjustment, 0);
+  }
+
+  logview_finder_stop(priv->finder);
+  view_restart_filtering(view);
+  view_rebuild_rows(view);
+}
+
+LogviewLog *logview_view_get_log(LogviewView *view) {
+  g_return_val_if_fail(LOGVIEW_IS_VIEW(view), NULL);
+
+  return view->priv->log;
+}
+
+/* the lines [first_line, first_line + n_lines) have been read; are_new
+ * is set when they were appended to an already loaded log */
+void logview_view_add_lines(LogviewView *view, guint first_line,
+                            guint n_lines, gboolean are_new) {
+  LogviewViewPrivate *priv;
+
+  g_return_if_fail(LOGVIEW_IS_VIEW(view));
+
+  priv = view->priv;
+
+  if (are_new && priv->bold_line == G_MAXUINT) {
+    priv->bold_line = first_line;
+  }
+
+  priv->n_lines = first_line + n_lines;
+  logview_filter_engine_add_lines(priv->engine, priv->n_lines);
+  logview_finder_add_lines(priv->finder, priv->n_lines);
+
+  if (priv->rows != NULL) {
+    view_append_rows(view, first_line, priv->n_lines);
+  }
+
+  view_update_adjustments(view);
+  gtk_widget_queue_draw(GTK_WIDGET(view));
+}
+
+void logview_view_set_filters(LogviewView *view, GList *filters,
+                              gboolean matches_only) {
+  LogviewViewPrivate *priv;
+  GdkRGBA *rgba;
+  GtkTextTag *tag;
+  GList *l;
+
+  g_return_if_fail(LOGVIEW_IS_VIEW(view));
+
+  priv = view->priv;
+
+  view_clear_filters(view);
+  priv->matches_only = matches_only;
+
+  for (l = filters; l != NULL; l = l->next) {
+    ViewFilter vf = {0};
+
+    vf.filter = g_object_ref(l->data);
+    tag = logview_filter_get_tag(vf.filter);
+
+    if (tag != NULL) {
+      g_object_get(tag, "foreground-set", &vf.foreground_set,
+                   "paragraph-background-set", &vf.background_set,
+                   "invisible", &vf.invisible, NULL);
+
+      if (vf.foreground_set) {
+        g_object_get(tag, "foreground-rgba", &rgba, NULL);
+        vf.foreground = *rgba;
+        gdk_rgba_free(rgba);
+      }
+
+      if (vf.background_set) {
+        g_object_get(tag, "paragraph-background-rgba", &rgba, NULL);
+        vf.background = *rgba;
+        gdk_rgba_free(rgba);
+      }
+    }
+
+    priv->has_invisible_filters |= vf.invisible;
+    g_array_append_val(priv->filters, vf);
+  }
+
+  view_restart_filtering(view);
+  view_rebuild_rows(view);
+}
+
+/* only shows the lines from first_line to last_line, or all of them if
+ * first_line is negative */
+void logview_view_set_line_range(LogviewView *view, int first_line,
+                                 int last_line) {
+  LogviewViewPrivate *priv;
+
+  g_return_if_fail(LOGVIEW_IS_VIEW(view));
+
+  priv = view->priv;
+  priv->range_first = first_line;
+  priv->range_last = (first_line >= 0) ? last_line : -1;
+
+  if (priv->vadjustment != NULL) {
+    gtk_adjustment_set_value(priv->vadjustment, 0);
+  }
+
+  view_rebuild_rows(view);
+}
+
+/* looks for text in the whole log and highlights all the matches, or
+ * clears them if text is NULL */
+gboolean logview_view_find(LogviewView *view, const char *text,
+                           LogviewFinderFlags flags, GError **error) {
+  LogviewViewPrivate *priv;
+  gboolean retval = TRUE;
+
+  g_return_val_if_fail(LOGVIEW_IS_VIEW(view), FALSE);
+
+  priv = view->priv;
+
+  if (text == NULL || *text == '\0' || priv->log == NULL) {
+    logview_finder_stop(priv->finder);
+  } else {
+    retval = logview_finder_start(priv->finder, priv->log, text, flags,
+                                  priv->n_lines, error);
+  }
+
+  gtk_widget_queue_draw(GTK_WIDGET(view));
+
+  return retval;
+}
+
+LogviewFinder *logview_view_get_finder(LogviewView *view) {
+  g_return_val_if_fail(LOGVIEW_IS_VIEW(view), NULL);
+
+  return view->priv->finder;
+}
+
+LogviewFilterEngine *logview_view_get_filter_engine(LogviewView *view) {
+  g_return_val_if_fail(LOGVIEW_IS_VIEW(view), NULL);
+
+  return view->priv->engine;
+}
+
+guint logview_view_get_n_rows(LogviewView *view) {
+  LogviewViewPrivate *priv = view->priv;
+
+  return (priv->rows != NULL) ? priv->rows->len : priv->n_lines;
+}
+
+guint logview_view_get_row_line(LogviewView *view, guint row) {
+  LogviewViewPrivate *priv = view->priv;
+
+  return (priv->rows != NULL) ? g_array_index(priv->rows, guint, row) : row;
+}
+
+/* returns the row of line, or of the first shown line after it */
+guint logview_view_get_line_row(LogviewView *view, guint line) {
+  LogviewViewPrivate *priv = view->priv;
+  guint low, high, mid;
+
+  if (priv->rows == NULL) {
+    return MIN(line, priv->n_lines);
+  }
+
+  low = 0;
+  high = priv->rows->len;
+
+  while (low < high) {
+    mid = low + (high - low) / 2;
+
+    if (g_array_index(priv->rows, guint, mid) < line) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  return low;
+}
+
+/**
+ * logview_view_get_line_text:
+ *
+ * @view: a #LogviewView.
+ * @line: the line number.
+ * @len: return location for the length of the text.
+ *
+ * Returns: the text of @line as it's shown, in UTF-8; it's not
+ *   NUL-terminated and only valid until the next call.
+ */
+const char *logview_view_get_line_text(LogviewView *view, guint line,
+                                       gsize *len) {
+  LogviewViewPrivate *priv = view->priv;
+  const char *text;
+  char *converted;
+
+  text = logview_log_get_line_utf8(priv->log, line, len, &converted);
+
+  if (text == NULL) {
+    *len = 0;
+    return "";
+  }
+
+  if (converted != NULL) {
+    g_free(priv->scratch);
+    priv->scratch = converted;
+  }
+
+  return text;
+}
+
+/* selects [start, end) in line and scrolls to it */
+void logview_view_select_range(LogviewView *view, guint line, gsize start,
+                               gsize end) {
+  LogviewViewPrivate *priv;
+  PangoRectangle start_pos, end_pos;
+  const char *text;
+  gsize len;
+
+  g_return_if_fail(LOGVIEW_IS_VIEW(view));
+
+  priv = view->priv;
+
+  priv->anchor.line = priv->cursor.line = line;
+  priv->anchor.offset = start;
+  priv->cursor.offset = end;
+
+  view_scroll_to_row(view, logview_view_get_line_row(view, line));
+
+  text = logview_view_get_line_text(view, line, &len);
+  pango_layout_set_text(priv->layout, text, (int)len);
+  pango_layout_index_to_pos(priv->layout, (int)MIN(start, len), &start_pos);
+  pango_layout_index_to_pos(priv->layout, (int)MIN(end, len), &end_pos);
+
+  view_scroll_to_x(view, start_pos.x / PANGO_SCALE + TEXT_MARGIN,
+                   end_pos.x / PANGO_SCALE + priv->tag_width + TEXT_MARGIN);
+
+  gtk_widget_queue_draw(GTK_WIDGET(view));
+}
+
+gboolean logview_view_get_selection(LogviewView *view, guint *start_line,
+                                    gsize *start, guint *end_line,
+                                    gsize *end) {
+  ViewPos first, last;
+
+  g_return_val_if_fail(LOGVIEW_IS_VIEW(view), FALSE);
+
+  if (!view_get_selection_bounds(view, &first, &last)) {
+    return FALSE;
+  }
+
+  *start_line = first.line;
+  *start = first.offset;
+  *end_line = last.line;
+  *end = last.offset;
+
+  return TRUE;
+}
+
+void logview_view_select_all(LogviewView *view) {
+  LogviewViewPrivate *priv;
+  guint n_rows;
+
+  g_return_if_fail(LOGVIEW_IS_VIEW(view));
+
+  priv = view->priv;
+  n_rows = logview_view_get_n_rows(view);
+
+  if (priv->log == NULL || n_rows == 0) {
+    return;
+  }
+
+  priv->anchor.line = logview_view_get_row_line(view, 0);
+  priv->anchor.offset = 0;
+  priv->cursor.line = logview_view_get_row_line(view, n_rows - 1);
+  logview_view_get_line_text(view, priv->cursor.line, &priv->cursor.offset);
+
+  gtk_widget_queue_draw(GTK_WIDGET(view));
+}
+
+void logview_view_unselect(LogviewView *view) {
+  g_return_if_fail(LOGVIEW_IS_VIEW(view));
+
+  view->priv->anchor = view->priv->cursor;
+  gtk_widget_queue_draw(GTK_WIDGET(view));
+}
+
+void logview_view_copy_clipboard(LogviewView *view, GtkClipboard *clipboard) {
+  char *text;
+
+  g_return_if_fail(LOGVIEW_IS_VIEW(view));
+
+  if ((text = view_get_selected_text(view)) != NULL) {
+    gtk_clipboard_set_text(clipboard, text, -1);
+    g_free(text);
+  }
+}
+
+void logview_view_scroll_to_line(LogviewView *view, guint line) {
+  g_return_if_fail(LOGVIEW_IS_VIEW(view));
+
+  view_scroll_to_row(view, logview_view_get_line_row(view, line));
+}
+
+void logview_view_scroll_to_end(LogviewView *view) {
+  GtkAdjustment *adj;
+
+  g_return_if_fail(LOGVIEW_IS_VIEW(view));
+
+  if ((adj = view->priv->vadjustment) != NULL) {
+    gtk_adjustment_set_value(
+        adj, gtk_adjustment_get_upper(adj) - gtk_adjustment_get_page_size(adj));
+  }
+}
@@ -0,0 +1,98 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2; -*- */
+/* Copyright (C) 2012-2021 MATE Developers
+ *
+ * This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* logview-view.h */
+
+#ifndef __LOGVIEW_VIEW_H__
+#define __LOGVIEW_VIEW_H__
+
+#include <gtk/gtk.h>
+
+#include "logview-filter-engine.h"
+#include "logview-finder.h"
+#include "logview-log.h"
+
+G_BEGIN_DECLS
+
+#define LOGVIEW_TYPE_VIEW logview_view_get_type()
+#define LOGVIEW_VIEW(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj), LOGVIEW_TYPE_VIEW, LogviewView))
+#define LOGVIEW_VIEW_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass), LOGVIEW_TYPE_VIEW, LogviewViewClass))
+#define LOGVIEW_IS_VIEW(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj), LOGVIEW_TYPE_VIEW))
+#define LOGVIEW_IS_VIEW_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass), LOGVIEW_TYPE_VIEW))
+#define LOGVIEW_VIEW_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS((obj), LOGVIEW_TYPE_VIEW, LogviewViewClass))
+
+typedef struct _LogviewView LogviewView;
+typedef struct _LogviewViewClass LogviewViewClass;
+typedef struct _LogviewViewPrivate LogviewViewPrivate;
+
+struct _LogviewView {
+  GtkWidget parent;
+  LogviewViewPrivate *priv;
+};
+
+struct _LogviewViewClass {
+  GtkWidgetClass parent_class;
+};
+
+GType logview_view_get_type(void);
+
+/* public methods */
+GtkWidget *logview_view_new(void);
+
+void logview_view_set_log(LogviewView *view, LogviewLog *log);
+LogviewLog *logview_view_get_log(LogviewView *view);
+void logview_view_add_lines(LogviewView *view, guint first_line,
+                            guint n_lines, gboolean are_new);
+
+void logview_view_set_filters(LogviewView *view, GList *filters,
+                              gboolean matches_only);
+void logview_view_set_line_range(LogviewView *view, int first_line,
+                                 int last_line);
+
+gboolean logview_view_find(LogviewView *view, const char *text,
+                           LogviewFinderFlags flags, GError **error);
+LogviewFinder *logview_view_get_finder(LogviewView *view);
+LogviewFilterEngine *logview_view_get_filter_engine(LogviewView *view);
+
+guint logview_view_get_n_rows(LogviewView *view);
+guint logview_view_get_row_line(LogviewView *view, guint row);
+guint logview_view_get_line_row(LogviewView *view, guint line);
+const char *logview_view_get_line_text(LogviewView *view, guint line,
+                                       gsize *len);
+
+void logview_view_select_range(LogviewView *view, guint line, gsize start,
+                               gsize end);
+gboolean logview_view_get_selection(LogviewView *view, guint *start_line,
+                                    gsize *start, guint *end_line,
+                                    gsize *end);
+void logview_view_select_all(LogviewView *view);
+void logview_view_unselect(LogviewView *view);
+void logview_view_copy_clipboard(LogviewView *view, GtkClipboard *clipboard);
+
+void logview_view_scroll_to_line(LogviewView *view, guint line);
+void logview_view_scroll_to_end(LogviewView *view);
+
+G_END_DECLS
+
+#endif /* __LOGVIEW_VIEW_H__ */
@@ -32,14 +32,14 @@
 #include "logview-about.h"
 #include "logview-filter-manager.h"
 #include "logview-findbar.h"
+#include "logview-histogram.h"
 #include "logview-loglist.h"
 #include "logview-manager.h"
 #include "logview-prefs.h"
+#include "logview-view.h"
 #include "logview-window.h"
 
 #define APP_NAME _("System Log Viewer")
-#define SEARCH_START_MARK "lw-search-start-mark"
-#define SEARCH_END_MARK "lw-search-end-mark"
 
 struct _LogviewWindowPrivate {
   GtkUIManager *ui_manager;
@@ -52,6 +52,7 @@ struct _LogviewWindowPrivate {
   GtkWidget *version_bar;
   GtkWidget *version_selector;
   GtkWidget *hpaned;
+  GtkWidget *histogram;
   GtkWidget *text_view;
   GtkWidget *statusbar;
 
@@ -59,8 +60,6 @@ struct _LogviewWindowPrivate {
   GtkWidget *message_primary;
   GtkWidget *message_secondary;
 
-  GtkTextTagTable *tag_table;
-
   int original_fontsize, fontsize;
 
   LogviewPrefs *prefs;
@@ -69,6 +68,10 @@ struct _LogviewWindowPrivate {
   gulong monitor_id;
   guint search_timeout_id;
 
+  /* the selected match, and whether to jump to the first one found */
+  int search_match;
+  gboolean search_jump;
+
   GCancellable *read_cancellable;
 
   guint filter_merge_id;
@@ -79,8 +82,9 @@ struct _LogviewWindowPrivate {
 G_DEFINE_TYPE_WITH_PRIVATE(LogviewWindow, logview_window, GTK_TYPE_WINDOW);
 
 static void findbar_close_cb(LogviewFindbar *findbar, gpointer user_data);
-static void read_new_lines_cb(LogviewLog *log, const char **lines,
-                              GSList *new_days, GError *error,
+static void logview_search_start(LogviewWindow *logview);
+static void read_new_lines_cb(LogviewLog *log, guint first_line,
+                              guint n_lines, GSList *new_days, GError *error,
                               gpointer user_data);
 
 /* private functions */
@@ -89,71 +93,6 @@ static void logview_version_selector_changed(GtkComboBox *version_selector,
                                              gpointer user_data) {}
 /* private helpers */
 
-static void populate_tag_table(GtkTextTagTable *tag_table) {
-  GtkTextTag *tag;
-
-  tag = gtk_text_tag_new("bold");
-  g_object_set(tag, "weight", PANGO_WEIGHT_BOLD, "weight-set", TRUE, NULL);
-
-  gtk_text_tag_table_add(tag_table, tag);
-
-  tag = gtk_text_tag_new("invisible");
-  g_object_set(tag, "invisible", TRUE, "invisible-set", TRUE, NULL);
-  gtk_text_tag_table_add(tag_table, tag);
-
-  tag = gtk_text_tag_new("invisible-filter");
-  g_object_set(tag, "invisible", TRUE, "invisible-set", TRUE, NULL);
-  gtk_text_tag_table_add(tag_table, tag);
-}
-
-static void populate_style_tag_table(LogviewWindow *logview) {
-  GtkTextTagTable *tag_table = logview->priv->tag_table;
-  GtkTextTag *tag;
-  GtkStyleContext *context;
-  GdkRGBA rgba;
-
-  tag = gtk_text_tag_table_lookup(tag_table, "gray");
-
-  if (tag) {
-    gtk_text_tag_table_remove(tag_table, tag);
-  }
-
-  tag = gtk_text_tag_new("gray");
-
-  context = gtk_widget_get_style_context(logview->priv->text_view);
-  gtk_style_context_save(context);
-  gtk_style_context_add_class(context, "dim-label");
-  gtk_style_context_get_color(context, GTK_STATE_FLAG_NORMAL, &rgba);
-  gtk_style_context_restore(context);
-
-  g_object_set(tag, "foreground-rgba", &rgba, "foreground-set", TRUE, NULL);
-
-  gtk_text_tag_table_add(tag_table, tag);
-}
-
-static void _gtk_text_buffer_apply_tag_to_rectangle(
-    GtkTextBuffer *buffer, int line_start, int line_end, int offset_start,
-    int offset_end, char *tag_name) {
-  GtkTextIter start, end;
-  int line_cur;
-
-  gtk_text_buffer_get_iter_at_line(buffer, &start, line_start);
-  gtk_text_buffer_get_iter_at_line(buffer, &end, line_start);
-
-  for (line_cur = line_start; line_cur < line_end + 1; line_cur++) {
-    if (offset_start > 0) {
-      gtk_text_iter_forward_chars(&start, offset_start);
-    }
-
-    gtk_text_iter_forward_chars(&end, offset_end);
-
-    gtk_text_buffer_apply_tag_by_name(buffer, tag_name, &start, &end);
-
-    gtk_text_iter_forward_line(&start);
-    gtk_text_iter_forward_line(&end);
-  }
-}
-
 static void logview_update_statusbar(LogviewWindow *logview,
                                      LogviewLog *active) {
   GDateTime *date_time;
@@ -293,6 +232,10 @@ static void logview_close_log(GtkAction *action, LogviewWindow *logview) {
   logview_manager_close_active_log(logview->priv->manager);
 }
 
+static void logview_merge_logs(GtkAction *action, LogviewWindow *logview) {
+  logview_manager_add_merged_log(logview->priv->manager);
+}
+
 static void logview_help(GtkAction *action, GtkWidget *parent_window) {
   GError *error = NULL;
 
@@ -321,115 +264,139 @@ static void logview_normal_text(GtkAction *action, LogviewWindow *logview) {
 }
 
 static void logview_select_all(GtkAction *action, LogviewWindow *logview) {
-  GtkTextIter start, end;
-  GtkTextBuffer *buffer;
-
-  buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(logview->priv->text_view));
-
-  gtk_text_buffer_get_bounds(buffer, &start, &end);
-  gtk_text_buffer_select_range(buffer, &start, &end);
+  logview_view_select_all(LOGVIEW_VIEW(logview->priv->text_view));
 
   gtk_widget_grab_focus(GTK_WIDGET(logview->priv->text_view));
 }
 
 static void logview_copy(GtkAction *action, LogviewWindow *logview) {
-  GtkTextBuffer *buffer;
   GtkClipboard *clipboard;
 
-  buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(logview->priv->text_view));
   clipboard = gtk_clipboard_get(GDK_SELECTION_CLIPBOARD);
 
-  gtk_text_buffer_copy_clipboard(buffer, clipboard);
+  logview_view_copy_clipboard(LOGVIEW_VIEW(logview->priv->text_view),
+                              clipboard);
 
   gtk_widget_grab_focus(GTK_WIDGET(logview->priv->text_view));
 }
 
 static void findbar_close_cb(LogviewFindbar *findbar, gpointer user_data) {
+  LogviewWindow *logview = user_data;
+
   gtk_widget_hide(GTK_WIDGET(findbar));
   logview_findbar_set_message(findbar, NULL);
+
+  logview_view_find(LOGVIEW_VIEW(logview->priv->text_view), NULL, 0, NULL);
+  logview->priv->search_match = -1;
+}
+
+static void logview_search_set_count(LogviewWindow *logview) {
+  LogviewFinder *finder;
+  char *message;
+
+  finder = logview_view_get_finder(LOGVIEW_VIEW(logview->priv->text_view));
+
+  message =
+      g_strdup_printf(_("Match %d of %u"), logview->priv->search_match + 1,
+                      logview_finder_get_n_matches(finder));
+  logview_findbar_set_message(LOGVIEW_FINDBAR(logview->priv->find_bar),
+                              message);
+  g_free(message);
 }
 
+/* selects the next or previous match of the finder, skipping those in
+ * lines that are hidden */
 static void logview_search_text(LogviewWindow *logview, gboolean forward) {
-  GtkTextBuffer *buffer;
-  GtkTextMark *search_start, *search_end;
-  GtkTextIter search, start_m, end_m;
+  LogviewWindowPrivate *priv = logview->priv;
+  LogviewView *view = LOGVIEW_VIEW(priv->text_view);
+  LogviewFinder *finder = logview_view_get_finder(view);
+  const LogviewMatch *match;
   const char *text;
-  gboolean res, wrapped;
-
-  wrapped = FALSE;
+  guint n_matches, n_rows, row, tries;
+  gboolean wrapped;
+  int i;
 
-  text = logview_findbar_get_text(LOGVIEW_FINDBAR(logview->priv->find_bar));
+  text = logview_findbar_get_text(LOGVIEW_FINDBAR(priv->find_bar));
 
-  if (!text || g_strcmp0(text, "") == 0) {
+  if (!logview_finder_has_pattern(finder) && text != NULL && *text != '\0') {
+    /* the search was stopped, by closing the findbar or by another log
+     * being shown, but the findbar kept its text */
+    logview_search_start(logview);
     return;
   }
 
-  buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(logview->priv->text_view));
-  search_start = gtk_text_buffer_get_mark(buffer, SEARCH_START_MARK);
-  search_end = gtk_text_buffer_get_mark(buffer, SEARCH_END_MARK);
-
-  if (!search_start) {
-    /* this is our first search on the buffer, create a new search mark */
-    gtk_text_buffer_get_start_iter(buffer, &search);
-    search_start =
-        gtk_text_buffer_create_mark(buffer, SEARCH_START_MARK, &search, TRUE);
-    search_end =
-        gtk_text_buffer_create_mark(buffer, SEARCH_END_MARK, &search, TRUE);
-  } else {
-    if (forward) {
-      gtk_text_buffer_get_iter_at_mark(buffer, &search, search_end);
-    } else {
-      gtk_text_buffer_get_iter_at_mark(buffer, &search, search_start);
-    }
-  }
+  n_matches = logview_finder_get_n_matches(finder);
 
-wrap:
+  if (n_matches == 0) {
+    if (logview_finder_is_done(finder)) {
+      logview_view_unselect(view);
+      logview_findbar_set_message(LOGVIEW_FINDBAR(priv->find_bar),
+                                  _("Not found"));
+    }
 
-  if (forward) {
-    res = gtk_text_iter_forward_search(
-        &search, text, GTK_TEXT_SEARCH_VISIBLE_ONLY, &start_m, &end_m, NULL);
-  } else {
-    res = gtk_text_iter_backward_search(
-        &search, text, GTK_TEXT_SEARCH_VISIBLE_ONLY, &start_m, &end_m, NULL);
+    return;
   }
 
-  if (res) {
-    gtk_text_buffer_select_range(buffer, &start_m, &end_m);
-    gtk_text_buffer_move_mark(buffer, search_start, &start_m);
-    gtk_text_buffer_move_mark(buffer, search_end, &end_m);
+  n_rows = logview_view_get_n_rows(view);
+  wrapped = FALSE;
+  i = priv->search_match;
 
-    gtk_text_view_scroll_mark_onscreen(GTK_TEXT_VIEW(logview->priv->text_view),
-                                       search_end);
+  for (tries = 0; tries < n_matches; tries++) {
+    i = forward ? i + 1 : i - 1;
 
-    if (wrapped) {
-      logview_findbar_set_message(LOGVIEW_FINDBAR(logview->priv->find_bar),
-                                  _("Wrapped"));
+    if (i >= (int)n_matches || (i < 0 && priv->search_match >= 0)) {
+      wrapped = TRUE;
     }
-  } else {
-    if (wrapped) {
-      GtkTextMark *mark;
-      GtkTextIter iter;
-
-      if (gtk_text_buffer_get_has_selection(buffer)) {
-        /* unselect */
-        mark = gtk_text_buffer_get_mark(buffer, "insert");
-        gtk_text_buffer_get_iter_at_mark(buffer, &iter, mark);
-        gtk_text_buffer_move_mark_by_name(buffer, "selection_bound", &iter);
-      }
 
-      logview_findbar_set_message(LOGVIEW_FINDBAR(logview->priv->find_bar),
-                                  _("Not found"));
-    } else {
-      if (forward) {
-        gtk_text_buffer_get_start_iter(buffer, &search);
+    if (i >= (int)n_matches) {
+      i = 0;
+    } else if (i < 0) {
+      i = n_matches - 1;
+    }
+
+    match = logview_finder_get_match(finder, i);
+    row = logview_view_get_line_row(view, match->line);
+
+    if (row < n_rows && logview_view_get_row_line(view, row) == match->line) {
+      priv->search_match = i;
+      logview_view_select_range(view, match->line, match->start, match->end);
+
+      if (wrapped) {
+        logview_findbar_set_message(LOGVIEW_FINDBAR(priv->find_bar),
+                                    _("Wrapped"));
       } else {
-        gtk_text_buffer_get_end_iter(buffer, &search);
+        logview_search_set_count(logview);
       }
 
-      wrapped = TRUE;
-      goto wrap;
+      return;
     }
   }
+
+  /* all the matches are in hidden lines */
+  logview_view_unselect(view);
+  logview_findbar_set_message(LOGVIEW_FINDBAR(priv->find_bar),
+                              _("Not found"));
+}
+
+static void finder_progress_cb(LogviewFinder *finder, gpointer user_data) {
+  LogviewWindow *logview = user_data;
+
+  if (logview->priv->search_jump &&
+      logview_finder_get_n_matches(finder) > 0) {
+    logview->priv->search_jump = FALSE;
+    logview_search_text(logview, TRUE);
+  }
+
+  if (!logview_finder_is_done(finder)) {
+    return;
+  }
+
+  /* the count is final now */
+  if (logview_finder_get_n_matches(finder) == 0) {
+    logview_search_text(logview, TRUE);
+  } else if (logview->priv->search_match >= 0) {
+    logview_search_set_count(logview);
+  }
 }
 
 static void findbar_previous_cb(LogviewFindbar *findbar, gpointer user_data) {
@@ -444,28 +411,49 @@ static void findbar_next_cb(LogviewFindbar *findbar, gpointer user_data) {
   logview_search_text(logview, TRUE);
 }
 
-static gboolean text_changed_timeout_cb(gpointer user_data) {
-  LogviewWindow *logview = user_data;
-  GtkTextMark *search_start, *search_end;
-  GtkTextIter start;
-  GtkTextBuffer *buffer;
+/* searches the log for the text of the findbar */
+static void logview_search_start(LogviewWindow *logview) {
+  LogviewWindowPrivate *priv = logview->priv;
+  LogviewFindbar *findbar = LOGVIEW_FINDBAR(priv->find_bar);
+  LogviewView *view = LOGVIEW_VIEW(priv->text_view);
+  LogviewFinderFlags flags = 0;
+  GError *error = NULL;
 
-  logview->priv->search_timeout_id = 0;
+  /* the whole log is searched again, the first match is selected as
+   * soon as it's found */
+  priv->search_match = -1;
+  priv->search_jump = TRUE;
 
-  buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(logview->priv->text_view));
-  search_start = gtk_text_buffer_get_mark(buffer, SEARCH_START_MARK);
-  search_end = gtk_text_buffer_get_mark(buffer, SEARCH_END_MARK);
+  logview_findbar_set_message(findbar, NULL);
 
-  if (search_start) {
-    /* reset the search mark to the start */
-    gtk_text_buffer_get_start_iter(buffer, &start);
-    gtk_text_buffer_move_mark(buffer, search_start, &start);
-    gtk_text_buffer_move_mark(buffer, search_end, &start);
+  if (logview_findbar_get_match_case(findbar)) {
+    flags |= LOGVIEW_FINDER_MATCH_CASE;
   }
 
-  logview_findbar_set_message(LOGVIEW_FINDBAR(logview->priv->find_bar), NULL);
+  if (logview_findbar_get_use_regex(findbar)) {
+    flags |= LOGVIEW_FINDER_REGEX;
+  }
 
-  logview_search_text(logview, TRUE);
+  if (!logview_view_find(view, logview_findbar_get_text(findbar), flags,
+                         &error)) {
+    logview_view_unselect(view);
+    logview_findbar_set_message(findbar, error->message);
+    g_error_free(error);
+
+    return;
+  }
+
+  /* an empty log is done with already */
+  if (logview_view_get_log(view) != NULL) {
+    finder_progress_cb(logview_view_get_finder(view), logview);
+  }
+}
+
+static gboolean text_changed_timeout_cb(gpointer user_data) {
+  LogviewWindow *logview = user_data;
+
+  logview->priv->search_timeout_id = 0;
+  logview_search_start(logview);
 
   return FALSE;
 }
@@ -486,59 +474,11 @@ static void logview_search(GtkAction *action, LogviewWindow *logview) {
   logview_findbar_open(LOGVIEW_FINDBAR(logview->priv->find_bar));
 }
 
-static void filter_buffer(LogviewWindow *logview, gint start_line) {
-  GtkTextBuffer *buffer;
-  GtkTextIter start, *end;
-  gchar *text;
-  GList *cur_filter;
-  gboolean matched;
-  int lines, i;
-
-  buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(logview->priv->text_view));
-  lines = gtk_text_buffer_get_line_count(buffer);
-
-  for (i = start_line; i < lines; i++) {
-    matched = FALSE;
-
-    gtk_text_buffer_get_iter_at_line(buffer, &start, i);
-    end = gtk_text_iter_copy(&start);
-    gtk_text_iter_forward_line(end);
-
-    text = gtk_text_buffer_get_text(buffer, &start, end, TRUE);
-
-    for (cur_filter = logview->priv->active_filters; cur_filter != NULL;
-         cur_filter = g_list_next(cur_filter)) {
-      if (logview_filter_filter(LOGVIEW_FILTER(cur_filter->data), text)) {
-        gtk_text_buffer_apply_tag(
-            buffer, logview_filter_get_tag(LOGVIEW_FILTER(cur_filter->data)),
-            &start, end);
-        matched = TRUE;
-      }
-    }
-
-    g_free(text);
-
-    if (!matched && logview->priv->matches_only) {
-      gtk_text_buffer_apply_tag_by_name(buffer, "invisible-filter", &start,
-                                        end);
-    } else {
-      gtk_text_buffer_remove_tag_by_name(buffer, "invisible-filter", &start,
-                                         end);
-    }
-
-    gtk_text_iter_free(end);
-  }
-}
-
-static void filter_remove(LogviewWindow *logview, LogviewFilter *filter) {
-  GtkTextIter start, end;
-  GtkTextBuffer *buffer;
-
-  buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(logview->priv->text_view));
-  gtk_text_buffer_get_bounds(buffer, &start, &end);
-
-  gtk_text_buffer_remove_tag(buffer, logview_filter_get_tag(filter), &start,
-                             &end);
+static void filter_buffer(LogviewWindow *logview) {
+  logview_view_set_filters(LOGVIEW_VIEW(logview->priv->text_view),
+                           logview->priv->active_filters,
+                           logview->priv->matches_only);
+  logview_histogram_update(LOGVIEW_HISTOGRAM(logview->priv->histogram));
 }
 
 static void on_filter_toggled(GtkToggleAction *action, LogviewWindow *logview) {
@@ -551,13 +491,12 @@ static void on_filter_toggled(GtkToggleAction *action, LogviewWindow *logview) {
   if (gtk_toggle_action_get_active(action)) {
     priv->active_filters = g_list_append(
         priv->active_filters, logview_prefs_get_filter(priv->prefs, name));
-    filter_buffer(logview, 0);
   } else {
     filter = logview_prefs_get_filter(priv->prefs, name);
     priv->active_filters = g_list_remove(priv->active_filters, filter);
-
-    filter_remove(logview, filter);
   }
+
+  filter_buffer(logview);
 }
 
 #define FILTER_PLACEHOLDER "/LogviewMenu/FilterMenu/PlaceholderFilters"
@@ -567,8 +506,6 @@ static void update_filter_menu(LogviewWindow *window) {
   GList *actions, *l;
   guint id;
   GList *filters;
-  GtkTextTagTable *table;
-  GtkTextTag *tag;
   GtkToggleAction *action;
   gchar *name;
 
@@ -577,8 +514,6 @@ static void update_filter_menu(LogviewWindow *window) {
 
   g_return_if_fail(priv->filter_action_group != NULL);
 
-  table = priv->tag_table;
-
   if (priv->filter_merge_id != 0) {
     gtk_ui_manager_remove_ui(ui, priv->filter_merge_id);
   }
@@ -586,10 +521,6 @@ static void update_filter_menu(LogviewWindow *window) {
   actions = gtk_action_group_list_actions(priv->filter_action_group);
 
   for (l = actions; l != NULL; l = g_list_next(l)) {
-    tag = gtk_text_tag_table_lookup(table,
-                                    gtk_action_get_name(GTK_ACTION(l->data)));
-    gtk_text_tag_table_remove(table, tag);
-
     g_signal_handlers_disconnect_by_func(GTK_ACTION(l->data),
                                          G_CALLBACK(on_filter_toggled), window);
     gtk_action_group_remove_action(priv->filter_action_group,
@@ -612,8 +543,6 @@ static void update_filter_menu(LogviewWindow *window) {
 
     gtk_ui_manager_add_ui(ui, id, FILTER_PLACEHOLDER, name, name,
                           GTK_UI_MANAGER_MENUITEM, FALSE);
-    gtk_text_tag_table_add(table,
-                           logview_filter_get_tag(LOGVIEW_FILTER(l->data)));
 
     g_object_unref(action);
     g_free(name);
@@ -630,6 +559,8 @@ static void on_logview_filter_manager_response(GtkDialog *dialog, gint response,
 
   g_list_free(logview->priv->active_filters);
   logview->priv->active_filters = NULL;
+
+  filter_buffer(logview);
 }
 
 static void logview_manage_filters(GtkAction *action, LogviewWindow *logview) {
@@ -690,10 +621,18 @@ static void logview_toggle_sidebar(GtkAction *action, LogviewWindow *logview) {
     gtk_widget_show(logview->priv->sidebar);
 }
 
+static void logview_toggle_histogram(GtkAction *action,
+                                     LogviewWindow *logview) {
+  if (gtk_widget_get_visible(logview->priv->histogram))
+    gtk_widget_hide(logview->priv->histogram);
+  else
+    gtk_widget_show(logview->priv->histogram);
+}
+
 static void logview_toggle_match_filters(GtkToggleAction *action,
                                          LogviewWindow *logview) {
   logview->priv->matches_only = gtk_toggle_action_get_active(action);
-  filter_buffer(logview, 0);
+  filter_buffer(logview);
 }
 
 /* GObject functions */
@@ -711,6 +650,9 @@ static GtkActionEntry entries[] = {
      N_("Open a log from file"), G_CALLBACK(logview_open_log)},
     {"CloseLog", "window-close", N_("_Close"), "<control>W",
      N_("Close this log"), G_CALLBACK(logview_close_log)},
+    {"MergeLogs", NULL, N_("_Merge Open Logs"), NULL,
+     N_("Show the lines of all the open logs in the order of their times"),
+     G_CALLBACK(logview_merge_logs)},
     {"Quit", "application-exit", N_("_Quit"), "<control>Q",
      N_("Quit the log viewer"), G_CALLBACK(gtk_main_quit)},
 
@@ -742,6 +684,9 @@ static GtkToggleActionEntry toggle_entries[] = {
      G_CALLBACK(logview_toggle_statusbar), TRUE},
     {"ShowSidebar", NULL, N_("Side _Pane"), "F9", N_("Show Side Pane"),
      G_CALLBACK(logview_toggle_sidebar), TRUE},
+    {"ShowHistogram", NULL, N_("_Histogram"), NULL,
+     N_("Show the number of lines of each hour"),
+     G_CALLBACK(logview_toggle_histogram), FALSE},
     {"FilterMatchOnly", NULL, N_("Show matches only"), NULL,
      N_("Only show lines that match one of the given filters"),
      G_CALLBACK(logview_toggle_match_filters), FALSE}};
@@ -759,29 +704,8 @@ static gboolean window_size_changed_cb(GtkWidget *widget,
 
 static void real_select_day(LogviewWindow *logview, GDate *date, int first_line,
                             int last_line) {
-  GtkTextBuffer *buffer;
-  GtkTextIter start_iter, end_iter, start_vis, end_vis;
-  GdkRectangle visible_rect;
-
-  buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(logview->priv->text_view));
-
-  gtk_text_buffer_get_bounds(buffer, &start_iter, &end_iter);
-  gtk_text_buffer_get_iter_at_line(buffer, &start_vis, first_line);
-  gtk_text_buffer_get_iter_at_line(buffer, &end_vis, last_line + 1);
-
-  /* clear all previous invisible tags */
-  gtk_text_buffer_remove_tag_by_name(buffer, "invisible", &start_iter,
-                                     &end_iter);
-
-  gtk_text_buffer_apply_tag_by_name(buffer, "invisible", &start_iter,
-                                    &start_vis);
-  gtk_text_buffer_apply_tag_by_name(buffer, "invisible", &end_vis, &end_iter);
-
-  /* FIXME: why is this needed to update the view when selecting a day back? */
-  gtk_text_view_get_visible_rect(GTK_TEXT_VIEW(logview->priv->text_view),
-                                 &visible_rect);
-  gdk_window_invalidate_rect(gtk_widget_get_window(logview->priv->text_view),
-                             &visible_rect, TRUE);
+  logview_view_set_line_range(LOGVIEW_VIEW(logview->priv->text_view),
+                              first_line, last_line);
 }
 
 static void loglist_day_selected_cb(LogviewLoglist *loglist, Day *day,
@@ -794,14 +718,15 @@ static void loglist_day_selected_cb(LogviewLoglist *loglist, Day *day,
 static void loglist_day_cleared_cb(LogviewLoglist *loglist,
                                    gpointer user_data) {
   LogviewWindow *logview = user_data;
-  GtkTextBuffer *buffer;
-  GtkTextIter start, end;
 
-  buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(logview->priv->text_view));
-  gtk_text_buffer_get_bounds(buffer, &start, &end);
+  logview_view_set_line_range(LOGVIEW_VIEW(logview->priv->text_view), -1, -1);
+}
+
+static void histogram_line_activated_cb(LogviewHistogram *histogram,
+                                        guint line, gpointer user_data) {
+  LogviewWindow *logview = user_data;
 
-  /* clear all previous invisible tags */
-  gtk_text_buffer_remove_tag_by_name(buffer, "invisible", &start, &end);
+  logview_view_scroll_to_line(LOGVIEW_VIEW(logview->priv->text_view), line);
 }
 
 static void logview_window_schedule_log_read(LogviewWindow *window,
@@ -824,30 +749,13 @@ static void log_monitor_changed_cb(LogviewLog *log, gpointer user_data) {
   logview_window_schedule_log_read(window, log);
 }
 
-static void paint_timestamps(GtkTextBuffer *buffer, int old_line_count,
-                             GSList *days) {
-  GSList *l;
-
-  for (l = days; l; l = l->next) {
-    Day *day = l->data;
-
-    _gtk_text_buffer_apply_tag_to_rectangle(
-        buffer, old_line_count + day->first_line - 1,
-        old_line_count + day->last_line, 0, day->timestamp_len, "gray");
-  }
-}
-
-static void read_new_lines_cb(LogviewLog *log, const char **lines,
-                              GSList *new_days, GError *error,
+static void read_new_lines_cb(LogviewLog *log, guint first_line,
+                              guint n_lines, GSList *new_days, GError *error,
                               gpointer user_data) {
   LogviewWindow *window = user_data;
-  GtkTextBuffer *buffer;
-  gboolean boldify = FALSE;
-  int i, old_line_count, filter_start_line;
-  GtkTextIter iter, start;
-  GtkTextMark *mark;
-  char *converted, *primary;
-  gsize len;
+  LogviewView *view = LOGVIEW_VIEW(window->priv->text_view);
+  gboolean boldify;
+  char *primary;
 
   if (error != NULL) {
     if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
@@ -860,52 +768,21 @@ static void read_new_lines_cb(LogviewLog *log, const char **lines,
     return;
   }
 
-  if (lines == NULL) {
+  if (n_lines == 0) {
     /* there's no error, but no lines have been read */
     return;
   }
 
-  buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(window->priv->text_view));
-  old_line_count = gtk_text_buffer_get_line_count(buffer);
-  filter_start_line = old_line_count > 0 ? (old_line_count - 1) : 0;
-
-  if (gtk_text_buffer_get_char_count(buffer) != 0) {
-    boldify = TRUE;
-  }
-
-  gtk_text_buffer_get_end_iter(buffer, &iter);
-
-  if (boldify) {
-    mark = gtk_text_buffer_create_mark(buffer, NULL, &iter, TRUE);
-  }
-
-  for (i = 0; lines[i]; i++) {
-    len = strlen(lines[i]);
-
-    if (!g_utf8_validate(lines[i], len, NULL)) {
-      converted = g_locale_to_utf8(lines[i], (gssize)len, NULL, &len, NULL);
-      gtk_text_buffer_insert(buffer, &iter, converted, len);
-      g_free(converted);
-    } else {
-      gtk_text_buffer_insert(buffer, &iter, lines[i], strlen(lines[i]));
-    }
-
-    gtk_text_iter_forward_to_end(&iter);
-    gtk_text_buffer_insert(buffer, &iter, "\n", 1);
-    gtk_text_iter_forward_char(&iter);
-  }
-
-  if (boldify) {
-    gtk_text_buffer_get_iter_at_mark(buffer, &start, mark);
-    gtk_text_buffer_apply_tag_by_name(buffer, "bold", &start, &iter);
-    gtk_text_buffer_delete_mark(buffer, mark);
+  if (log != logview_view_get_log(view)) {
+    /* a late read of the log shown before */
+    return;
   }
-  filter_buffer(window, filter_start_line);
 
-  gtk_text_view_scroll_to_iter(GTK_TEXT_VIEW(window->priv->text_view), &iter,
-                               0.0, FALSE, 0.0, 0.0);
+  /* lines coming in while the log is first read are not new */
+  boldify = (first_line > 0 && logview_log_is_loaded(log));
 
-  paint_timestamps(buffer, old_line_count, new_days);
+  logview_view_add_lines(view, first_line, n_lines, boldify);
+  logview_view_scroll_to_end(view);
 
   if (window->priv->monitor_id == 0) {
     window->priv->monitor_id = g_signal_connect(
@@ -914,41 +791,41 @@ static void read_new_lines_cb(LogviewLog *log, const char **lines,
 
   logview_update_statusbar(window, log);
   logview_loglist_update_lines(LOGVIEW_LOGLIST(window->priv->loglist), log);
+  logview_histogram_update(LOGVIEW_HISTOGRAM(window->priv->histogram));
 }
 
 static void active_log_changed_cb(LogviewManager *manager, LogviewLog *log,
                                   LogviewLog *old_log, gpointer data) {
   LogviewWindow *window = data;
-  const char **lines;
-  GtkTextBuffer *buffer;
+  const char *text;
+  gboolean search;
+  guint n_lines;
+
+  /* an open search goes on in the new log */
+  text = logview_findbar_get_text(LOGVIEW_FINDBAR(window->priv->find_bar));
+  search = gtk_widget_get_visible(window->priv->find_bar) && text != NULL &&
+           *text != '\0';
 
-  findbar_close_cb(LOGVIEW_FINDBAR(window->priv->find_bar), window);
+  if (!search) {
+    findbar_close_cb(LOGVIEW_FINDBAR(window->priv->find_bar), window);
+  }
 
   logview_set_window_title(window, logview_log_get_display_name(log));
 
   g_clear_signal_handler(&window->priv->monitor_id, old_log);
 
-  lines = logview_log_get_cached_lines(log);
-  buffer = gtk_text_buffer_new(window->priv->tag_table);
-
-  if (lines != NULL) {
-    int i;
-    GtkTextIter iter;
+  window->priv->search_match = -1;
 
-    /* update the text view to show the current lines */
-    gtk_text_buffer_get_end_iter(buffer, &iter);
+  /* only the visible lines are drawn, so this is cheap */
+  n_lines = logview_log_get_cached_lines_number(log);
+  logview_view_set_log(LOGVIEW_VIEW(window->priv->text_view), log);
+  logview_histogram_set_log(LOGVIEW_HISTOGRAM(window->priv->histogram), log);
 
-    for (i = 0; lines[i]; i++) {
-      gtk_text_buffer_insert(buffer, &iter, lines[i], strlen(lines[i]));
-      gtk_text_iter_forward_to_end(&iter);
-      gtk_text_buffer_insert(buffer, &iter, "\n", 1);
-      gtk_text_iter_forward_char(&iter);
-    }
-
-    paint_timestamps(buffer, 1, logview_log_get_days_for_cached_lines(log));
+  if (search) {
+    logview_search_start(window);
   }
 
-  if (lines == NULL || logview_log_has_new_lines(log)) {
+  if (n_lines == 0 || logview_log_has_new_lines(log)) {
     /* read the new lines */
     logview_window_schedule_log_read(window, log);
   } else {
@@ -956,14 +833,6 @@ static void active_log_changed_cb(LogviewManager *manager, LogviewLog *log,
     window->priv->monitor_id = g_signal_connect(
         log, "log-changed", G_CALLBACK(log_monitor_changed_cb), window);
   }
-
-  /* we set the buffer to the view anyway;
-   * if there are no lines it will be empty for the duration of the thread
-   * and will help us to distinguish the two cases of the following if
-   * cause in the callback.
-   */
-  gtk_text_view_set_buffer(GTK_TEXT_VIEW(window->priv->text_view), buffer);
-  g_object_unref(buffer);
 }
 
 static void font_changed_cb(LogviewPrefs *prefs, const char *font_name,
@@ -1118,6 +987,7 @@ static void logview_window_init(LogviewWindow *logview) {
   priv = logview->priv = logview_window_get_instance_private(logview);
   priv->prefs = logview_prefs_get();
   priv->manager = logview_manager_get();
+  priv->search_match = -1;
   priv->monitor_id = 0;
 
   logview_prefs_get_stored_window_size(priv->prefs, &width, &height);
@@ -1206,16 +1076,21 @@ static void logview_window_init(LogviewWindow *logview) {
   gtk_box_pack_start(GTK_BOX(main_view), w, TRUE, TRUE, 0);
   gtk_widget_show(w);
 
-  priv->tag_table = gtk_text_tag_table_new();
-  populate_tag_table(priv->tag_table);
-
-  priv->text_view = gtk_text_view_new();
-  g_object_set(priv->text_view, "editable", FALSE, NULL);
-  populate_style_tag_table(logview);
+  priv->text_view = logview_view_new();
 
   gtk_container_add(GTK_CONTAINER(w), priv->text_view);
   gtk_widget_show(priv->text_view);
 
+  /* second pane: histogram, between the message area and the text view,
+   * shown from the View menu */
+  priv->histogram = logview_histogram_new(
+      logview_view_get_filter_engine(LOGVIEW_VIEW(priv->text_view)));
+  gtk_box_pack_start(GTK_BOX(main_view), priv->histogram, FALSE, FALSE, 0);
+  gtk_box_reorder_child(GTK_BOX(main_view), priv->histogram, 1);
+
+  g_signal_connect(priv->histogram, "line-activated",
+                   G_CALLBACK(histogram_line_activated_cb), logview);
+
   /* use the desktop monospace font */
   monospace_font_name = logview_prefs_get_monospace_font_name(priv->prefs);
   logview_set_font(logview, monospace_font_name);
@@ -1261,6 +1136,8 @@ static void logview_window_init(LogviewWindow *logview) {
                    G_CALLBACK(findbar_text_changed_cb), logview);
   g_signal_connect(priv->find_bar, "close", G_CALLBACK(findbar_close_cb),
                    logview);
+  g_signal_connect(logview_view_get_finder(LOGVIEW_VIEW(priv->text_view)),
+                   "progress", G_CALLBACK(finder_progress_cb), logview);
 
   /* signal handlers
    * - first is used to remember/restore the window size on quit.
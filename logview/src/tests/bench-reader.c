@@ -0,0 +1,606 @@
+/* This file is part of MATE Utils.
+ *
+ * MATE Utils is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * MATE Utils is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MATE Utils.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gio/gio.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "../logview-filter-matcher.h"
+#include "../logview-filter.h"
+#include "../logview-finder.h"
+#include "../logview-log.h"
+#include "../logview-utils.h"
+
+/* Measures the reader on generated logs, syslog and ISO 8601 dated,
+ * plain and gzip compressed. Each result is printed as a JSON object on
+ * a line of its own, to be compared across releases:
+ *
+ *   load    reading the whole log, in MB/s of uncompressed text
+ *   dates   finding the days of all the lines
+ *   filter  matching all the lines against a number of filters
+ *   find    searching all the lines for a word
+ *   follow  the time from appending a line to it being read, for the
+ *           plain logs only
+ *   rss     the peak resident memory of the whole run
+ */
+
+/* about 7 days of lines, whatever the size */
+#define SPAN_SECONDS (7 * 24 * 3600)
+#define AVERAGE_LINE_LENGTH 90
+#define WRITE_CHUNK (1024 * 1024)
+#define FOLLOW_TIMEOUT 5
+
+static int size_mb = 64;
+static int n_filters = 8;
+static int n_appends = 10;
+
+typedef struct {
+  const char *format;
+  const char *compression;
+  char *path;
+
+  /* the size of the text, before compression */
+  guint64 bytes;
+
+  LogviewLog *log;
+  GError *error;
+  gboolean done;
+  gboolean got_lines;
+  gboolean reading;
+} Bench;
+
+static const char *hosts[] = {"alpha", "bravo", "charlie"};
+
+static const char *messages[] = {
+    "sshd[%u]: Accepted publickey for admin from 192.168.1.%u port 52144",
+    "sshd[%u]: Failed password for invalid user guest from 10.0.0.%u",
+    "CRON[%u]: pam_unix(cron:session): session opened for user root (%u)",
+    "kernel: [%u.%06u] EXT4-fs (sda1): mounted filesystem with ordered data",
+    "postfix/smtpd[%u]: NOQUEUE: reject: RCPT from unknown[%u]: 554 5.7.1",
+    "systemd[1]: Started Session %u of user %u.",
+    "kernel: [%u.%06u] usb 1-1: new high-speed USB device, disk attached",
+    "nginx[%u]: upstream timed out (110: Connection timed out) %u",
+    "dbus-daemon[%u]: error: connection reset by peer, serial %u",
+};
+
+/* the first n_filters are used, the ones past the end again */
+static const char *filter_patterns[] = {
+    "sshd",     "error",          "Failed password", "session opened",
+    "kernel",   "CRON\\[[0-9]+\\]", "smtpd.*reject",   "\\bdisk\\b",
+    "timed out", "[0-9]{1,3}\\.[0-9]{1,3}\\.[0-9]{1,3}\\.[0-9]{1,3}",
+};
+
+static const char *month_names[] = {"Jan", "Feb", "Mar", "Apr",
+                                    "May", "Jun", "Jul", "Aug",
+                                    "Sep", "Oct", "Nov", "Dec"};
+
+static void append_line(GString *text, gboolean iso, gint64 t, guint i) {
+  GDateTime *dt;
+  char *stamp;
+
+  dt = g_date_time_new_from_unix_local(t);
+
+  if (iso) {
+    stamp = g_date_time_format(dt, "%Y-%m-%dT%H:%M:%S%:z");
+    g_string_append(text, stamp);
+    g_free(stamp);
+  } else {
+    /* the month names of syslog are never translated */
+    g_string_append_printf(
+        text, "%s %2d %02d:%02d:%02d",
+        month_names[g_date_time_get_month(dt) - 1],
+        g_date_time_get_day_of_month(dt), g_date_time_get_hour(dt),
+        g_date_time_get_minute(dt), g_date_time_get_second(dt));
+  }
+
+  g_date_time_unref(dt);
+
+  g_string_append_printf(text, " %s ", hosts[i % G_N_ELEMENTS(hosts)]);
+  g_string_append_printf(text, messages[i % G_N_ELEMENTS(messages)],
+                         1000 + i % 30000, i % 250);
+  g_string_append_c(text, '\n');
+}
+
+static gboolean generate_log(Bench *bench, GError **error) {
+  GOutputStream *stream, *file_stream;
+  GConverter *compressor;
+  GFile *file;
+  GString *text;
+  gint64 start, step;
+  guint64 n_lines, i;
+  gboolean iso, ret = TRUE;
+
+  file = g_file_new_for_path(bench->path);
+  file_stream = G_OUTPUT_STREAM(
+      g_file_replace(file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, error));
+  g_object_unref(file);
+
+  if (file_stream == NULL) {
+    return FALSE;
+  }
+
+  if (g_strcmp0(bench->compression, "gzip") == 0) {
+    compressor = G_CONVERTER(
+        g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1));
+    stream = g_converter_output_stream_new(file_stream, compressor);
+    g_object_unref(compressor);
+    g_object_unref(file_stream);
+  } else {
+    stream = file_stream;
+  }
+
+  iso = (g_strcmp0(bench->format, "iso8601") == 0);
+  n_lines = (guint64)size_mb * 1024 * 1024 / AVERAGE_LINE_LENGTH;
+  start = g_get_real_time() / G_USEC_PER_SEC - SPAN_SECONDS;
+  step = MAX(SPAN_SECONDS / (gint64)MAX(n_lines, 1), 1);
+  text = g_string_sized_new(WRITE_CHUNK + 256);
+  bench->bytes = 0;
+
+  for (i = 0; i < n_lines && ret; i++) {
+    append_line(text, iso, start + (gint64)i * step, (guint)i);
+
+    if (text->len >= WRITE_CHUNK || i == n_lines - 1) {
+      ret = g_output_stream_write_all(stream, text->str, text->len, NULL,
+                                      NULL, error);
+      bench->bytes += text->len;
+      g_string_truncate(text, 0);
+    }
+  }
+
+  g_string_free(text, TRUE);
+
+  if (ret) {
+    ret = g_output_stream_close(stream, NULL, error);
+  }
+
+  g_object_unref(stream);
+
+  return ret;
+}
+
+/* a result, fields is the printf format of the fields particular to
+ * it; the locale is left to C, so that numbers are as JSON has them */
+static void report(Bench *bench, const char *name, const char *fields, ...) {
+  va_list args;
+  char *text;
+
+  va_start(args, fields);
+  text = g_strdup_vprintf(fields, args);
+  va_end(args);
+
+  if (bench != NULL) {
+    g_print("{\"bench\": \"%s\", \"format\": \"%s\", "
+            "\"compression\": \"%s\", \"size_mb\": %d, %s}\n",
+            name, bench->format, bench->compression, size_mb, text);
+  } else {
+    g_print("{\"bench\": \"%s\", %s}\n", name, text);
+  }
+
+  g_free(text);
+}
+
+static double seconds_since(gint64 start) {
+  return (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+}
+
+static void wait_for(gboolean *flag) {
+  while (!*flag) {
+    g_main_context_iteration(NULL, TRUE);
+  }
+}
+
+static void create_cb(LogviewLog *log, GError *error, gpointer user_data) {
+  Bench *bench = user_data;
+
+  bench->log = log;
+  bench->error = (error != NULL) ? g_error_copy(error) : NULL;
+  bench->done = TRUE;
+}
+
+static void new_lines_cb(LogviewLog *log, guint first_line, guint n_lines,
+                         GSList *new_days, GError *error, gpointer user_data) {
+  Bench *bench = user_data;
+
+  if (error != NULL && bench->error == NULL) {
+    bench->error = g_error_copy(error);
+  }
+
+  if (n_lines > 0) {
+    bench->got_lines = TRUE;
+  }
+}
+
+static void read_done(gpointer user_data) {
+  Bench *bench = user_data;
+
+  bench->done = TRUE;
+  bench->reading = FALSE;
+}
+
+static gboolean bench_load(Bench *bench) {
+  gint64 start;
+  double seconds;
+
+  start = g_get_monotonic_time();
+
+  bench->done = FALSE;
+  logview_log_create(bench->path, create_cb, bench);
+  wait_for(&bench->done);
+
+  if (bench->log == NULL) {
+    return FALSE;
+  }
+
+  bench->done = FALSE;
+  logview_log_read_new_lines_full(bench->log, NULL, new_lines_cb, read_done,
+                                  bench);
+  wait_for(&bench->done);
+
+  if (bench->error != NULL) {
+    return FALSE;
+  }
+
+  seconds = seconds_since(start);
+
+  report(bench, "load",
+         "\"lines\": %u, \"seconds\": %.6f, \"mb_per_s\": %.3f",
+         logview_log_get_cached_lines_number(bench->log), seconds,
+         bench->bytes / (1024.0 * 1024) / seconds);
+
+  return TRUE;
+}
+
+static const char *get_line(gpointer user_data, int line, gsize *len) {
+  return logview_log_get_line(user_data, (guint)line, len);
+}
+
+static void bench_dates(Bench *bench) {
+  LogviewTimestampFormat format = LOGVIEW_TIMESTAMP_UNKNOWN;
+  GSList *days;
+  gint64 start;
+  guint n_lines;
+
+  n_lines = logview_log_get_cached_lines_number(bench->log);
+  start = g_get_monotonic_time();
+
+  days = log_read_dates(get_line, bench->log, (int)n_lines,
+                        logview_log_get_timestamp(bench->log), &format);
+
+  report(bench, "dates", "\"lines\": %u, \"days\": %u, \"seconds\": %.6f",
+         n_lines, g_slist_length(days), seconds_since(start));
+
+  g_slist_free_full(days, (GDestroyNotify)logview_utils_day_free);
+}
+
+static void bench_filter(Bench *bench) {
+  LogviewFilterMatcher *matcher;
+  GList *filters = NULL;
+  gboolean *matched;
+  const char *text;
+  char *name, *converted;
+  gint64 start;
+  gsize len;
+  guint n_lines, n_matched = 0, line;
+  int i;
+
+  for (i = 0; i < n_filters; i++) {
+    name = g_strdup_printf("filter %d", i);
+    filters = g_list_append(
+        filters, logview_filter_new(
+                     name, filter_patterns[i % G_N_ELEMENTS(filter_patterns)]));
+    g_free(name);
+  }
+
+  n_lines = logview_log_get_cached_lines_number(bench->log);
+  matched = g_new(gboolean, n_filters);
+  start = g_get_monotonic_time();
+
+  /* the engine of the window splits this in chunks over threads, this
+   * is the work of a single one */
+  matcher = logview_filter_matcher_new(filters);
+  logview_log_lock_lines(bench->log);
+
+  for (line = 0; line < n_lines; line++) {
+    text = logview_log_get_line_utf8(bench->log, line, &len, &converted);
+    logview_filter_matcher_match(matcher, text, len, matched);
+    g_free(converted);
+
+    for (i = 0; i < n_filters; i++) {
+      if (matched[i]) {
+        n_matched++;
+        break;
+      }
+    }
+  }
+
+  logview_log_unlock_lines(bench->log);
+  logview_filter_matcher_unref(matcher);
+
+  report(bench, "filter",
+         "\"lines\": %u, \"filters\": %d, \"matched\": %u, "
+         "\"seconds\": %.6f",
+         n_lines, n_filters, n_matched, seconds_since(start));
+
+  g_free(matched);
+  g_list_free_full(filters, g_object_unref);
+}
+
+static void finder_progress_cb(LogviewFinder *finder, gpointer user_data) {
+  Bench *bench = user_data;
+
+  bench->done = logview_finder_is_done(finder);
+}
+
+static void bench_find(Bench *bench) {
+  LogviewFinder *finder;
+  gint64 start;
+  guint n_lines;
+
+  n_lines = logview_log_get_cached_lines_number(bench->log);
+  finder = logview_finder_new();
+  g_signal_connect(finder, "progress", G_CALLBACK(finder_progress_cb), bench);
+
+  start = g_get_monotonic_time();
+  bench->done = FALSE;
+
+  if (!logview_finder_start(finder, bench->log, "error", 0, n_lines, NULL)) {
+    g_object_unref(finder);
+    return;
+  }
+
+  if (!logview_finder_is_done(finder)) {
+    wait_for(&bench->done);
+  }
+
+  report(bench, "find", "\"lines\": %u, \"matches\": %u, \"seconds\": %.6f",
+         n_lines, logview_finder_get_n_matches(finder), seconds_since(start));
+
+  g_object_unref(finder);
+}
+
+static void log_changed_cb(LogviewLog *log, gpointer user_data) {
+  Bench *bench = user_data;
+
+  if (bench->reading) {
+    return;
+  }
+
+  bench->reading = TRUE;
+  logview_log_read_new_lines_full(log, NULL, new_lines_cb, read_done, bench);
+}
+
+static gboolean follow_timeout_cb(gpointer user_data) {
+  Bench *bench = user_data;
+
+  bench->got_lines = TRUE;
+  return FALSE;
+}
+
+static int compare_doubles(gconstpointer a, gconstpointer b) {
+  double da = *(const double *)a, db = *(const double *)b;
+
+  return (da > db) - (da < db);
+}
+
+/* the log is followed through its file monitor, as in the window */
+static void bench_follow(Bench *bench) {
+  GArray *latencies;
+  GString *text;
+  gulong changed_id;
+  guint timeout_id, i;
+  gint64 start;
+  double latency;
+  FILE *file;
+
+  latencies = g_array_new(FALSE, FALSE, sizeof(double));
+  text = g_string_new(NULL);
+  changed_id = g_signal_connect(bench->log, "log-changed",
+                                G_CALLBACK(log_changed_cb), bench);
+
+  for (i = 0; i < (guint)n_appends; i++) {
+    /* let the read of the previous line finish */
+    while (bench->reading) {
+      g_main_context_iteration(NULL, TRUE);
+    }
+
+    g_string_truncate(text, 0);
+    append_line(text, g_strcmp0(bench->format, "iso8601") == 0,
+                g_get_real_time() / G_USEC_PER_SEC, i);
+
+    if ((file = fopen(bench->path, "a")) == NULL) {
+      break;
+    }
+
+    bench->got_lines = FALSE;
+    start = g_get_monotonic_time();
+
+    fwrite(text->str, 1, text->len, file);
+    fclose(file);
+
+    timeout_id = g_timeout_add_seconds(FOLLOW_TIMEOUT, follow_timeout_cb,
+                                       bench);
+    wait_for(&bench->got_lines);
+    latency = seconds_since(start);
+
+    if (latency >= FOLLOW_TIMEOUT) {
+      /* the line was missed */
+      break;
+    }
+
+    g_source_remove(timeout_id);
+    g_array_append_val(latencies, latency);
+  }
+
+  g_signal_handler_disconnect(bench->log, changed_id);
+
+  if (latencies->len > 0) {
+    g_array_sort(latencies, compare_doubles);
+
+    report(bench, "follow",
+           "\"appends\": %u, \"min_seconds\": %.6f, "
+           "\"median_seconds\": %.6f, \"max_seconds\": %.6f",
+           latencies->len, g_array_index(latencies, double, 0),
+           g_array_index(latencies, double, latencies->len / 2),
+           g_array_index(latencies, double, latencies->len - 1));
+  }
+
+  if (i < (guint)n_appends) {
+    g_printerr("follow: the appended line %u wasn't read\n", i);
+  }
+
+  g_string_free(text, TRUE);
+  g_array_free(latencies, TRUE);
+}
+
+/* the directory and what the index cache wrote in it */
+static void remove_dir(const char *dir) {
+  const char *name;
+  char *path;
+  GDir *d;
+
+  if ((d = g_dir_open(dir, 0, NULL)) != NULL) {
+    while ((name = g_dir_read_name(d)) != NULL) {
+      path = g_build_filename(dir, name, NULL);
+
+      if (g_file_test(path, G_FILE_TEST_IS_DIR)) {
+        remove_dir(path);
+      } else {
+        g_unlink(path);
+      }
+
+      g_free(path);
+    }
+
+    g_dir_close(d);
+  }
+
+  g_rmdir(dir);
+}
+
+static gboolean run_bench(Bench *bench, const char *dir) {
+  GError *error = NULL;
+  char *name;
+
+  name = g_strdup_printf("%s.log%s", bench->format,
+                         g_strcmp0(bench->compression, "gzip") == 0 ? ".gz"
+                                                                    : "");
+  bench->path = g_build_filename(dir, name, NULL);
+  g_free(name);
+
+  if (!generate_log(bench, &error)) {
+    g_printerr("can't write %s: %s\n", bench->path, error->message);
+    g_error_free(error);
+    return FALSE;
+  }
+
+  if (!bench_load(bench)) {
+    g_printerr("can't read %s: %s\n", bench->path,
+               bench->error != NULL ? bench->error->message : "");
+    return FALSE;
+  }
+
+  bench_dates(bench);
+  bench_filter(bench);
+  bench_find(bench);
+
+  /* compressed logs are not expected to grow */
+  if (g_strcmp0(bench->compression, "none") == 0 && n_appends > 0) {
+    bench_follow(bench);
+  }
+
+  return TRUE;
+}
+
+int main(int argc, char **argv) {
+  const char *formats[] = {"syslog", "iso8601"};
+  const char *compressions[] = {"none", "gzip"};
+  GError *error = NULL;
+  GOptionContext *context;
+  struct rusage usage;
+  Bench bench;
+  char *dir;
+  gboolean ok = TRUE;
+  guint i, j;
+  GOptionEntry entries[] = {
+      {"size", 's', 0, G_OPTION_ARG_INT, &size_mb,
+       "The size of the generated logs, in MB (64)", "MB"},
+      {"filters", 'n', 0, G_OPTION_ARG_INT, &n_filters,
+       "The number of filters to match the lines against (8)", "N"},
+      {"appends", 'a', 0, G_OPTION_ARG_INT, &n_appends,
+       "The number of lines appended to measure following a log (10)",
+       "N"},
+      {NULL}};
+
+  context = g_option_context_new(NULL);
+  g_option_context_add_main_entries(context, entries, NULL);
+
+  if (!g_option_context_parse(context, &argc, &argv, &error) || size_mb <= 0 ||
+      n_filters <= 0 || n_appends < 0) {
+    if (error) {
+      g_printerr("%s\n", error->message);
+      g_error_free(error);
+    }
+
+    g_option_context_free(context);
+    return 1;
+  }
+
+  g_option_context_free(context);
+
+  /* a new directory each time, so that no index cache is reused; the
+   * cache goes there too instead of the user's, before GLib reads it */
+  dir = g_dir_make_tmp("bench-reader-XXXXXX", &error);
+  if (dir == NULL) {
+    g_printerr("%s\n", error->message);
+    g_error_free(error);
+    return 1;
+  }
+
+  g_setenv("XDG_CACHE_HOME", dir, TRUE);
+
+  for (i = 0; i < G_N_ELEMENTS(formats) && ok; i++) {
+    for (j = 0; j < G_N_ELEMENTS(compressions) && ok; j++) {
+      memset(&bench, 0, sizeof(bench));
+      bench.format = formats[i];
+      bench.compression = compressions[j];
+
+      ok = run_bench(&bench, dir);
+
+      g_clear_object(&bench.log);
+      g_clear_error(&bench.error);
+      g_unlink(bench.path);
+      g_free(bench.path);
+    }
+  }
+
+  /* ru_maxrss is in kilobytes on Linux */
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    report(NULL, "rss", "\"peak_kb\": %ld", usage.ru_maxrss);
+  }
+
+  remove_dir(dir);
+  g_free(dir);
+
+  return ok ? 0 : 1;
+}
@@ -26,20 +26,25 @@
 
 static GMainLoop *loop;
 
-static void new_lines_cb(LogviewLog *log, const char **lines, GSList *new_days,
-                         GError *error, gpointer user_data) {
-  int i;
-  guint8 day;
+static const char *get_line(gpointer user_data, int line, gsize *len) {
+  return logview_log_get_line(user_data, line, len);
+}
+
+/* batches of a long log come before the end of the read */
+static gboolean quit_if_loaded(gpointer user_data) {
+  LogviewLog *log = user_data;
   Day *day_s;
   GSList *days, *l;
 
-  for (i = 0; lines[i]; i++) {
-    g_print("line %d: %s\n", i, lines[i]);
+  if (!logview_log_is_loaded(log)) {
+    return FALSE;
   }
+
   g_print("outside read, lines no %u\n",
           logview_log_get_cached_lines_number(log));
 
-  days = log_read_dates(lines, logview_log_get_timestamp(log));
+  days = log_read_dates(get_line, log, logview_log_get_cached_lines_number(log),
+                        logview_log_get_timestamp(log), NULL);
   g_print("\ndays %p\n", days);
 
   for (l = days; l; l = l->next) {
@@ -48,9 +53,32 @@ static void new_lines_cb(LogviewLog *log, const char **lines, GSList *new_days,
             g_date_get_month(day_s->date));
   }
 
+  g_slist_free_full(days, (GDestroyNotify)logview_utils_day_free);
   g_object_unref(log);
 
   g_main_loop_quit(loop);
+
+  return FALSE;
+}
+
+static void new_lines_cb(LogviewLog *log, guint first_line, guint n_lines,
+                         GSList *new_days, GError *error, gpointer user_data) {
+  guint i;
+  const char *line;
+  gsize len;
+
+  if (error != NULL) {
+    g_printerr("error: %s\n", error->message);
+    g_main_loop_quit(loop);
+    return;
+  }
+
+  for (i = first_line; i < first_line + n_lines; i++) {
+    line = logview_log_get_line(log, i, &len);
+    g_print("line %u: %.*s\n", i, (int)len, line);
+  }
+
+  g_idle_add(quit_if_loaded, log);
 }
 
 static void callback(LogviewLog *log, GError *error, gpointer user_data) {